@@ -9,6 +9,8 @@ SRC += $(wildcard $(CMSIS3_DSPLIB_DIR)Source/*/*.c)
 else
 SRC += $(CMSIS3_DSPLIB_DIR)/Source/TransformFunctions/arm_cfft_radix4_init_q15.c
 SRC += $(CMSIS3_DSPLIB_DIR)/Source/TransformFunctions/arm_cfft_radix4_q15.c
+SRC += $(CMSIS3_DSPLIB_DIR)/Source/TransformFunctions/arm_rfft_init_q15.c
+SRC += $(CMSIS3_DSPLIB_DIR)/Source/TransformFunctions/arm_rfft_q15.c
 SRC += $(CMSIS3_DSPLIB_DIR)/Source/BasicMathFunctions/arm_shift_q15.c
 SRC += $(CMSIS3_DSPLIB_DIR)/Source/ComplexMathFunctions/arm_cmplx_mag_q15.c
 SRC += $(CMSIS3_DSPLIB_DIR)/Source/FastMathFunctions/arm_sqrt_q15.c
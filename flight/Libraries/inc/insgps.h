@@ -46,10 +46,54 @@
 
 #define FULL_SENSORS 0x3FF
 
+#define INSGPS_NUMX 13	// number of states
+#define INSGPS_NUMW 9	// number of plant noise inputs
+#define INSGPS_NUMV 10	// number of measurements
+
 /**
   * @}
   */
 
+/**
+ * Everything one filter keeps between updates. The insgps_* functions run
+ * the filter on an instance so several can exist side by side, for example
+ * when replaying logs on the host. The INS* functions run a single default
+ * instance.
+ */
+struct insgps_state {
+	float F[INSGPS_NUMX][INSGPS_NUMX];	// linearized system matrices
+	float G[INSGPS_NUMX][INSGPS_NUMW];
+	float H[INSGPS_NUMV][INSGPS_NUMX];
+	float Be[3];				// local magnetic unit vector in NED frame
+	float P[INSGPS_NUMX][INSGPS_NUMX];	// covariance matrix
+	float X[INSGPS_NUMX];			// state vector
+	float Q[INSGPS_NUMW];			// input noise variances
+	float R[INSGPS_NUMV];			// measurement noise variances
+	float K[INSGPS_NUMX][INSGPS_NUMV];	// feedback gain matrix
+};
+
+/****************************************************/
+/**  Running a filter instance                     **/
+/****************************************************/
+
+void insgps_init(struct insgps_state *ins);
+void insgps_state_prediction(struct insgps_state *ins, const float gyro_data[3], const float accel_data[3], float dT);
+void insgps_covariance_prediction(struct insgps_state *ins, float dT);
+void insgps_correction(struct insgps_state *ins, const float mag_data[3], const float Pos[3], const float Vel[3], float BaroAlt, uint16_t SensorsUsed);
+void insgps_get_state(const struct insgps_state *ins, float *pos, float *vel, float *attitude, float *bias);
+void insgps_get_variance(const struct insgps_state *ins, float *p);
+
+void insgps_reset_p(struct insgps_state *ins, const float PDiag[INSGPS_NUMX]);
+void insgps_set_state(struct insgps_state *ins, const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3]);
+void insgps_set_pos_vel_var(struct insgps_state *ins, float PosVar, float VelVar, float VertPosVar);
+void insgps_set_gyro_bias(struct insgps_state *ins, const float gyro_bias[3]);
+void insgps_set_accel_var(struct insgps_state *ins, const float accel_var[3]);
+void insgps_set_gyro_var(struct insgps_state *ins, const float gyro_var[3]);
+void insgps_set_mag_north(struct insgps_state *ins, const float B[3]);
+void insgps_set_mag_var(struct insgps_state *ins, const float scaled_mag_var[3]);
+void insgps_set_baro_var(struct insgps_state *ins, float baro_var);
+void insgps_pos_vel_reset(struct insgps_state *ins, const float pos[3], const float vel[3]);
+
 /****************************************************/
 /**  Main interface for running the filter         **/
 /****************************************************/
@@ -91,7 +135,7 @@ void MagVelBaroCorrection(const float mag_data[3], const float Vel[3], float Bar
 void FullCorrection(const float mag_data[3], const float Pos[3], const float Vel[3],
 		    float BaroAlt);
 void GpsBaroCorrection(const float Pos[3], const float Vel[3], float BaroAlt);
-void GpsMagCorrection(const float mag_data[3], const float Pos[3], const float Vel[2]);
+void GpsMagCorrection(const float mag_data[3], const float Pos[3], const float Vel[3]);
 void VelBaroCorrection(const float Vel[3], float BaroAlt);
 
 uint16_t ins_get_num_states();
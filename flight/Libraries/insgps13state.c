@@ -33,9 +33,9 @@
 #include <stdint.h>
 
 // constants/macros/typdefs
-#define NUMX 13			// number of states, X is the state vector
-#define NUMW 9			// number of plant noise inputs, w is disturbance noise vector
-#define NUMV 10			// number of measurements, v is the measurement noise vector
+#define NUMX INSGPS_NUMX	// number of states, X is the state vector
+#define NUMW INSGPS_NUMW	// number of plant noise inputs, w is disturbance noise vector
+#define NUMV INSGPS_NUMV	// number of measurements, v is the measurement noise vector
 #define NUMU 6			// number of deterministic inputs, U is the input vector
 
 #if defined(GENERAL_COV)
@@ -49,7 +49,7 @@ static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 			  float Q[NUMW], float dT, float P[NUMX][NUMX]);
 static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
-		  uint16_t SensorsUsed);
+		  float K[NUMX][NUMV], uint16_t SensorsUsed);
 static void RungeKutta(float X[NUMX], float U[NUMU], float dT);
 static void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX]);
 static void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
@@ -58,11 +58,7 @@ static void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
 static void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
 
 // Private variables
-static float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
-static float Be[3];	                    // local magnetic unit vector in NED frame
-static float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
-static float Q[NUMW], R[NUMV];   // input noise and measurement noise variances
-static float K[NUMX][NUMV];	     // feedback gain matrix
+static struct insgps_state ins_default;	// filter run by the INS* functions
 
 //  *************  Exposed Functions ****************
 //  *************************************************
@@ -72,24 +68,29 @@ uint16_t ins_get_num_states()
 	return NUMX;
 }
 
-void INSGPSInit()		//pretty much just a place holder for now
+void insgps_init(struct insgps_state *ins)
 {
-	Be[0] = 1.0f;
-	Be[1] = 0.0f;
-	Be[2] = 0.0f;		// local magnetic unit vector
+	float (*P)[NUMX] = ins->P;
+	float *X = ins->X;
+	float *Q = ins->Q;
+	float *R = ins->R;
+
+	ins->Be[0] = 1.0f;
+	ins->Be[1] = 0.0f;
+	ins->Be[2] = 0.0f;		// local magnetic unit vector
 
 	for (int i = 0; i < NUMX; i++) {
 		for (int j = 0; j < NUMX; j++) {
 			P[i][j] = 0.0f; // zero all terms
-			F[i][j] = 0.0f;
+			ins->F[i][j] = 0.0f;
 		}
 		
 		for (int j = 0; j < NUMW; j++)
-			G[i][j] = 0.0f;
+			ins->G[i][j] = 0.0f;
 			
 		for (int j = 0; j < NUMV; j++) {
-			H[j][i] = 0.0f;
-			K[i][j] = 0.0f;
+			ins->H[j][i] = 0.0f;
+			ins->K[i][j] = 0.0f;
 		}
 			
 		X[i] = 0.0f;
@@ -124,13 +125,16 @@ void INSGPSInit()		//pretty much just a place holder for now
 
 /**
  * Get the current state estimate (null input skips that get)
+ * @param[in] ins The filter
  * @param[out] pos The position in NED space (m)
  * @param[out] vel The velocity in NED (m/s)
  * @param[out] attitude Quaternion representation of attitude
  * @param[out] gyros_bias Estimate of gyro bias (rad/s)
  */
-void INSGetState(float *pos, float *vel, float *attitude, float *gyro_bias)
+void insgps_get_state(const struct insgps_state *ins, float *pos, float *vel, float *attitude, float *gyro_bias)
 {
+	const float *X = ins->X;
+
 	if (pos) {
 		pos[0] = X[0];
 		pos[1] = X[1];
@@ -159,16 +163,18 @@ void INSGetState(float *pos, float *vel, float *attitude, float *gyro_bias)
 
 /**
  * Get the variance, for visualizing the filter performance
+ * @param[in] ins The filter
  * @param[out var_out The variances
  */
-void INSGetVariance(float *var_out)
+void insgps_get_variance(const struct insgps_state *ins, float *var_out)
 {
 	for (uint32_t i = 0; i < NUMX; i++)
-		var_out[i] = P[i][i];
+		var_out[i] = ins->P[i][i];
 }
 
-void INSResetP(const float PDiag[NUMX])
+void insgps_reset_p(struct insgps_state *ins, const float PDiag[NUMX])
 {
+	float (*P)[NUMX] = ins->P;
 	uint8_t i,j;
 
 	// if PDiag[i] nonzero then clear row and column and set diagonal element
@@ -181,8 +187,10 @@ void INSResetP(const float PDiag[NUMX])
 	}
 }
 
-void INSSetState(const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3])
+void insgps_set_state(struct insgps_state *ins, const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3])
 {
+	float *X = ins->X;
+
 	/* Note: accel_bias not used in 13 state INS */
 	X[0] = pos[0];
 	X[1] = pos[1];
@@ -199,8 +207,11 @@ void INSSetState(const float pos[3], const float vel[3], const float q[4], const
 	X[12] = gyro_bias[2];
 }
 
-void INSPosVelReset(const float pos[3], const float vel[3]) 
+void insgps_pos_vel_reset(struct insgps_state *ins, const float pos[3], const float vel[3]) 
 {
+	float (*P)[NUMX] = ins->P;
+	float *X = ins->X;
+
 	for (int i = 0; i < 6; i++) {
 		for(int j = i; j < NUMX; j++) {
 			P[i][j] = 0;  // zero the first 6 rows and columns
@@ -219,59 +230,60 @@ void INSPosVelReset(const float pos[3], const float vel[3])
 	X[5] = vel[2];	
 }
 
-void INSSetPosVelVar(float PosVar, float VelVar, float VertPosVar)
+void insgps_set_pos_vel_var(struct insgps_state *ins, float PosVar, float VelVar, float VertPosVar)
 {
-	R[0] = PosVar;
-	R[1] = PosVar;
-	R[2] = VertPosVar;
-	R[3] = VelVar;
-	R[4] = VelVar;
-	R[5] = VelVar;
+	ins->R[0] = PosVar;
+	ins->R[1] = PosVar;
+	ins->R[2] = VertPosVar;
+	ins->R[3] = VelVar;
+	ins->R[4] = VelVar;
+	ins->R[5] = VelVar;
 }
 
-void INSSetGyroBias(const float gyro_bias[3])
+void insgps_set_gyro_bias(struct insgps_state *ins, const float gyro_bias[3])
 {
-	X[10] = gyro_bias[0];
-	X[11] = gyro_bias[1];
-	X[12] = gyro_bias[2];
+	ins->X[10] = gyro_bias[0];
+	ins->X[11] = gyro_bias[1];
+	ins->X[12] = gyro_bias[2];
 }
 
-void INSSetAccelVar(const float accel_var[3])
+void insgps_set_accel_var(struct insgps_state *ins, const float accel_var[3])
 {
-	Q[3] = accel_var[0];
-	Q[4] = accel_var[1];
-	Q[5] = accel_var[2];
+	ins->Q[3] = accel_var[0];
+	ins->Q[4] = accel_var[1];
+	ins->Q[5] = accel_var[2];
 }
 
-void INSSetGyroVar(const float gyro_var[3])
+void insgps_set_gyro_var(struct insgps_state *ins, const float gyro_var[3])
 {
-	Q[0] = gyro_var[0];
-	Q[1] = gyro_var[1];
-	Q[2] = gyro_var[2];
+	ins->Q[0] = gyro_var[0];
+	ins->Q[1] = gyro_var[1];
+	ins->Q[2] = gyro_var[2];
 }
 
-void INSSetMagVar(const float scaled_mag_var[3])
+void insgps_set_mag_var(struct insgps_state *ins, const float scaled_mag_var[3])
 {
-	R[6] = scaled_mag_var[0];
-	R[7] = scaled_mag_var[1];
-	R[8] = scaled_mag_var[2];
+	ins->R[6] = scaled_mag_var[0];
+	ins->R[7] = scaled_mag_var[1];
+	ins->R[8] = scaled_mag_var[2];
 }
 
-void INSSetBaroVar(const float baro_var)
+void insgps_set_baro_var(struct insgps_state *ins, const float baro_var)
 {
-	R[9] = baro_var;
+	ins->R[9] = baro_var;
 }
 
-void INSSetMagNorth(const float B[3])
+void insgps_set_mag_north(struct insgps_state *ins, const float B[3])
 {
 	float mag = sqrtf(B[0] * B[0] + B[1] * B[1] + B[2] * B[2]);
-	Be[0] = B[0] / mag;
-	Be[1] = B[1] / mag;
-	Be[2] = B[2] / mag;
+	ins->Be[0] = B[0] / mag;
+	ins->Be[1] = B[1] / mag;
+	ins->Be[2] = B[2] / mag;
 }
 
-void INSStatePrediction(const float gyro_data[3], const float accel_data[3], float dT)
+void insgps_state_prediction(struct insgps_state *ins, const float gyro_data[3], const float accel_data[3], float dT)
 {
+	float *X = ins->X;
 	float U[6];
 	float qmag;
 
@@ -286,7 +298,7 @@ void INSStatePrediction(const float gyro_data[3], const float accel_data[3], flo
 	U[5] = accel_data[2];
 
 	// EKF prediction step
-	LinearizeFG(X, U, F, G);
+	LinearizeFG(X, U, ins->F, ins->G);
 	RungeKutta(X, U, dT);
 	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
 	X[6] /= qmag;
@@ -296,9 +308,133 @@ void INSStatePrediction(const float gyro_data[3], const float accel_data[3], flo
 	//CovariancePrediction(F,G,Q,dT,P);
 }
 
+void insgps_covariance_prediction(struct insgps_state *ins, float dT)
+{
+	CovariancePrediction(ins->F, ins->G, ins->Q, dT, ins->P);
+}
+
+void insgps_correction(struct insgps_state *ins, const float mag_data[3], const float Pos[3], const float Vel[3],
+		   float BaroAlt, uint16_t SensorsUsed)
+{
+	float *X = ins->X;
+	float Z[10], Y[10];
+	float Bmag, qmag;
+
+	// GPS Position in meters and in local NED frame
+	Z[0] = Pos[0];
+	Z[1] = Pos[1];
+	Z[2] = Pos[2];
+
+	// GPS Velocity in meters and in local NED frame
+	Z[3] = Vel[0];
+	Z[4] = Vel[1];
+	Z[5] = Vel[2];
+
+	// magnetometer data in any units (use unit vector) and in body frame
+	Bmag =
+	    sqrtf(mag_data[0] * mag_data[0] + mag_data[1] * mag_data[1] +
+		 mag_data[2] * mag_data[2]);
+	Z[6] = mag_data[0] / Bmag;
+	Z[7] = mag_data[1] / Bmag;
+	Z[8] = mag_data[2] / Bmag;
+
+	// barometric altimeter in meters and in local NED frame
+	Z[9] = BaroAlt;
+
+	// EKF correction step
+	LinearizeH(X, ins->Be, ins->H);
+	MeasurementEq(X, ins->Be, Y);
+	SerialUpdate(ins->H, ins->R, Z, Y, ins->P, X, ins->K, SensorsUsed);
+	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
+	X[6] /= qmag;
+	X[7] /= qmag;
+	X[8] /= qmag;
+	X[9] /= qmag;
+}
+
+//  *************  Default Instance *****************
+//  The original single filter interface, kept for the flight code
+//  *************************************************
+
+void INSGPSInit()		//pretty much just a place holder for now
+{
+	insgps_init(&ins_default);
+}
+
+void INSGetState(float *pos, float *vel, float *attitude, float *gyro_bias)
+{
+	insgps_get_state(&ins_default, pos, vel, attitude, gyro_bias);
+}
+
+void INSGetVariance(float *var_out)
+{
+	insgps_get_variance(&ins_default, var_out);
+}
+
+void INSResetP(const float PDiag[NUMX])
+{
+	insgps_reset_p(&ins_default, PDiag);
+}
+
+void INSSetState(const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3])
+{
+	insgps_set_state(&ins_default, pos, vel, q, gyro_bias, accel_bias);
+}
+
+void INSPosVelReset(const float pos[3], const float vel[3]) 
+{
+	insgps_pos_vel_reset(&ins_default, pos, vel);
+}
+
+void INSSetPosVelVar(float PosVar, float VelVar, float VertPosVar)
+{
+	insgps_set_pos_vel_var(&ins_default, PosVar, VelVar, VertPosVar);
+}
+
+void INSSetGyroBias(const float gyro_bias[3])
+{
+	insgps_set_gyro_bias(&ins_default, gyro_bias);
+}
+
+void INSSetAccelVar(const float accel_var[3])
+{
+	insgps_set_accel_var(&ins_default, accel_var);
+}
+
+void INSSetGyroVar(const float gyro_var[3])
+{
+	insgps_set_gyro_var(&ins_default, gyro_var);
+}
+
+void INSSetMagVar(const float scaled_mag_var[3])
+{
+	insgps_set_mag_var(&ins_default, scaled_mag_var);
+}
+
+void INSSetBaroVar(const float baro_var)
+{
+	insgps_set_baro_var(&ins_default, baro_var);
+}
+
+void INSSetMagNorth(const float B[3])
+{
+	insgps_set_mag_north(&ins_default, B);
+}
+
+void INSStatePrediction(const float gyro_data[3], const float accel_data[3], float dT)
+{
+	insgps_state_prediction(&ins_default, gyro_data, accel_data, dT);
+}
+
 void INSCovariancePrediction(float dT)
 {
-	CovariancePrediction(F, G, Q, dT, P);
+	insgps_covariance_prediction(&ins_default, dT);
+}
+
+void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3],
+		   float BaroAlt, uint16_t SensorsUsed)
+{
+	insgps_correction(&ins_default, mag_data, Pos, Vel, BaroAlt, SensorsUsed);
 }
 
 float zeros[3] = { 0, 0, 0 };
@@ -339,44 +475,6 @@ void VelBaroCorrection(const float Vel[3], float BaroAlt)
 		      HORIZ_SENSORS | VERT_SENSORS | BARO_SENSOR);
 }
 
-void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3],
-		   float BaroAlt, uint16_t SensorsUsed)
-{
-	float Z[10], Y[10];
-	float Bmag, qmag;
-
-	// GPS Position in meters and in local NED frame
-	Z[0] = Pos[0];
-	Z[1] = Pos[1];
-	Z[2] = Pos[2];
-
-	// GPS Velocity in meters and in local NED frame
-	Z[3] = Vel[0];
-	Z[4] = Vel[1];
-	Z[5] = Vel[2];
-
-	// magnetometer data in any units (use unit vector) and in body frame
-	Bmag =
-	    sqrtf(mag_data[0] * mag_data[0] + mag_data[1] * mag_data[1] +
-		 mag_data[2] * mag_data[2]);
-	Z[6] = mag_data[0] / Bmag;
-	Z[7] = mag_data[1] / Bmag;
-	Z[8] = mag_data[2] / Bmag;
-
-	// barometric altimeter in meters and in local NED frame
-	Z[9] = BaroAlt;
-
-	// EKF correction step
-	LinearizeH(X, Be, H);
-	MeasurementEq(X, Be, Y);
-	SerialUpdate(H, R, Z, Y, P, X, SensorsUsed);
-	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
-	X[6] /= qmag;
-	X[7] /= qmag;
-	X[8] /= qmag;
-	X[9] /= qmag;
-}
-
 //  *************  CovariancePrediction *************
 //  Does the prediction step of the Kalman filter for the covariance matrix
 //  Output, Pnew, overwrites P, the input covariance
@@ -1359,7 +1457,7 @@ static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 //  Does the update step of the Kalman filter for the covariance and estimate
 //  Outputs are Xnew & Pnew, and are written over P and X
 //  Z is actual measurement, Y is predicted measurement
-//  Xnew = X + K*(Z-Y), Pnew=(I-K*H)*P,
+//  Xnew = X + K*(Z-Y), Pnew=(I-K*H)*P*(I-K*H)' + K*R*K',
 //    where K=P*H'*inv[H*P*H'+R]
 //  NOTE the algorithm assumes R (measurement covariance matrix) is diagonal
 //    i.e. the measurment noises are uncorrelated.
@@ -1371,39 +1469,68 @@ static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 //     should be used in the update.
 //  ************************************************
 
-static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
-		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
-		  uint16_t SensorsUsed)
+//  Updates P and X with measurement m, whose row of H is zero outside of
+//    columns first to first+count-1. The callers pass constant ranges so each
+//    sensor gets a copy where H*P and H*P*H' only visit those columns.
+//  The covariance uses the Joseph form. For a single measurement with
+//    HPHR = H*P*H'+R it expands to Pnew = P - K*HP - E*K', with E = HP'-K*HPHR.
+//    E is zero in exact arithmetic; keeping it makes the rounding symmetric and
+//    stops it from eating away the positive definiteness of P.
+__attribute__((always_inline)) static inline void MeasurementUpdate(float H[NUMX],
+		  uint8_t first, uint8_t count, float R, float Error,
+		  float P[NUMX][NUMX], float X[NUMX], float K[NUMX][NUMV], uint8_t m)
 {
-	float HP[NUMX], HPHR, Error;
-	uint8_t i, j, k, m;
+	float HP[NUMX], HPHR, E[NUMX];
+	uint8_t i, j, k;
 
-	for (m = 0; m < NUMV; m++) {
+	for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
+		HP[j] = 0;
+		for (k = first; k < first + count; k++)
+			HP[j] += H[k] * P[k][j];
+	}
+	HPHR = R;		// Find  HPHR = H*P*H' + R
+	for (k = first; k < first + count; k++)
+		HPHR += HP[k] * H[k];
 
-		if (SensorsUsed & (0x01 << m)) {	// use this sensor for update
+	for (k = 0; k < NUMX; k++) {
+		K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
+		E[k] = HP[k] - K[k][m] * HPHR;
+	}
 
-			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
-				HP[j] = 0;
-				for (k = 0; k < NUMX; k++)
-					HP[j] += H[m][k] * P[k][j];
-			}
-			HPHR = R[m];	// Find  HPHR = H*P*H' + R
-			for (k = 0; k < NUMX; k++)
-				HPHR += HP[k] * H[m][k];
+	for (i = 0; i < NUMX; i++) {	// Find P(m)= P(m-1) - K*HP - E*K'
+		for (j = i; j < NUMX; j++)
+			P[i][j] = P[j][i] =
+			    P[i][j] - K[i][m] * HP[j] - E[i] * K[j][m];
+	}
 
-			for (k = 0; k < NUMX; k++)
-				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
+	for (i = 0; i < NUMX; i++)	// Find X(m)= X(m-1) + K*Error
+		X[i] = X[i] + K[i][m] * Error;
+}
 
-			for (i = 0; i < NUMX; i++) {	// Find P(m)= P(m-1) + K*HP
-				for (j = i; j < NUMX; j++)
-					P[i][j] = P[j][i] =
-					    P[i][j] - K[i][m] * HP[j];
-			}
+static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
+		  float K[NUMX][NUMV], uint16_t SensorsUsed)
+{
+	uint8_t m;
 
-			Error = Z[m] - Y[m];
-			for (i = 0; i < NUMX; i++)	// Find X(m)= X(m-1) + K*Error
-				X[i] = X[i] + K[i][m] * Error;
+	for (m = 0; m < NUMV; m++) {
 
+		if (!(SensorsUsed & (0x01 << m)))	// use this sensor for update
+			continue;
+
+		switch (m) {
+		case 0: case 1: case 2: case 3: case 4: case 5:
+			// GPS position and velocity observe their own state
+			MeasurementUpdate(H[m], m, 1, R[m], Z[m] - Y[m], P, X, K, m);
+			break;
+		case 6: case 7: case 8:
+			// The body frame field only depends on the attitude
+			MeasurementUpdate(H[m], 6, 4, R[m], Z[m] - Y[m], P, X, K, m);
+			break;
+		case 9:
+			// Altitude is minus the down position
+			MeasurementUpdate(H[m], 2, 1, R[m], Z[m] - Y[m], P, X, K, m);
+			break;
 		}
 	}
 }
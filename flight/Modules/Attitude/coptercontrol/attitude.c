@@ -72,6 +72,8 @@ static void AttitudeTask(void *parameters);
 
 static float gyro_correct_int[3] = {0,0,0};
 static xQueueHandle gyro_queue;
+static struct pios_sensor_channel *gyro_channel;
+static struct pios_sensor_channel *accel_channel;
 
 static int32_t updateSensors(AccelsData *, GyrosData *);
 static int32_t updateSensorsCC3D(AccelsData * accelsData, GyrosData * gyrosData);
@@ -200,6 +202,13 @@ static void AttitudeTask(void *parameters)
 		PIOS_Assert(gyro_queue != NULL);
 		PIOS_ADC_SetQueue(PIOS_INTERNAL_ADC,gyro_queue);
 #endif
+	} else {
+		// Batched sensors are averaged over each run of the loop, which
+		// runs once per burst
+		if (PIOS_SENSORS_IsBatched(PIOS_SENSOR_GYRO))
+			gyro_channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 16, PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_GYRO));
+		if (PIOS_SENSORS_IsBatched(PIOS_SENSOR_ACCEL))
+			accel_channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_ACCEL, 16, PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_ACCEL));
 	}
 
 	// Force settings update to make sure rotation loaded
@@ -384,21 +393,34 @@ static int32_t updateSensorsCC3D(AccelsData * accelsData, GyrosData * gyrosData)
 {
 	struct pios_sensor_gyro_data gyros;
 	struct pios_sensor_accel_data accels;
+	struct pios_sensor_sample sample;
 	xQueueHandle queue;
 
-	queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
-	if(queue == NULL || xQueueReceive(queue, (void *) &gyros, 4) == errQUEUE_EMPTY) {
-		return-1;
+	if (gyro_channel != NULL) {
+		if (PIOS_SENSORS_DrainAverage(gyro_channel, &sample, 4) == 0)
+			return -1;
+		gyros = sample.gyro;
+	} else {
+		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
+		if(queue == NULL || xQueueReceive(queue, (void *) &gyros, 4) == errQUEUE_EMPTY) {
+			return-1;
+		}
 	}
 
 	// As it says below, because the rest of the code expects the accel to be ready when
 	// the gyro is we must block here too
-	queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
-	if(queue == NULL || xQueueReceive(queue, (void *) &accels, 1) == errQUEUE_EMPTY) {
-		return -1;
+	if (accel_channel != NULL) {
+		if (PIOS_SENSORS_DrainAverage(accel_channel, &sample, 1) == 0)
+			return -1;
+		accels = sample.accel;
+	} else {
+		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
+		if(queue == NULL || xQueueReceive(queue, (void *) &accels, 1) == errQUEUE_EMPTY) {
+			return -1;
+		}
 	}
-	else
-		update_accels(&accels, accelsData);
+
+	update_accels(&accels, accelsData);
 
 	// Update gyros after the accels since the rest of the code expects
 	// the accels to be available first
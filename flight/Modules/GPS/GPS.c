@@ -66,6 +66,7 @@ static void setHomeLocation(GPSPositionData * gpsData);
 
 #define GPS_TIMEOUT_MS                  500
 #define GPS_COM_TIMEOUT_MS              100
+#define GPS_READ_BUFFER_LEN             64
 
 
 #ifdef PIOS_GPS_SETS_HOMELOCATION
@@ -90,6 +91,7 @@ static bool module_enabled = false;
 static xTaskHandle gpsTaskHandle;
 
 static char* gps_rx_buffer;
+static uint8_t* gps_read_buffer;
 
 static uint32_t timeOfLastCommandMs;
 static uint32_t timeOfLastUpdateMs;
@@ -183,6 +185,9 @@ int32_t GPSInitialize(void)
 		}
 		PIOS_Assert(gps_rx_buffer);
 
+		gps_read_buffer = pvPortMalloc(GPS_READ_BUFFER_LEN);
+		PIOS_Assert(gps_read_buffer);
+
 		return 0;
 	}
 
@@ -217,21 +222,22 @@ static void gpsTask(void *parameters)
 	// Loop forever
 	while (1)
 	{
-		uint8_t c;
+		uint16_t len;
 
-		// This blocks the task until there is something on the buffer
-		while (PIOS_COM_ReceiveBuffer(gpsPort, &c, 1, xDelay) > 0)
+		// This blocks the task until there is something on the buffer.
+		// Each read is handed to the parser in one go.
+		while ((len = PIOS_COM_ReceiveBuffer(gpsPort, gps_read_buffer, GPS_READ_BUFFER_LEN, xDelay)) > 0)
 		{
 			int res;
 			switch (gpsProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
-					res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_nmea_buffer((char *)gps_read_buffer, len, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
-					res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_ubx_buffer(gps_read_buffer, len, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 				default:
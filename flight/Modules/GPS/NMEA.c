@@ -107,86 +107,99 @@ const static struct nmea_parser nmea_parsers[] = {
 #endif //PIOS_GPS_MINIMAL
 };
 
-int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
-{
-	static uint8_t rx_count = 0;
-	static bool start_flag = false;
-	static bool found_cr = false;
+// Receiver state, carried from one buffer to the next
+static bool start_flag = false;
+static uint8_t rx_count = 0;
 
-	// detect start while acquiring stream
-	if (!start_flag && (c == '$')) // NMEA identifier found
-	{
-		start_flag = true;
-		found_cr = false;
-		rx_count = 0;
-	}
-	else
-	if (!start_flag)
+/**
+ * Validate and process one sentence
+ * \param[in] sentence starts with '$' and ends with the '\n' terminator
+ * \param[in] len length including the terminator
+ */
+static int nmea_process_sentence(char *sentence, uint16_t len, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
+	// The NMEA functions require a zero-terminated string, strip the \r\n
+	sentence[len - 1] = 0;
+	if (len >= 2 && sentence[len - 2] == '\r')
+		sentence[len - 2] = 0;
+
+	// Validate the checksum over the sentence
+	if (!NMEA_checksum(&sentence[1])) {
+		// Invalid checksum.  May indicate dropped characters on Rx.
+		gpsRxStats->gpsRxChkSumError++;
 		return PARSER_ERROR;
-
-	if (rx_count >= NMEA_MAX_PACKET_LENGTH)
-	{
-		// The buffer is already full and we haven't found a valid NMEA sentence.
-		// Flush the buffer and note the overflow event.
-		gpsRxStats->gpsRxOverflow++;
-		start_flag = false;
-		found_cr = false;
-		rx_count = 0;
-		return PARSER_OVERRUN;
-	}
-	else
-	{
-		gps_rx_buffer[rx_count] = c;
-		rx_count++;
 	}
 
-	// look for ending '\r\n' sequence
-	if (!found_cr && (c == '\r') )
-		found_cr = true;
-	else
-	if (found_cr && (c != '\n') )
-		found_cr = false;  // false end flag
+	// Valid checksum, use this packet to update the GPS position
+	if (!NMEA_update_position(&sentence[1], GpsData))
+		gpsRxStats->gpsRxParserError++;
 	else
-	if (found_cr && (c == '\n') )
-	{
-		// The NMEA functions require a zero-terminated string
-		// As we detected \r\n, the string as for sure 2 bytes long, we will also strip the \r\n
-		gps_rx_buffer[rx_count-2] = 0;
+		gpsRxStats->gpsRxReceived++;
 
-		// prepare to parse next sentence
-		start_flag = false;
-		found_cr = false;
-		rx_count = 0;
-		// Our rxBuffer must look like this now:
-		//   [0]           = '$'
-		//   ...           = zero or more bytes of sentence payload
-		//   [end_pos - 1] = '\r'
-		//   [end_pos]     = '\n'
-		//
-		// Prepare to consume the sentence from the buffer
-
-		// Validate the checksum over the sentence
-		if (!NMEA_checksum(&gps_rx_buffer[1]))
-		{	// Invalid checksum.  May indicate dropped characters on Rx.
-			//PIOS_DEBUG_PinHigh(2);
-			gpsRxStats->gpsRxChkSumError++;
-			//PIOS_DEBUG_PinLow(2);
-			return PARSER_ERROR;
+	return PARSER_COMPLETE;
+}
+
+/**
+ * Parse a block of received bytes for NMEA sentences
+ *
+ * Sentences that lie entirely within rx are terminated and parsed in place,
+ * so rx is modified. Only a sentence split across calls is assembled in
+ * gps_rx_buffer.
+ *
+ * \param[in] rx bytes read from the GPS port
+ * \param[in] len number of bytes in rx
+ * \param[in] gps_rx_buffer assembly buffer, NMEA_MAX_PACKET_LENGTH long
+ * \return PARSER_COMPLETE if at least one sentence passed its checksum
+ * \return PARSER_INCOMPLETE otherwise
+ */
+int parse_nmea_buffer(char *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
+	char *end = rx + len;
+	int ret = PARSER_INCOMPLETE;
+
+	while (rx < end) {
+		// detect start while acquiring stream
+		if (!start_flag) {
+			rx = memchr(rx, '$', end - rx);
+			if (rx == NULL)
+				break;
+			start_flag = true;
+			rx_count = 0;
 		}
-		else
-		{	// Valid checksum, use this packet to update the GPS position
-			if (!NMEA_update_position(&gps_rx_buffer[1], GpsData)) {
-				//PIOS_DEBUG_PinHigh(2);
-				gpsRxStats->gpsRxParserError++;
-				//PIOS_DEBUG_PinLow(2);
-			}
-			else
-				gpsRxStats->gpsRxReceived++;;
-
-			return PARSER_COMPLETE;
+
+		char *lf = memchr(rx, '\n', end - rx);
+		uint16_t n = (lf ? lf + 1 : end) - rx;
+
+		if (rx_count + n > NMEA_MAX_PACKET_LENGTH) {
+			// Too long for a valid NMEA sentence. Note the overflow event
+			// and look for the next start after this one.
+			gpsRxStats->gpsRxOverflow++;
+			start_flag = false;
+			if (rx_count == 0)
+				rx++;
+			rx_count = 0;
+			continue;
 		}
+
+		if (lf && rx_count == 0) {
+			// The whole sentence is in this buffer
+			if (nmea_process_sentence(rx, n, GpsData, gpsRxStats) == PARSER_COMPLETE)
+				ret = PARSER_COMPLETE;
+		} else {
+			memcpy(&gps_rx_buffer[rx_count], rx, n);
+			rx_count += n;
+
+			if (lf && nmea_process_sentence(gps_rx_buffer, rx_count, GpsData, gpsRxStats) == PARSER_COMPLETE)
+				ret = PARSER_COMPLETE;
+		}
+
+		// prepare to parse next sentence
+		if (lf)
+			start_flag = false;
+		rx += n;
 	}
-	return PARSER_INCOMPLETE;
+
+	return ret;
 }
 
 const static struct nmea_parser *NMEA_find_parser_by_prefix(const char *prefix)
@@ -218,7 +231,7 @@ const static struct nmea_parser *NMEA_find_parser_by_prefix(const char *prefix)
 bool NMEA_checksum(char *nmea_sentence)
 {
 	uint8_t checksum_computed = 0;
-	uint8_t checksum_received;
+	uint8_t checksum_received = 0;
 
 	while (*nmea_sentence != '\0' && *nmea_sentence != '*') {
 		checksum_computed ^= *nmea_sentence;
@@ -231,10 +244,20 @@ bool NMEA_checksum(char *nmea_sentence)
 		return false;
 	}
 
-	/* Load the checksum from the buffer */
-	checksum_received = strtol(nmea_sentence + 1, NULL, 16);
-
-	//PIOS_COM_SendFormattedStringNonBlocking(COM_DEBUG_USART,"$%d=%d\r\n",checksum_received,checksum_computed);
+	/* Load the two hex digits of the checksum from the buffer */
+	for (uint8_t i = 1; i <= 2; i++) {
+		char c = nmea_sentence[i];
+
+		checksum_received <<= 4;
+		if (c >= '0' && c <= '9')
+			checksum_received |= c - '0';
+		else if (c >= 'A' && c <= 'F')
+			checksum_received |= c - 'A' + 10;
+		else if (c >= 'a' && c <= 'f')
+			checksum_received |= c - 'a' + 10;
+		else
+			return false;
+	}
 
 	return (checksum_computed == checksum_received);
 }
@@ -267,7 +290,7 @@ static bool NMEA_parse_real(int32_t * whole, uint32_t * fract, uint8_t * fract_u
 
 	*whole = strtol(field_w, NULL, 10);
 
-	if (field_w) {
+	if (field_f) {
 		/* decimal was found so we may have a fractional part */
 		*fract = strtoul(field_f, NULL, 10);
 		*fract_units = strlen(field_f);
@@ -36,99 +36,145 @@
 #include "UBX.h"
 #include "GPS.h"
 
-static bool checksum_ubx_message(const struct UBXPacket *);
 static uint32_t parse_ubx_message(const struct UBXPacket *, GPSPositionData *);
 
-// parse incoming character stream for messages in UBX binary format
+// Receiver state, carried from one buffer to the next
+static enum proto_states {
+	START,
+	UBX_SY2,
+	UBX_CLASS,
+	UBX_ID,
+	UBX_LEN1,
+	UBX_LEN2,
+	UBX_PAYLOAD,
+	UBX_CHK1,
+	UBX_CHK2,
+} proto_state = START;
+
+static uint16_t rx_count;
+static uint8_t ck_a, ck_b; // running checksum over class, id, length and payload
 
-int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+/**
+ * Parse a block of received bytes for messages in UBX binary format
+ *
+ * The checksum is accumulated as the bytes arrive, so the payload is copied
+ * into the packet buffer and summed in one pass. Each complete message is
+ * dispatched from the packet buffer as soon as its checksum has been checked.
+ * A message may be split over any number of calls.
+ *
+ * \param[in] rx bytes read from the GPS port
+ * \param[in] len number of bytes in rx
+ * \param[in] gps_rx_buffer packet buffer, at least sizeof(struct UBXPacket)
+ * \return PARSER_COMPLETE if at least one valid message was processed
+ * \return PARSER_INCOMPLETE otherwise
+ */
+int parse_ubx_buffer(const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
-	enum proto_states {
-		START,
-		UBX_SY2,
-		UBX_CLASS,
-		UBX_ID,
-		UBX_LEN1,
-		UBX_LEN2,
-		UBX_PAYLOAD,
-		UBX_CHK1,
-		UBX_CHK2,
-		FINISHED
-	};
-
-	static enum proto_states proto_state = START;
-	static uint8_t rx_count = 0;
 	struct UBXPacket *ubx = (struct UBXPacket *)gps_rx_buffer;
-
-	switch (proto_state) {
-		case START: // detect protocol
-			if (c ==  UBX_SYNC1) // first UBX sync char found
-				proto_state = UBX_SY2;
+	const uint8_t *end = rx + len;
+	int ret = PARSER_INCOMPLETE;
+
+	while (rx < end) {
+		uint8_t c;
+
+		switch (proto_state) {
+		case START:
+			// Skip everything up to the next sync character
+			rx = memchr(rx, UBX_SYNC1, end - rx);
+			if (rx == NULL)
+				return ret;
+			rx++;
+			proto_state = UBX_SY2;
 			break;
 		case UBX_SY2:
-			if (c == UBX_SYNC2) // second UBX sync char found
-				proto_state = UBX_CLASS;
-			else
-				proto_state = START; // reset state
+			// A mismatch is looked at again as a possible first sync character
+			if (*rx != UBX_SYNC2) {
+				proto_state = START;
+				break;
+			}
+			rx++;
+			proto_state = UBX_CLASS;
 			break;
 		case UBX_CLASS:
+			c = *rx++;
 			ubx->header.class = c;
+			ck_a = c;
+			ck_b = c;
 			proto_state = UBX_ID;
 			break;
 		case UBX_ID:
+			c = *rx++;
 			ubx->header.id = c;
+			ck_a += c;
+			ck_b += ck_a;
 			proto_state = UBX_LEN1;
 			break;
 		case UBX_LEN1:
+			c = *rx++;
 			ubx->header.len = c;
+			ck_a += c;
+			ck_b += ck_a;
 			proto_state = UBX_LEN2;
 			break;
 		case UBX_LEN2:
+			c = *rx++;
 			ubx->header.len += (c << 8);
+			ck_a += c;
+			ck_b += ck_a;
+			rx_count = 0;
 			if (ubx->header.len > sizeof(UBXPayload)) {
 				gpsRxStats->gpsRxOverflow++;
 				proto_state = START;
+			} else if (ubx->header.len == 0) {
+				proto_state = UBX_CHK1;
 			} else {
-				rx_count = 0;
 				proto_state = UBX_PAYLOAD;
 			}
 			break;
 		case UBX_PAYLOAD:
-			if (rx_count < ubx->header.len) {
-				ubx->payload.payload[rx_count] = c;
-				if (++rx_count == ubx->header.len)
-					proto_state = UBX_CHK1;
-			} else {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
+		{
+			// Copy and checksum as much of the payload as this buffer holds
+			uint16_t n = ubx->header.len - rx_count;
+			if (n > end - rx)
+				n = end - rx;
+
+			uint8_t *dst = &ubx->payload.payload[rx_count];
+			uint8_t a = ck_a, b = ck_b;
+			for (uint16_t i = 0; i < n; i++) {
+				c = rx[i];
+				dst[i] = c;
+				a += c;
+				b += a;
 			}
+			ck_a = a;
+			ck_b = b;
+
+			rx += n;
+			rx_count += n;
+			if (rx_count == ubx->header.len)
+				proto_state = UBX_CHK1;
 			break;
+		}
 		case UBX_CHK1:
-			ubx->header.ck_a = c;
+			ubx->header.ck_a = *rx++;
 			proto_state = UBX_CHK2;
 			break;
 		case UBX_CHK2:
-			ubx->header.ck_b = c;
-			if (checksum_ubx_message(ubx)) { // message complete and valid
+			ubx->header.ck_b = *rx++;
+			if (ubx->header.ck_a == ck_a && ubx->header.ck_b == ck_b) {
+				// message complete and valid
 				parse_ubx_message(ubx, GpsData);
-				proto_state = FINISHED;
+				gpsRxStats->gpsRxReceived++;
+				ret = PARSER_COMPLETE;
 			} else {
 				gpsRxStats->gpsRxChkSumError++;
-				proto_state = START;
 			}
+			proto_state = START;
 			break;
-		default: break;
-	}
-
-	if (proto_state == START)
-		return PARSER_ERROR;	// parser couldn't use this byte
-	else if (proto_state == FINISHED) {
-		gpsRxStats->gpsRxReceived++;
-		proto_state = START;
-		return PARSER_COMPLETE;	// message complete & processed
+		}
 	}
 
-	return PARSER_INCOMPLETE; // message not (yet) complete
+	return ret;
 }
 
 
@@ -163,36 +209,6 @@ bool check_msgtracker (uint32_t tow, uint8_t msg_flag)
 	return true;
 }
 
-static bool checksum_ubx_message (const struct UBXPacket *ubx)
-{
-	int i;
-	uint8_t ck_a, ck_b;
-
-	ck_a = ubx->header.class;
-	ck_b = ck_a;
-
-	ck_a += ubx->header.id;
-	ck_b += ck_a;
-
-	ck_a += ubx->header.len & 0xff;
-	ck_b += ck_a;
-
-	ck_a += ubx->header.len >> 8;
-	ck_b += ck_a;
-
-	for (i = 0; i < ubx->header.len; i++) {
-		ck_a += ubx->payload.payload[i];
-		ck_b += ck_a;
-	}
-
-	if (ubx->header.ck_a == ck_a &&
-			ubx->header.ck_b == ck_b)
-		return true;
-	else
-		return false;
-
-}
-
 static void parse_ubx_nav_posllh (const struct UBX_NAV_POSLLH *posllh, GPSPositionData *GpsPosition)
 {
 	if (check_msgtracker(posllh->iTOW, POSLLH_RECEIVED)) {
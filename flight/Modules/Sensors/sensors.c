@@ -52,6 +52,7 @@
 #define TASK_PRIORITY (tskIDLE_PRIORITY+3)
 #define SENSOR_PERIOD 6		// this allows sensor data to arrive as slow as 166Hz
 #define REQUIRED_GOOD_CYCLES 50
+#define SENSOR_CHANNEL_SIZE 32	// samples buffered for batched sensors between task runs
 
 // Private types
 enum mag_calibration_algo {
@@ -73,11 +74,18 @@ static void mag_calibration_fix_length(MagnetometerData *mag);
 
 static void updateTemperatureComp(float temperature, float *temp_bias);
 
+static bool receive_gyros(struct pios_sensor_gyro_data *gyros);
+static bool receive_accels(struct pios_sensor_accel_data *accels);
+
 // Private variables
 static xTaskHandle sensorsTaskHandle;
 static INSSettingsData insSettings;
 static AccelsData accelsData;
 
+// Channels for the sensors that deliver batches of samples instead of using a queue
+static struct pios_sensor_channel *gyro_channel;
+static struct pios_sensor_channel *accel_channel;
+
 // These values are initialized by settings but can be updated by the attitude algorithm
 static bool bias_correct_gyro = true;
 
@@ -160,6 +168,14 @@ static void SensorsTask(void *parameters)
 	UAVObjEvent ev;
 	settingsUpdatedCb(&ev);
 
+	// The loop runs once per gyro burst and uses its average. The accels are
+	// only polled, so they never need to wake the task.
+	if (PIOS_SENSORS_IsBatched(PIOS_SENSOR_GYRO))
+		gyro_channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, SENSOR_CHANNEL_SIZE,
+		                                      PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_GYRO));
+	if (PIOS_SENSORS_IsBatched(PIOS_SENSOR_ACCEL))
+		accel_channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_ACCEL, SENSOR_CHANNEL_SIZE, SENSOR_CHANNEL_SIZE);
+
 
 	// Main task loop
 	lastSysTime = xTaskGetTickCount();
@@ -181,15 +197,12 @@ static void SensorsTask(void *parameters)
 		uint32_t timeval = PIOS_DELAY_GetRaw();
 
 		//Block on gyro data but nothing else
-		xQueueHandle queue;
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
-		if(queue == NULL || xQueueReceive(queue, (void *) &gyros, SENSOR_PERIOD) == errQUEUE_EMPTY) {
+		if (!receive_gyros(&gyros)) {
 			good_runs = 0;
 			continue;
 		}
 
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
-		if(queue == NULL || xQueueReceive(queue, (void *) &accels, 0) == errQUEUE_EMPTY) {
+		if (!receive_accels(&accels)) {
 			//If no new accels data is ready, reuse the latest sample
 			AccelsSet(&accelsData);
 		}
@@ -200,6 +213,7 @@ static void SensorsTask(void *parameters)
 		// the accels to be available first
 		update_gyros(&gyros);
 
+		xQueueHandle queue;
 		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_MAG);
 		if(queue != NULL && xQueueReceive(queue, (void *) &mags, 0) != errQUEUE_EMPTY) {
 			update_mags(&mags);
@@ -224,6 +238,46 @@ static void SensorsTask(void *parameters)
 	}
 }
 
+/**
+ * @brief Wait for the next gyro data, averaging the batch if the gyro
+ * delivers several samples at a time
+ * @return true if there was data
+ */
+static bool receive_gyros(struct pios_sensor_gyro_data *gyros)
+{
+	if (gyro_channel != NULL) {
+		struct pios_sensor_sample sample;
+		if (PIOS_SENSORS_DrainAverage(gyro_channel, &sample, SENSOR_PERIOD) == 0)
+			return false;
+
+		*gyros = sample.gyro;
+		return true;
+	}
+
+	xQueueHandle queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
+	return queue != NULL && xQueueReceive(queue, (void *) gyros, SENSOR_PERIOD) != errQUEUE_EMPTY;
+}
+
+/**
+ * @brief Take the accel data that arrived with the gyro data, averaged like
+ * the gyros, without waiting
+ * @return true if there was new data
+ */
+static bool receive_accels(struct pios_sensor_accel_data *accels)
+{
+	if (accel_channel != NULL) {
+		struct pios_sensor_sample sample;
+		if (PIOS_SENSORS_DrainAverage(accel_channel, &sample, 0) == 0)
+			return false;
+
+		*accels = sample.accel;
+		return true;
+	}
+
+	xQueueHandle queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
+	return queue != NULL && xQueueReceive(queue, (void *) accels, 0) != errQUEUE_EMPTY;
+}
+
 /**
  * @brief Apply calibration and rotation to the raw accel data
  * @param[in] accels The raw accel data
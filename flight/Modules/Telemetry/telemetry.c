@@ -43,6 +43,7 @@
 #define MAX_RETRIES 2
 #define STATS_UPDATE_PERIOD_MS 4000
 #define CONNECTION_TIMEOUT_MS 8000
+#define RX_CHUNK_SIZE 16
 
 // Private types
 
@@ -370,15 +371,17 @@ static void telemetryRxTask(void *parameters)
 		uintptr_t inputPort = getComPort();
 
 		if (inputPort) {
-			// Block until data are available
-			uint8_t serial_data[1];
+			// Block until data are available, then drain whatever the
+			// COM fifo holds in chunks before blocking again
+			uint8_t serial_data[RX_CHUNK_SIZE];
 			uint16_t bytes_to_process;
 
 			bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), 500);
-			if (bytes_to_process > 0) {
-				for (uint8_t i = 0; i < bytes_to_process; i++) {
-					UAVTalkProcessInputStream(uavTalkCon,serial_data[i]);
-				}
+			while (bytes_to_process > 0) {
+				UAVTalkProcessInputBuffer(uavTalkCon, serial_data, bytes_to_process);
+				if (bytes_to_process < sizeof(serial_data))
+					break;
+				bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), 0);
 			}
 		} else {
 			vTaskDelay(5);
@@ -0,0 +1,96 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup VibrationAnalysisModule Vibration analysis module
+ * @{
+ *
+ * @file       welch.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      Welch power spectrum estimate of the three accel axes
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef WELCH_H
+#define WELCH_H
+
+#include "arm_math.h"
+
+#define WELCH_AXES 3
+
+/**
+ * Welch's method: the sample stream is cut into Hann windowed segments that
+ * overlap by half, each segment goes through a real FFT and the power spectra
+ * of the segments are summed. Averaging K segments cuts the variance of each
+ * bin by about K, where a single FFT gives a spectrum as noisy as the signal.
+ */
+struct welch_state {
+	uint16_t fft_size;		//!< Samples per segment, 128, 512 or 2048
+	uint16_t count;			//!< Samples waiting in the segment buffers
+	uint16_t segments;		//!< Segments summed into the power spectra
+
+	uint32_t rate_samples;		//!< Samples added by batch since the reset
+	uint32_t rate_timestamp;	//!< Raw time of the last of them
+	uint32_t rate_span_us;		//!< Time from the first of them to the last
+
+	arm_rfft_instance_q15 rfft;
+	arm_cfft_radix4_instance_q15 cfft;
+
+	float window_sum;		//!< Sum of the window, for amplitudes
+	float window_power;		//!< Sum of the squared window, for powers
+	float *window;
+
+	float *samples[WELCH_AXES];	//!< The last fft_size samples of each axis
+	float *power[WELCH_AXES];	//!< Summed |X|^2 of bins 0 to fft_size/2
+
+	q15_t *fft_in;
+	q15_t *fft_out;
+};
+
+//! Allocate the buffers for a segment length, returns -1 if it is not supported
+int32_t welch_init(struct welch_state *welch, uint16_t fft_size);
+
+//! Forget the summed spectra and any partial segment
+void welch_reset(struct welch_state *welch);
+
+//! Add one sample of every axis, returns true when it completed a segment
+bool welch_add_sample(struct welch_state *welch, const float sample[WELCH_AXES]);
+
+//! Add timestamped accel samples until the spectrum holds enough segments
+uint16_t welch_add_batch(struct welch_state *welch, const struct pios_sensor_sample *samples, uint16_t count, uint16_t segments);
+
+//! Sample rate of the samples added by batch, 0 if it is not known yet
+float welch_sample_rate(const struct welch_state *welch);
+
+//! Single sided amplitude of a bin, in the units of the samples
+float welch_amplitude(const struct welch_state *welch, uint8_t axis, uint16_t bin);
+
+//! Frequency of the strongest bin, interpolated between bins
+float welch_peak(const struct welch_state *welch, uint8_t axis, float sample_rate, float *amplitude);
+
+//! Mean square of the signal between two frequencies
+float welch_band_power(const struct welch_state *welch, uint8_t axis, float sample_rate, float low, float high);
+
+#endif /* WELCH_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -30,21 +30,29 @@
 
 /**
  * Input objects: @ref Accels, @ref VibrationAnalysisSettings
- * Output object: @ref VibrationAnalysisOutput
+ * Output object: @ref VibrationAnalysisOutput, @ref VibrationAnalysisSummary
  *
  * This module executes on a timer trigger. When the module is
  * triggered it will update the data of VibrationAnalysiOutput, based on
  * the output of an FFT running on the accelerometer samples. 
+ *
+ * In full rate mode every accel sample is used instead of averages over
+ * the sample period, and the spectrum is a Welch estimate: windowed real
+ * FFTs of half overlapping segments are averaged before each update, so
+ * the bins are stable enough to read peaks and band energies from.
  */
 
 #include "openpilot.h"
 #include "physical_constants.h"
 #include "arm_math.h"
 
+#include "welch.h"
+
 #include "accels.h"
 #include "modulesettings.h"
 #include "vibrationanalysisoutput.h"
 #include "vibrationanalysissettings.h"
+#include "vibrationanalysissummary.h"
 
 
 // Private constants
@@ -60,6 +68,12 @@
 #define TASK_PRIORITY (tskIDLE_PRIORITY+1)
 #define SETTINGS_THROTTLING_MS 100
 
+#define FULL_RATE_STACK_SIZE_BYTES 1000
+#define ACCEL_CHANNEL_SIZE 128
+#define ACCEL_CHANNEL_THRESHOLD 32
+#define ACCEL_DRAIN_BATCH 16
+#define ACCEL_TIMEOUT_MS 100
+
 #define MAX_ACCEL_RANGE 16                          // Maximum accelerometer resolution in [g]
 #define FLOAT_TO_Q15 (32768/(MAX_ACCEL_RANGE*GRAVITY)) // This is the scaling constant that scales all input floats to +-
 
@@ -67,6 +81,8 @@
 static xTaskHandle taskHandle;
 static xQueueHandle queue;
 static bool module_enabled = false;
+static struct pios_sensor_channel *accel_channel;
+static struct welch_state *welch;
 
 static struct VibrationAnalysis_data {
 	uint16_t accels_sum_count;
@@ -91,6 +107,11 @@ static struct VibrationAnalysis_data {
 
 // Private functions
 static void VibrationAnalysisTask(void *parameters);
+static void VibrationAnalysisFullRateTask(void *parameters);
+static int32_t VibrationAnalysisStartFullRate(void);
+static int32_t create_output_instances(uint16_t num_instances);
+static uint16_t get_accels(struct pios_sensor_sample *samples, uint16_t max);
+static void publish_spectrum(float sample_rate, uint32_t dropped, const uint16_t band_edges[]);
 
 /**
  * Start the module, called on startup
@@ -101,6 +122,11 @@ static int32_t VibrationAnalysisStart(void)
 	if (!module_enabled)
 		return -1;
 
+	uint8_t mode;
+	VibrationAnalysisSettingsModeGet(&mode);
+	if (mode == VIBRATIONANALYSISSETTINGS_MODE_FULLRATE)
+		return VibrationAnalysisStartFullRate();
+
 	//Get the FFT window size
 	uint16_t fft_window_size; // Make a local copy in order to check settings before allocating memory
 	uint8_t num_upscale_bits;
@@ -131,21 +157,9 @@ static int32_t VibrationAnalysisStart(void)
 	}
 	
 
-	// Create instances for vibration analysis. Start from i=1 because the first instance is generated
-	// by VibrationAnalysisOutputInitialize(). Generate three times the length because there are three
-	// vectors. Generate half the length because the FFT output is symmetric about the mid-frequency, 
+	// Generate half the length because the FFT output is symmetric about the mid-frequency, 
 	// so there's no point in using memory additional memory.
-	for (int i=1; i < (fft_window_size>>1); i++) {
-		uint16_t ret = VibrationAnalysisOutputCreateInstance();
-		if (ret == 0) {
-			// This fails when it's a metaobject. Not a very helpful test.
-			module_enabled = false;
-			return -1;
-		}
-	}
-	
-	if (VibrationAnalysisOutputGetNumInstances() != (fft_window_size>>1)){
-		// This is a more useful test for failure.
+	if (create_output_instances(fft_window_size>>1) != 0) {
 		module_enabled = false;
 		return -1;
 	}
@@ -197,6 +211,74 @@ static int32_t VibrationAnalysisStart(void)
 	return 0;
 }
 
+/**
+ * Start the full rate analysis. The segment size is only read here, like
+ * the FFT window size, because it sets how much memory is allocated.
+ */
+static int32_t VibrationAnalysisStartFullRate(void)
+{
+	uint16_t fft_size;
+	uint8_t segment_size_enum;
+	VibrationAnalysisSettingsWelchSegmentSizeGet(&segment_size_enum);
+	switch (segment_size_enum) {
+		case VIBRATIONANALYSISSETTINGS_WELCHSEGMENTSIZE_128:
+			fft_size = 128;
+			break;
+		case VIBRATIONANALYSISSETTINGS_WELCHSEGMENTSIZE_512:
+			fft_size = 512;
+			break;
+		case VIBRATIONANALYSISSETTINGS_WELCHSEGMENTSIZE_2048:
+			fft_size = 2048;
+			break;
+		default:
+			module_enabled = false;
+			return -1;
+	}
+
+	// One instance per bin up to, but not including, the Nyquist frequency
+	if (create_output_instances(fft_size / 2) != 0) {
+		module_enabled = false;
+		return -1;
+	}
+
+	welch = (struct welch_state *) pvPortMalloc(sizeof(*welch));
+	if (welch == NULL || welch_init(welch, fft_size) != 0) {
+		module_enabled = false;
+		return -1;
+	}
+
+	// Take every accel sample when the driver batches them. Otherwise
+	// fall back to each update of Accels.
+	if (PIOS_SENSORS_IsBatched(PIOS_SENSOR_ACCEL))
+		accel_channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_ACCEL, ACCEL_CHANNEL_SIZE, ACCEL_CHANNEL_THRESHOLD);
+
+	xTaskCreate(VibrationAnalysisFullRateTask, (signed char *)"VibrationAnalysis", FULL_RATE_STACK_SIZE_BYTES/4, NULL, TASK_PRIORITY, &taskHandle);
+	TaskMonitorAdd(TASKINFO_RUNNING_VIBRATIONANALYSIS, taskHandle);
+	return 0;
+}
+
+/**
+ * Create instances for vibration analysis. Start from i=1 because the first
+ * instance is generated by VibrationAnalysisOutputInitialize().
+ */
+static int32_t create_output_instances(uint16_t num_instances)
+{
+	for (int i=1; i < num_instances; i++) {
+		uint16_t ret = VibrationAnalysisOutputCreateInstance();
+		if (ret == 0) {
+			// This fails when it's a metaobject. Not a very helpful test.
+			return -1;
+		}
+	}
+
+	if (VibrationAnalysisOutputGetNumInstances() != num_instances) {
+		// This is a more useful test for failure.
+		return -1;
+	}
+
+	return 0;
+}
+
 
 /**
  * Initialise the module, called on startup
@@ -223,6 +305,7 @@ static int32_t VibrationAnalysisInitialize(void)
 	// Initialize UAVOs
 	VibrationAnalysisSettingsInitialize();
 	VibrationAnalysisOutputInitialize();
+	VibrationAnalysisSummaryInitialize();
 		
 	// Create object queue
 	queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
@@ -420,6 +503,136 @@ static void VibrationAnalysisTask(void *parameters)
 	}
 }
 
+/**
+ * Runs the Welch estimate on every accel sample and publishes the spectrum
+ * once enough segments have been averaged
+ */
+static void VibrationAnalysisFullRateTask(void *parameters)
+{
+	struct pios_sensor_sample samples[ACCEL_DRAIN_BATCH];
+	uint16_t band_edges[VIBRATIONANALYSISSETTINGS_BANDEDGES_NUMELEM];
+	uint8_t runAnalysisFlag = VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF;
+	uint8_t averages = 1;
+	portTickType lastSettingsUpdateTime = xTaskGetTickCount() - MS2TICKS(SETTINGS_THROTTLING_MS);
+
+	bool restart = true;
+	uint32_t dropped_base = 0;
+
+	if (accel_channel == NULL)
+		AccelsConnectQueue(queue);
+
+	// Main module task, never exit from while loop
+	while(1)
+	{
+		if(xTaskGetTickCount() - lastSettingsUpdateTime > MS2TICKS(SETTINGS_THROTTLING_MS)){
+			VibrationAnalysisSettingsTestingStatusGet(&runAnalysisFlag);
+			VibrationAnalysisSettingsWelchAveragesGet(&averages);
+			averages = averages > 0 ? averages : 1;
+			VibrationAnalysisSettingsBandEdgesGet(band_edges);
+
+			lastSettingsUpdateTime = xTaskGetTickCount();
+		}
+
+		// If analysis is turned off, delay and then loop. Samples that
+		// pile up in the meantime are stale, so start over when it resumes.
+		if (runAnalysisFlag == VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF) {
+			restart = true;
+			vTaskDelay(200);
+			continue;
+		}
+
+		if (restart) {
+			while (accel_channel != NULL && PIOS_SENSORS_Drain(accel_channel, samples, ACCEL_DRAIN_BATCH, 0) > 0)
+				;
+			welch_reset(welch);
+			dropped_base = accel_channel != NULL ? accel_channel->dropped : 0;
+			restart = false;
+		}
+
+		uint16_t count = get_accels(samples, ACCEL_DRAIN_BATCH);
+		if (count == 0)
+			continue;
+
+		uint16_t used = 0;
+		while (used < count) {
+			used += welch_add_batch(welch, &samples[used], count - used, averages);
+			if (welch->segments < averages)
+				continue;
+
+			float sample_rate = welch_sample_rate(welch);
+			if (sample_rate > 0) {
+				uint32_t dropped = accel_channel != NULL ? accel_channel->dropped : 0;
+				publish_spectrum(sample_rate, dropped - dropped_base, band_edges);
+				dropped_base = dropped;
+			}
+
+			// Each spectrum is estimated from fresh segments
+			welch_reset(welch);
+		}
+	}
+}
+
+/**
+ * Get the next accel samples, from the batched channel when there is one
+ * and otherwise from the Accels object
+ * @param[out] samples the samples, in m/s^2
+ * @param[in] max the most samples to return
+ * @return the number of samples
+ */
+static uint16_t get_accels(struct pios_sensor_sample *samples, uint16_t max)
+{
+	if (accel_channel != NULL)
+		return PIOS_SENSORS_Drain(accel_channel, samples, max, ACCEL_TIMEOUT_MS);
+
+	UAVObjEvent ev;
+	if (xQueueReceive(queue, &ev, MS2TICKS(ACCEL_TIMEOUT_MS)) != pdTRUE)
+		return 0;
+
+	AccelsData accels_data;
+	AccelsGet(&accels_data);
+
+	samples[0].timestamp = PIOS_DELAY_GetRaw();
+	samples[0].accel.x = accels_data.x;
+	samples[0].accel.y = accels_data.y;
+	samples[0].accel.z = accels_data.z;
+	return 1;
+}
+
+/**
+ * Write the peaks and band energies to VibrationAnalysisSummary and the
+ * amplitude of every bin to the VibrationAnalysisOutput instances
+ */
+static void publish_spectrum(float sample_rate, uint32_t dropped, const uint16_t band_edges[])
+{
+	VibrationAnalysisSummaryData summary;
+	float *band_energy[WELCH_AXES] = { summary.BandEnergyX, summary.BandEnergyY, summary.BandEnergyZ };
+
+	summary.SampleRate = sample_rate;
+	summary.Segments = welch->segments;
+	summary.DroppedSamples = dropped;
+
+	for (int axis = 0; axis < WELCH_AXES; axis++) {
+		summary.PeakFrequency[axis] = welch_peak(welch, axis, sample_rate, &summary.PeakAmplitude[axis]);
+
+		for (int j = 0; j < VIBRATIONANALYSISSUMMARY_BANDENERGYX_NUMELEM; j++)
+			band_energy[axis][j] = welch_band_power(welch, axis, sample_rate, band_edges[j], band_edges[j + 1]);
+	}
+
+	VibrationAnalysisSummarySet(&summary);
+
+	VibrationAnalysisOutputData vibrationAnalysisOutputData;
+	for (int j = 0; j < welch->fft_size / 2; j++) {
+		//Assertion check that we are not trying to write to instances that don't exist
+		if (j >= VibrationAnalysisOutputGetNumInstances())
+			break;
+
+		vibrationAnalysisOutputData.x = welch_amplitude(welch, 0, j);
+		vibrationAnalysisOutputData.y = welch_amplitude(welch, 1, j);
+		vibrationAnalysisOutputData.z = welch_amplitude(welch, 2, j);
+		VibrationAnalysisOutputInstSet(j, &vibrationAnalysisOutputData);
+	}
+}
+
 /**
  * @}
  * @}
@@ -0,0 +1,341 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup VibrationAnalysisModule Vibration analysis module
+ * @{
+ *
+ * @file       welch.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      Welch power spectrum estimate of the three accel axes
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "arm_math.h"
+#include "welch.h"
+
+#include <math.h>
+
+// Private constants
+
+// Each segment is scaled so its largest windowed sample fills this much of
+// the q15 range. Scaling per segment keeps the full 15 bits for both gentle
+// and violent vibration instead of reserving them for the accel range.
+#define Q15_PEAK (0.9f * 32767)
+
+// Private functions
+static void welch_process_segment(struct welch_state *welch);
+static uint32_t span_us(uint32_t from, uint32_t to);
+
+/**
+ * Allocate the buffers and tables for one segment length. The q15 real FFT
+ * only supports 128, 512 and 2048 points.
+ * @param[out] welch the state to initialize
+ * @param[in] fft_size samples per segment
+ * @return 0 if successful, -1 if not
+ */
+int32_t welch_init(struct welch_state *welch, uint16_t fft_size)
+{
+	memset(welch, 0, sizeof(*welch));
+
+	if (arm_rfft_init_q15(&welch->rfft, &welch->cfft, fft_size, 0, 1) != ARM_MATH_SUCCESS)
+		return -1;
+
+	welch->fft_size = fft_size;
+
+	welch->window = (float *) pvPortMalloc(fft_size * sizeof(*welch->window));
+	welch->fft_in = (q15_t *) pvPortMalloc(fft_size * sizeof(*welch->fft_in));
+	welch->fft_out = (q15_t *) pvPortMalloc(2 * fft_size * sizeof(*welch->fft_out));
+	if (welch->window == NULL || welch->fft_in == NULL || welch->fft_out == NULL)
+		return -1;
+
+	for (int i = 0; i < WELCH_AXES; i++) {
+		welch->samples[i] = (float *) pvPortMalloc(fft_size * sizeof(*welch->samples[i]));
+		welch->power[i] = (float *) pvPortMalloc((fft_size / 2 + 1) * sizeof(*welch->power[i]));
+		if (welch->samples[i] == NULL || welch->power[i] == NULL)
+			return -1;
+	}
+
+	// Periodic Hann window, which overlapped by half sums to a constant
+	for (int i = 0; i < fft_size; i++) {
+		float w = 0.5f * (1.0f - cosf(2 * PI * i / fft_size));
+		welch->window[i] = w;
+		welch->window_sum += w;
+		welch->window_power += w * w;
+	}
+
+	welch_reset(welch);
+
+	return 0;
+}
+
+/**
+ * Forget the summed spectra and any partial segment
+ */
+void welch_reset(struct welch_state *welch)
+{
+	welch->count = 0;
+	welch->segments = 0;
+	welch->rate_samples = 0;
+	welch->rate_span_us = 0;
+
+	for (int i = 0; i < WELCH_AXES; i++)
+		memset(welch->power[i], 0, (welch->fft_size / 2 + 1) * sizeof(*welch->power[i]));
+}
+
+/**
+ * Add one sample of every axis. Once a segment is full it is transformed and
+ * its second half is kept as the first half of the next segment.
+ * @param[in] sample one value per axis
+ * @return true if this sample completed a segment
+ */
+bool welch_add_sample(struct welch_state *welch, const float sample[WELCH_AXES])
+{
+	for (int i = 0; i < WELCH_AXES; i++)
+		welch->samples[i][welch->count] = sample[i];
+
+	if (++welch->count < welch->fft_size)
+		return false;
+
+	welch_process_segment(welch);
+
+	const uint16_t hop = welch->fft_size / 2;
+	for (int i = 0; i < WELCH_AXES; i++)
+		memmove(welch->samples[i], &welch->samples[i][hop], hop * sizeof(*welch->samples[i]));
+	welch->count = hop;
+
+	return true;
+}
+
+/**
+ * Add a batch of accel samples, as drained from a sensor channel. The batch
+ * stops after the sample that completes the requested number of segments,
+ * so the spectrum can be read before the rest of the batch starts the next.
+ * The time the samples span is measured a batch at a time, so the raw timer
+ * cannot wrap within it.
+ * @param[in] samples the samples, in m/s^2
+ * @param[in] count the number of samples, which may be 0
+ * @param[in] segments the number of segments that completes the spectrum
+ * @return the number of samples used
+ */
+uint16_t welch_add_batch(struct welch_state *welch, const struct pios_sensor_sample *samples, uint16_t count, uint16_t segments)
+{
+	// A drain that timed out has no samples to time
+	if (count == 0)
+		return 0;
+
+	if (welch->rate_samples == 0)
+		welch->rate_timestamp = samples[0].timestamp;
+
+	uint16_t used = 0;
+	while (used < count) {
+		float sample[WELCH_AXES] = { samples[used].accel.x, samples[used].accel.y, samples[used].accel.z };
+		bool segment_done = welch_add_sample(welch, sample);
+		used++;
+
+		if (segment_done && welch->segments >= segments)
+			break;
+	}
+
+	uint32_t timestamp = samples[used - 1].timestamp;
+	welch->rate_span_us += span_us(welch->rate_timestamp, timestamp);
+	welch->rate_timestamp = timestamp;
+	welch->rate_samples += used;
+
+	return used;
+}
+
+/**
+ * Sample rate of the samples added with welch_add_batch since the last reset
+ * @return the sample rate in Hz, or 0 if there are too few samples to tell
+ */
+float welch_sample_rate(const struct welch_state *welch)
+{
+	if (welch->rate_samples < 2 || welch->rate_span_us == 0)
+		return 0;
+
+	return (welch->rate_samples - 1) * 1e6f / welch->rate_span_us;
+}
+
+/**
+ * Time between two raw timestamps in us. The later one is measured first so
+ * the clock advancing between the two calls cannot make the span negative.
+ */
+static uint32_t span_us(uint32_t from, uint32_t to)
+{
+	uint32_t to_us = PIOS_DELAY_DiffuS(to);
+	uint32_t from_us = PIOS_DELAY_DiffuS(from);
+	return from_us - to_us;
+}
+
+/**
+ * Remove the mean of each axis, window it and add its power spectrum to the sums
+ */
+static void welch_process_segment(struct welch_state *welch)
+{
+	const uint16_t n = welch->fft_size;
+
+	for (int axis = 0; axis < WELCH_AXES; axis++) {
+		const float *x = welch->samples[axis];
+
+		// The mean is gravity and the accel bias. Left in, its window
+		// sidelobes would bury the lowest bins.
+		float mean = 0;
+		for (int i = 0; i < n; i++)
+			mean += x[i];
+		mean /= n;
+
+		float peak = 0;
+		for (int i = 0; i < n; i++) {
+			float v = fabsf((x[i] - mean) * welch->window[i]);
+			if (v > peak)
+				peak = v;
+		}
+
+		const float scale = peak > 0 ? Q15_PEAK / peak : 1.0f;
+		for (int i = 0; i < n; i++)
+			welch->fft_in[i] = (q15_t) lrintf((x[i] - mean) * welch->window[i] * scale);
+
+		// Overwrites fft_in. The output is the spectrum divided by n / 2
+		// so it cannot overflow.
+		arm_rfft_q15(&welch->rfft, welch->fft_in, welch->fft_out);
+
+		const float unscale = (n / 2) / scale;
+		const float power_scale = unscale * unscale;
+		float *power = welch->power[axis];
+		for (int k = 0; k <= n / 2; k++) {
+			float re = welch->fft_out[2 * k];
+			float im = welch->fft_out[2 * k + 1];
+			power[k] += (re * re + im * im) * power_scale;
+		}
+	}
+
+	welch->segments++;
+}
+
+/**
+ * Single sided amplitude of a bin. A sine wave centred on a bin reads as its
+ * amplitude.
+ * @param[in] axis the axis
+ * @param[in] bin the bin, from 0 to fft_size / 2
+ * @return the amplitude in the units of the samples
+ */
+float welch_amplitude(const struct welch_state *welch, uint8_t axis, uint16_t bin)
+{
+	if (welch->segments == 0 || axis >= WELCH_AXES || bin > welch->fft_size / 2)
+		return 0;
+
+	float amplitude = sqrtf(welch->power[axis][bin] / welch->segments) / welch->window_sum;
+
+	// The other half of the energy is in the mirrored negative frequencies
+	if (bin > 0 && bin < welch->fft_size / 2)
+		amplitude *= 2;
+
+	return amplitude;
+}
+
+/**
+ * Find the strongest bin and interpolate the peak from its neighbours. A Hann
+ * window makes the peak close to a Gaussian, so the parabola is fitted to the
+ * log of the power.
+ * @param[in] axis the axis
+ * @param[in] sample_rate the sample rate in Hz
+ * @param[out] amplitude the amplitude of the peak, if not NULL
+ * @return the frequency of the peak in Hz
+ */
+float welch_peak(const struct welch_state *welch, uint8_t axis, float sample_rate, float *amplitude)
+{
+	if (amplitude != NULL)
+		*amplitude = 0;
+
+	if (welch->segments == 0 || axis >= WELCH_AXES)
+		return 0;
+
+	const float *power = welch->power[axis];
+	const uint16_t last = welch->fft_size / 2 - 1;
+
+	// The bin at DC only holds what is left of the mean
+	uint16_t best = 1;
+	for (uint16_t k = 2; k <= last; k++)
+		if (power[k] > power[best])
+			best = k;
+
+	float offset = 0;
+	float peak_amplitude = welch_amplitude(welch, axis, best);
+
+	if (best > 1 && best < last && power[best] > 0) {
+		const float floor = power[best] * 1e-12f;
+		float y0 = logf(power[best - 1] + floor);
+		float y1 = logf(power[best]);
+		float y2 = logf(power[best + 1] + floor);
+		float curvature = y0 - 2 * y1 + y2;
+
+		if (curvature < 0) {
+			offset = 0.5f * (y0 - y2) / curvature;
+			float log_peak = y1 - 0.25f * (y0 - y2) * offset;
+			peak_amplitude *= expf(0.5f * (log_peak - y1));
+		}
+	}
+
+	if (amplitude != NULL)
+		*amplitude = peak_amplitude;
+
+	return (best + offset) * sample_rate / welch->fft_size;
+}
+
+/**
+ * Mean square of the signal in the bins from low up to but not including
+ * high. The window's power is corrected for, so a sine wave of amplitude A
+ * inside the band reads as A^2 / 2.
+ * @param[in] axis the axis
+ * @param[in] sample_rate the sample rate in Hz
+ * @param[in] low the lower edge in Hz
+ * @param[in] high the upper edge in Hz
+ * @return the power in the squared units of the samples
+ */
+float welch_band_power(const struct welch_state *welch, uint8_t axis, float sample_rate, float low, float high)
+{
+	if (welch->segments == 0 || axis >= WELCH_AXES || sample_rate <= 0)
+		return 0;
+
+	const uint16_t n = welch->fft_size;
+	const float bin_width = sample_rate / n;
+	const float *power = welch->power[axis];
+
+	float sum = 0;
+	for (uint16_t k = 0; k <= n / 2; k++) {
+		float f = k * bin_width;
+		if (f < low || f >= high)
+			continue;
+
+		if (k > 0 && k < n / 2)
+			sum += 2 * power[k];
+		else
+			sum += power[k];
+	}
+
+	return sum / (welch->segments * n * welch->window_power);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -32,6 +32,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>		/* NULL */
+#include <string.h>		/* memset */
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
@@ -43,6 +44,16 @@ enum pios_flashfs_logfs_dev_magic {
 	PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
 
+/*
+ * One entry per slot of the active arena in the RAM directory.  Entries
+ * of active slots are chained into hash buckets keyed on obj/inst id.
+ */
+struct logfs_dir_entry {
+	uint32_t obj_id;
+	uint16_t obj_inst_id;
+	uint16_t next_slot_id;	/* next slot in the same bucket, 0 = end of chain */
+};
+
 struct logfs_state {
 	enum pios_flashfs_logfs_dev_magic magic;
 	const struct flashfs_logfs_cfg *cfg;
@@ -59,6 +70,11 @@ struct logfs_state {
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
 	uint32_t partition_size;
+
+	/* Optional RAM directory of the active slots (NULL if not enabled) */
+	struct logfs_dir_entry *dir_slots;	/* indexed by slot id */
+	uint16_t *dir_buckets;			/* first slot id in each chain, 0 = empty */
+	uint16_t dir_bucket_mask;
 };
 
 /*
@@ -378,6 +394,74 @@ static int32_t logfs_raw_copy_bytes (const struct logfs_state *logfs, uintptr_t
 	return 0;
 }
 
+/*
+ * RAM directory of the active slots
+ *
+ * Slot 0 of an arena holds the arena header so slot id 0 is used
+ * to terminate the hash chains.
+ */
+
+static uint16_t logfs_dir_bucket(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	return (obj_id ^ (obj_id >> 16) ^ obj_inst_id) & logfs->dir_bucket_mask;
+}
+
+static void logfs_dir_clear(struct logfs_state *logfs)
+{
+	memset(logfs->dir_buckets, 0, (logfs->dir_bucket_mask + 1) * sizeof(*logfs->dir_buckets));
+}
+
+static void logfs_dir_add(struct logfs_state *logfs, uint16_t slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t bucket = logfs_dir_bucket(logfs, obj_id, obj_inst_id);
+	struct logfs_dir_entry *entry = &logfs->dir_slots[slot_id];
+
+	entry->obj_id       = obj_id;
+	entry->obj_inst_id  = obj_inst_id;
+	entry->next_slot_id = logfs->dir_buckets[bucket];
+	logfs->dir_buckets[bucket] = slot_id;
+}
+
+static void logfs_dir_remove(struct logfs_state *logfs, uint16_t slot_id)
+{
+	struct logfs_dir_entry *entry = &logfs->dir_slots[slot_id];
+	uint16_t *link = &logfs->dir_buckets[logfs_dir_bucket(logfs, entry->obj_id, entry->obj_inst_id)];
+
+	while (*link != 0) {
+		if (*link == slot_id) {
+			*link = entry->next_slot_id;
+			return;
+		}
+		link = &logfs->dir_slots[*link].next_slot_id;
+	}
+
+	/* Slot was not in the directory */
+	PIOS_DEBUG_Assert(0);
+}
+
+/**
+ * @brief Find the lowest numbered active slot at or after min_slot_id holding the object
+ * @return slot id or 0 if the object has no such slot
+ */
+static uint16_t logfs_dir_find(const struct logfs_state *logfs, uint16_t min_slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t found = 0;
+
+	for (uint16_t slot_id = logfs->dir_buckets[logfs_dir_bucket(logfs, obj_id, obj_inst_id)];
+	     slot_id != 0;
+	     slot_id = logfs->dir_slots[slot_id].next_slot_id) {
+		const struct logfs_dir_entry *entry = &logfs->dir_slots[slot_id];
+		if (entry->obj_id == obj_id &&
+			entry->obj_inst_id == obj_inst_id &&
+			slot_id >= min_slot_id &&
+			(found == 0 || slot_id < found)) {
+			found = slot_id;
+		}
+	}
+
+	return found;
+}
+
 /*
  * Is the entire filesystem full?
  * true = all slots in the arena are in the ACTIVE state (ie. garbage collection won't free anything)
@@ -417,7 +501,11 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 	logfs->num_free_slots   = 0;
 	logfs->active_arena_id  = arena_id;
 
-	/* Scan the log to find out how full it is */
+	if (logfs->dir_slots) {
+		logfs_dir_clear(logfs);
+	}
+
+	/* Scan the log to find out how full it is and rebuild the directory */
 	for (uint16_t slot_id = 1;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
@@ -443,6 +531,9 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 			break;
 		case SLOT_STATE_ACTIVE:
 			logfs->num_active_slots++;
+			if (logfs->dir_slots) {
+				logfs_dir_add(logfs, slot_id, slot_hdr.obj_id, slot_hdr.obj_inst_id);
+			}
 			break;
 		case SLOT_STATE_RESERVED:
 		case SLOT_STATE_OBSOLETE:
@@ -471,12 +562,42 @@ static struct logfs_state *PIOS_FLASHFS_Logfs_alloc(void)
 	if (!logfs) return (NULL);
 
 	logfs->magic = PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	logfs->dir_slots = NULL;
+	logfs->dir_buckets = NULL;
 	return(logfs);
 }
+static int32_t PIOS_FLASHFS_Logfs_dir_alloc(struct logfs_state *logfs)
+{
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+
+	/* Aim for an average chain length of two when the arena is full */
+	uint16_t num_buckets = 1;
+	while (num_buckets < num_slots / 2)
+		num_buckets <<= 1;
+
+	logfs->dir_slots = (struct logfs_dir_entry *)pvPortMalloc(num_slots * sizeof(*logfs->dir_slots));
+	if (!logfs->dir_slots) return -1;
+
+	logfs->dir_buckets = (uint16_t *)pvPortMalloc(num_buckets * sizeof(*logfs->dir_buckets));
+	if (!logfs->dir_buckets) {
+		vPortFree(logfs->dir_slots);
+		logfs->dir_slots = NULL;
+		return -1;
+	}
+
+	logfs->dir_bucket_mask = num_buckets - 1;
+	logfs_dir_clear(logfs);
+
+	return 0;
+}
 static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
 	logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	if (logfs->dir_slots) {
+		vPortFree(logfs->dir_slots);
+		vPortFree(logfs->dir_buckets);
+	}
 	vPortFree(logfs);
 }
 #else
@@ -492,9 +613,16 @@ static struct logfs_state *PIOS_FLASHFS_Logfs_alloc(void)
 
 	logfs = &pios_flashfs_logfs_devs[pios_flashfs_logfs_num_devs++];
 	logfs->magic = PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	logfs->dir_slots = NULL;
+	logfs->dir_buckets = NULL;
 
 	return (logfs);
 }
+static int32_t PIOS_FLASHFS_Logfs_dir_alloc(struct logfs_state *logfs)
+{
+	/* No dynamic memory with this simple allocator, fall back to scanning the log */
+	return 0;
+}
 static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
@@ -546,6 +674,12 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 	logfs->partition_size = partition_size; /* size of underlying partition */
 	logfs->mounted        = false;
 
+	/* Allocate the RAM directory before mounting so the mount scan fills it */
+	if (cfg->ram_directory && PIOS_FLASHFS_Logfs_dir_alloc(logfs) != 0) {
+		rc = -1;
+		goto out_exit;
+	}
+
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -1;
 		goto out_exit;
@@ -692,6 +826,26 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	/* First slot in the arena is reserved for arena header, skip it. */
 	if (*curr_slot == 0) *curr_slot = 1;
 
+	if (logfs->dir_slots) {
+		/* Look the slot up in the directory and only read its header */
+		uint16_t slot_id = logfs_dir_find(logfs, *curr_slot, obj_id, obj_inst_id);
+		if (slot_id == 0) {
+			return -1;
+		}
+
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						slot_addr,
+						(uint8_t *)slot_hdr,
+						sizeof (*slot_hdr)) != 0) {
+			return -2;
+		}
+		PIOS_DEBUG_Assert(slot_hdr->state == SLOT_STATE_ACTIVE);
+
+		*curr_slot = slot_id;
+		return 0;
+	}
+
 	for (uint16_t slot_id = *curr_slot;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
@@ -745,6 +899,9 @@ static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, u
 			}
 			/* Object has been successfully obsoleted and is no longer active */
 			logfs->num_active_slots--;
+			if (logfs->dir_slots) {
+				logfs_dir_remove(logfs, curr_slot_id);
+			}
 			break;
 		case -1:
 			/* Search completed, object not found */
@@ -857,6 +1014,9 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 
 	/* Object has been successfully written to the slot */
 	logfs->num_active_slots++;
+	if (logfs->dir_slots) {
+		logfs_dir_add(logfs, free_slot_id, obj_id, obj_inst_id);
+	}
 	return 0;
 }
 
@@ -42,21 +42,48 @@ enum pios_mpu6000_dev_magic {
     PIOS_MPU6000_DEV_MAGIC = 0x9da9b3ed,
 };
 
-#define PIOS_MPU6000_MAX_QUEUESIZE 2
+//! Layout of one sample, both in the data registers and in the FIFO
+enum pios_mpu6000_frame_index {
+	IDX_ACCEL_XOUT_H = 0,
+	IDX_ACCEL_XOUT_L,
+	IDX_ACCEL_YOUT_H,
+	IDX_ACCEL_YOUT_L,
+	IDX_ACCEL_ZOUT_H,
+	IDX_ACCEL_ZOUT_L,
+	IDX_TEMP_OUT_H,
+	IDX_TEMP_OUT_L,
+	IDX_GYRO_XOUT_H,
+	IDX_GYRO_XOUT_L,
+	IDX_GYRO_YOUT_H,
+	IDX_GYRO_YOUT_L,
+	IDX_GYRO_ZOUT_H,
+	IDX_GYRO_ZOUT_L,
+	MPU6000_FRAME_SIZE,
+};
+
+#if defined(PIOS_MPU6000_FIFO_BURST)
+//! Faster samples are collected in the FIFO and read in bursts at about this rate (Hz)
+#define PIOS_MPU6000_BURST_RATE 1000
+//! Most samples read from the FIFO at once, leaving room for a late interrupt
+#define PIOS_MPU6000_FIFO_MAX_FRAMES (2 * PIOS_MPU6000_FIFO_BURST)
+#endif /* PIOS_MPU6000_FIFO_BURST */
 
 struct mpu6000_dev {
 	uint32_t spi_id;
 	uint32_t slave_num;
 	enum pios_mpu60x0_range gyro_range;
-	xQueueHandle gyro_queue;
 #if defined(PIOS_MPU6000_ACCEL)
 	enum pios_mpu60x0_accel_range accel_range;
-	xQueueHandle accel_queue;
 #endif /* PIOS_MPU6000_ACCEL */
 	const struct pios_mpu60x0_cfg *cfg;
 	volatile bool configured;
 	enum pios_mpu6000_dev_magic magic;
 	enum pios_mpu60x0_filter filter;
+#if defined(PIOS_MPU6000_FIFO_BURST)
+	uint16_t burst;
+	uint16_t interrupts;
+	uint32_t last_burst_time;
+#endif /* PIOS_MPU6000_FIFO_BURST */
 };
 
 //! Global structure for this device device
@@ -70,6 +97,9 @@ static int32_t PIOS_MPU6000_ClaimBus();
 static int32_t PIOS_MPU6000_ReleaseBus();
 static int32_t PIOS_MPU6000_SetReg(uint8_t address, uint8_t buffer);
 static int32_t PIOS_MPU6000_GetReg(uint8_t address);
+#if defined(PIOS_MPU6000_FIFO_BURST)
+static void PIOS_MPU6000_ConfigBurst(void);
+#endif /* PIOS_MPU6000_FIFO_BURST */
 
 /**
  * @brief Allocate a new device
@@ -86,22 +116,6 @@ static struct mpu6000_dev *PIOS_MPU6000_alloc(void)
 
 	mpu6000_dev->configured = false;
 
-#if defined(PIOS_MPU6000_ACCEL)
-	mpu6000_dev->accel_queue = xQueueCreate(PIOS_MPU6000_MAX_QUEUESIZE, sizeof(struct pios_sensor_accel_data));
-
-	if (mpu6000_dev->accel_queue == NULL) {
-		vPortFree(mpu6000_dev);
-		return NULL;
-	}
-#endif /* PIOS_MPU6000_ACCEL */
-
-	mpu6000_dev->gyro_queue = xQueueCreate(PIOS_MPU6000_MAX_QUEUESIZE, sizeof(struct pios_sensor_gyro_data));
-
-	if (mpu6000_dev->gyro_queue == NULL) {
-		vPortFree(mpu6000_dev);
-		return NULL;
-	}
-
 	return mpu6000_dev;
 }
 
@@ -147,10 +161,10 @@ int32_t PIOS_MPU6000_Init(uint32_t spi_id, uint32_t slave_num, const struct pios
 	PIOS_EXTI_Init(cfg->exti_cfg);
 
 #if defined(PIOS_MPU6000_ACCEL)
-	PIOS_SENSORS_Register(PIOS_SENSOR_ACCEL, pios_mpu6000_dev->accel_queue);
+	PIOS_SENSORS_RegisterBatched(PIOS_SENSOR_ACCEL);
 #endif /* PIOS_MPU6000_ACCEL */
 
-	PIOS_SENSORS_Register(PIOS_SENSOR_GYRO, pios_mpu6000_dev->gyro_queue);
+	PIOS_SENSORS_RegisterBatched(PIOS_SENSOR_GYRO);
 
 	return 0;
 }
@@ -267,9 +281,47 @@ static void PIOS_MPU6000_Config(const struct pios_mpu60x0_cfg *cfg)
 
 #endif /* PIOS_MPU6000_SIMPLE_INIT_SEQUENCE */
 
+#if defined(PIOS_MPU6000_FIFO_BURST)
+	// Both init sequences write the user control register after the sample rate
+	PIOS_MPU6000_ConfigBurst();
+#endif /* PIOS_MPU6000_FIFO_BURST */
+
 	pios_mpu6000_dev->configured = true;
 }
 
+#if defined(PIOS_MPU6000_FIFO_BURST)
+/**
+ * @brief Enable the FIFO if the samples are read in bursts, and tell the
+ * sensor channels how many samples each interrupt publishes
+ */
+static void PIOS_MPU6000_ConfigBurst(void)
+{
+	// Keep the interrupt handler away from the FIFO while it changes
+	bool configured = pios_mpu6000_dev->configured;
+	pios_mpu6000_dev->configured = false;
+
+	if (pios_mpu6000_dev->burst > 1) {
+		// Store every sample in the FIFO, in register order
+		PIOS_MPU6000_SetReg(PIOS_MPU60X0_FIFO_EN_REG, PIOS_MPU60X0_ACCEL_OUT | PIOS_MPU60X0_FIFO_TEMP_OUT |
+		                    PIOS_MPU60X0_FIFO_GYRO_X_OUT | PIOS_MPU60X0_FIFO_GYRO_Y_OUT | PIOS_MPU60X0_FIFO_GYRO_Z_OUT);
+		PIOS_MPU6000_SetReg(PIOS_MPU60X0_USER_CTRL_REG, pios_mpu6000_dev->cfg->User_ctl | PIOS_MPU60X0_USERCTL_FIFO_EN | PIOS_MPU60X0_USERCTL_FIFO_RST);
+	} else {
+		PIOS_MPU6000_SetReg(PIOS_MPU60X0_FIFO_EN_REG, 0);
+		PIOS_MPU6000_SetReg(PIOS_MPU60X0_USER_CTRL_REG, pios_mpu6000_dev->cfg->User_ctl);
+	}
+
+	pios_mpu6000_dev->interrupts = 0;
+	pios_mpu6000_dev->last_burst_time = PIOS_DELAY_GetRaw();
+
+#if defined(PIOS_MPU6000_ACCEL)
+	PIOS_SENSORS_SetBurstSize(PIOS_SENSOR_ACCEL, pios_mpu6000_dev->burst);
+#endif /* PIOS_MPU6000_ACCEL */
+	PIOS_SENSORS_SetBurstSize(PIOS_SENSOR_GYRO, pios_mpu6000_dev->burst);
+
+	pios_mpu6000_dev->configured = configured;
+}
+#endif /* PIOS_MPU6000_FIFO_BURST */
+
 /**
  * Set the gyro range and store it locally for scaling
  */
@@ -318,6 +370,20 @@ void PIOS_MPU6000_SetSampleRate(uint16_t samplerate_hz)
 		divisor = 0xff;
 
 	PIOS_MPU6000_SetReg(PIOS_MPU60X0_SMPLRT_DIV_REG, (uint8_t)divisor);
+
+#if defined(PIOS_MPU6000_FIFO_BURST)
+	// Read the samples in bursts once they come faster than the burst rate
+	uint16_t burst = filter_frequency / (divisor + 1) / PIOS_MPU6000_BURST_RATE;
+	if (burst < 1)
+		burst = 1;
+	if (burst > PIOS_MPU6000_FIFO_BURST)
+		burst = PIOS_MPU6000_FIFO_BURST;
+	pios_mpu6000_dev->burst = burst;
+
+	// During the init sequence this is left for the end of PIOS_MPU6000_Config()
+	if (pios_mpu6000_dev->configured)
+		PIOS_MPU6000_ConfigBurst();
+#endif /* PIOS_MPU6000_FIFO_BURST */
 }
 
 /**
@@ -515,154 +581,211 @@ int32_t PIOS_MPU6000_Test(void)
 }
 
 /**
-* @brief IRQ Handler.  Read all the data from onboard buffer
-*/
-bool PIOS_MPU6000_IRQHandler(void)
+ * @brief Convert one sample from the chip into sensor data
+ * @param[in] frame The sample, laid out as the data registers from ACCEL_XOUT_H
+ * @param[in] timestamp When the sample was taken
+ */
+static void PIOS_MPU6000_ParseFrame(const uint8_t *frame, uint32_t timestamp,
+                                    struct pios_sensor_sample *accel, struct pios_sensor_sample *gyro)
 {
-	if (PIOS_MPU6000_Validate(pios_mpu6000_dev) != 0 || pios_mpu6000_dev->configured == false)
-		return false;
-
-	bool woken = false;
-
-	if (PIOS_MPU6000_ClaimBusISR(&woken) != 0)
-		return false;
-
-	enum {
-	    IDX_SPI_DUMMY_BYTE = 0,
-	    IDX_ACCEL_XOUT_H,
-	    IDX_ACCEL_XOUT_L,
-	    IDX_ACCEL_YOUT_H,
-	    IDX_ACCEL_YOUT_L,
-	    IDX_ACCEL_ZOUT_H,
-	    IDX_ACCEL_ZOUT_L,
-	    IDX_TEMP_OUT_H,
-	    IDX_TEMP_OUT_L,
-	    IDX_GYRO_XOUT_H,
-	    IDX_GYRO_XOUT_L,
-	    IDX_GYRO_YOUT_H,
-	    IDX_GYRO_YOUT_L,
-	    IDX_GYRO_ZOUT_H,
-	    IDX_GYRO_ZOUT_L,
-	    BUFFER_SIZE,
-	};
-
-	uint8_t mpu6000_send_buf[BUFFER_SIZE] = { PIOS_MPU60X0_ACCEL_X_OUT_MSB | 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-	uint8_t mpu6000_rec_buf[BUFFER_SIZE];
-
-	if (PIOS_SPI_TransferBlock(pios_mpu6000_dev->spi_id, mpu6000_send_buf, mpu6000_rec_buf, sizeof(mpu6000_send_buf), NULL) < 0) {
-		PIOS_MPU6000_ReleaseBusISR(&woken);
-		return false;
-	}
-
-	PIOS_MPU6000_ReleaseBusISR(&woken);
-
+	int16_t accel_x = (int16_t)(frame[IDX_ACCEL_XOUT_H] << 8 | frame[IDX_ACCEL_XOUT_L]);
+	int16_t accel_y = (int16_t)(frame[IDX_ACCEL_YOUT_H] << 8 | frame[IDX_ACCEL_YOUT_L]);
+	int16_t accel_z = (int16_t)(frame[IDX_ACCEL_ZOUT_H] << 8 | frame[IDX_ACCEL_ZOUT_L]);
+	int16_t gyro_x  = (int16_t)(frame[IDX_GYRO_XOUT_H] << 8 | frame[IDX_GYRO_XOUT_L]);
+	int16_t gyro_y  = (int16_t)(frame[IDX_GYRO_YOUT_H] << 8 | frame[IDX_GYRO_YOUT_L]);
+	int16_t gyro_z  = (int16_t)(frame[IDX_GYRO_ZOUT_H] << 8 | frame[IDX_GYRO_ZOUT_L]);
+	int16_t raw_temp = (int16_t)(frame[IDX_TEMP_OUT_H] << 8 | frame[IDX_TEMP_OUT_L]);
 
 	// Rotate the sensor to OP convention.  The datasheet defines X as towards the right
 	// and Y as forward.  OP convention transposes this.  Also the Z is defined negatively
 	// to our convention
 
-#if defined(PIOS_MPU6000_ACCEL)
-
 	// Currently we only support rotations on top so switch X/Y accordingly
-	struct pios_sensor_accel_data accel_data;
-	struct pios_sensor_gyro_data gyro_data;
-
 	switch (pios_mpu6000_dev->cfg->orientation) {
 	case PIOS_MPU60X0_TOP_0DEG:
-		accel_data.y = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-		accel_data.x = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-		gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-		gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
+		accel->accel.y = accel_x;
+		accel->accel.x = accel_y;
+		gyro->gyro.y   = gyro_x;
+		gyro->gyro.x   = gyro_y;
 		break;
 	case PIOS_MPU60X0_TOP_90DEG:
-		accel_data.y = - (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-		accel_data.x = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-		gyro_data.y  = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-		gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
+		accel->accel.y = - accel_y;
+		accel->accel.x = accel_x;
+		gyro->gyro.y   = - gyro_y;
+		gyro->gyro.x   = gyro_x;
 		break;
 	case PIOS_MPU60X0_TOP_180DEG:
-		accel_data.y = - (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-		accel_data.x = - (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-		gyro_data.y  = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-		gyro_data.x  = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
+		accel->accel.y = - accel_x;
+		accel->accel.x = - accel_y;
+		gyro->gyro.y   = - gyro_x;
+		gyro->gyro.x   = - gyro_y;
 		break;
 	case PIOS_MPU60X0_TOP_270DEG:
-		accel_data.y = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-		accel_data.x = - (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-		gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-		gyro_data.x  = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
+		accel->accel.y = accel_y;
+		accel->accel.x = - accel_x;
+		gyro->gyro.y   = gyro_y;
+		gyro->gyro.x   = - gyro_x;
 		break;
 	}
 
-	gyro_data.z  = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
-	accel_data.z = - (int16_t)(mpu6000_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_ZOUT_L]);
+	gyro->gyro.z   = - gyro_z;
+	accel->accel.z = - accel_z;
 
-	int16_t raw_temp = (int16_t)(mpu6000_rec_buf[IDX_TEMP_OUT_H] << 8 | mpu6000_rec_buf[IDX_TEMP_OUT_L]);
 	float temperature = 35.0f + ((float)raw_temp + 512.0f) / 340.0f;
 
 	// Apply sensor scaling
+#if defined(PIOS_MPU6000_ACCEL)
 	float accel_scale = PIOS_MPU6000_GetAccelScale();
-	accel_data.x *= accel_scale;
-	accel_data.y *= accel_scale;
-	accel_data.z *= accel_scale;
-	accel_data.temperature = temperature;
+	accel->accel.x *= accel_scale;
+	accel->accel.y *= accel_scale;
+	accel->accel.z *= accel_scale;
+	accel->accel.temperature = temperature;
+	accel->timestamp = timestamp;
+#endif /* PIOS_MPU6000_ACCEL */
 
 	float gyro_scale = PIOS_MPU6000_GetGyroScale();
-	gyro_data.x *= gyro_scale;
-	gyro_data.y *= gyro_scale;
-	gyro_data.z *= gyro_scale;
-	gyro_data.temperature = temperature;
+	gyro->gyro.x *= gyro_scale;
+	gyro->gyro.y *= gyro_scale;
+	gyro->gyro.z *= gyro_scale;
+	gyro->gyro.temperature = temperature;
+	gyro->timestamp = timestamp;
+}
 
-	portBASE_TYPE xHigherPriorityTaskWoken_accel;
-	xQueueSendToBackFromISR(pios_mpu6000_dev->accel_queue, (void *)&accel_data, &xHigherPriorityTaskWoken_accel);
+/**
+ * @brief Hand a batch of samples to the sensor channels
+ * @return true if a higher priority task was woken
+ */
+static bool PIOS_MPU6000_Publish(const struct pios_sensor_sample *accel, const struct pios_sensor_sample *gyro, uint16_t count)
+{
+	bool woken = false;
 
-	portBASE_TYPE xHigherPriorityTaskWoken_gyro;
-	xQueueSendToBackFromISR(pios_mpu6000_dev->gyro_queue, (void *)&gyro_data, &xHigherPriorityTaskWoken_gyro);
+#if defined(PIOS_MPU6000_ACCEL)
+	if (PIOS_SENSORS_PushFromISR(PIOS_SENSOR_ACCEL, accel, count))
+		woken = true;
+#endif /* PIOS_MPU6000_ACCEL */
 
-	return (xHigherPriorityTaskWoken_accel == pdTRUE) || (xHigherPriorityTaskWoken_gyro == pdTRUE) || woken == true;
+	if (PIOS_SENSORS_PushFromISR(PIOS_SENSOR_GYRO, gyro, count))
+		woken = true;
 
-#else
+	return woken;
+}
 
-	struct pios_sensor_gyro_data gyro_data;
+#if defined(PIOS_MPU6000_FIFO_BURST)
+/**
+ * @brief Read every complete sample waiting in the FIFO and publish them
+ * \param[in] pointer which receives if a task has been woken
+ * @return true if a higher priority task was woken
+ */
+static bool PIOS_MPU6000_ReadFifo(bool *woken)
+{
+	static uint8_t mpu6000_send_buf[1 + PIOS_MPU6000_FIFO_MAX_FRAMES * MPU6000_FRAME_SIZE];
+	static uint8_t mpu6000_rec_buf[1 + PIOS_MPU6000_FIFO_MAX_FRAMES * MPU6000_FRAME_SIZE];
+	static struct pios_sensor_sample accel[PIOS_MPU6000_FIFO_MAX_FRAMES];
+	static struct pios_sensor_sample gyro[PIOS_MPU6000_FIFO_MAX_FRAMES];
 
-	switch (pios_mpu6000_dev->cfg->orientation) {
-	case PIOS_MPU60X0_TOP_0DEG:
-		gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-		gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-		break;
-	case PIOS_MPU60X0_TOP_90DEG:
-		gyro_data.y  = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-		gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-		break;
-	case PIOS_MPU60X0_TOP_180DEG:
-		gyro_data.y  = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-		gyro_data.x  = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-		break;
-	case PIOS_MPU60X0_TOP_270DEG:
-		gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-		gyro_data.x  = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-		break;
+	uint8_t count_send_buf[3] = { PIOS_MPU60X0_FIFO_CNT_MSB | 0x80, 0, 0 };
+	uint8_t count_rec_buf[3];
+
+	if (PIOS_MPU6000_ClaimBusISR(woken) != 0)
+		return false;
+
+	if (PIOS_SPI_TransferBlock(pios_mpu6000_dev->spi_id, count_send_buf, count_rec_buf, sizeof(count_send_buf), NULL) < 0) {
+		PIOS_MPU6000_ReleaseBusISR(woken);
+		return false;
 	}
 
-	gyro_data.z = - (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
+	PIOS_MPU6000_ReleaseBusISR(woken);
 
-	int32_t raw_temp = (int16_t)(mpu6000_rec_buf[IDX_TEMP_OUT_H] << 8 | mpu6000_rec_buf[IDX_TEMP_OUT_L]);
-	float temperature = 35.0f + ((float)raw_temp + 512.0f) / 340.0f;
+	uint32_t now = PIOS_DELAY_GetRaw();
+	uint16_t fifo_bytes = count_rec_buf[1] << 8 | count_rec_buf[2];
 
-	// Apply sensor scaling
-	float gyro_scale = PIOS_MPU6000_GetGyroScale();
-	gyro_data.x *= gyro_scale;
-	gyro_data.y *= gyro_scale;
-	gyro_data.z *= gyro_scale;
-	gyro_data.temperature = temperature;
+	// A partial sample means the FIFO overflowed and lost its alignment
+	if (fifo_bytes % MPU6000_FRAME_SIZE != 0) {
+		uint8_t reset_buf[2] = { PIOS_MPU60X0_USER_CTRL_REG & 0x7f,
+		                         pios_mpu6000_dev->cfg->User_ctl | PIOS_MPU60X0_USERCTL_FIFO_EN | PIOS_MPU60X0_USERCTL_FIFO_RST };
 
-	portBASE_TYPE xHigherPriorityTaskWoken_gyro;
-	xQueueSendToBackFromISR(pios_mpu6000_dev->gyro_queue, (void *)&gyro_data, &xHigherPriorityTaskWoken_gyro);
+		if (PIOS_MPU6000_ClaimBusISR(woken) == 0) {
+			PIOS_SPI_TransferBlock(pios_mpu6000_dev->spi_id, reset_buf, NULL, sizeof(reset_buf), NULL);
+			PIOS_MPU6000_ReleaseBusISR(woken);
+		}
 
-	return (xHigherPriorityTaskWoken_gyro == pdTRUE || woken == true);
+		pios_mpu6000_dev->last_burst_time = now;
+		return false;
+	}
 
-#endif /* PIOS_MPU6000_ACCEL */
+	uint16_t frames = fifo_bytes / MPU6000_FRAME_SIZE;
+	if (frames > PIOS_MPU6000_FIFO_MAX_FRAMES)
+		frames = PIOS_MPU6000_FIFO_MAX_FRAMES;
+	if (frames == 0)
+		return false;
+
+	if (PIOS_MPU6000_ClaimBusISR(woken) != 0)
+		return false;
+
+	mpu6000_send_buf[0] = PIOS_MPU60X0_FIFO_REG | 0x80;
+	if (PIOS_SPI_TransferBlock(pios_mpu6000_dev->spi_id, mpu6000_send_buf, mpu6000_rec_buf, 1 + frames * MPU6000_FRAME_SIZE, NULL) < 0) {
+		PIOS_MPU6000_ReleaseBusISR(woken);
+		return false;
+	}
+
+	PIOS_MPU6000_ReleaseBusISR(woken);
+
+	// The samples were taken at an even rate since the last burst
+	uint32_t step = (now - pios_mpu6000_dev->last_burst_time) / frames;
+	for (uint16_t i = 0; i < frames; i++) {
+		uint32_t timestamp = pios_mpu6000_dev->last_burst_time + step * (i + 1);
+		PIOS_MPU6000_ParseFrame(&mpu6000_rec_buf[1 + i * MPU6000_FRAME_SIZE], timestamp, &accel[i], &gyro[i]);
+	}
+	pios_mpu6000_dev->last_burst_time = now;
+
+	return PIOS_MPU6000_Publish(accel, gyro, frames);
+}
+#endif /* PIOS_MPU6000_FIFO_BURST */
+
+/**
+* @brief IRQ Handler.  Read all the data from onboard buffer
+*/
+bool PIOS_MPU6000_IRQHandler(void)
+{
+	if (PIOS_MPU6000_Validate(pios_mpu6000_dev) != 0 || pios_mpu6000_dev->configured == false)
+		return false;
+
+	bool woken = false;
+
+#if defined(PIOS_MPU6000_FIFO_BURST)
+	if (pios_mpu6000_dev->burst > 1) {
+		// The data ready interrupt still fires for every sample, but the bus is
+		// only touched once a burst has collected in the FIFO
+		if (++pios_mpu6000_dev->interrupts < pios_mpu6000_dev->burst)
+			return false;
+		pios_mpu6000_dev->interrupts = 0;
+
+		bool published = PIOS_MPU6000_ReadFifo(&woken);
+
+		return published || woken == true;
+	}
+#endif /* PIOS_MPU6000_FIFO_BURST */
+
+	if (PIOS_MPU6000_ClaimBusISR(&woken) != 0)
+		return false;
+
+	uint8_t mpu6000_send_buf[1 + MPU6000_FRAME_SIZE] = { PIOS_MPU60X0_ACCEL_X_OUT_MSB | 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+	uint8_t mpu6000_rec_buf[1 + MPU6000_FRAME_SIZE];
+
+	if (PIOS_SPI_TransferBlock(pios_mpu6000_dev->spi_id, mpu6000_send_buf, mpu6000_rec_buf, sizeof(mpu6000_send_buf), NULL) < 0) {
+		PIOS_MPU6000_ReleaseBusISR(&woken);
+		return false;
+	}
+
+	PIOS_MPU6000_ReleaseBusISR(&woken);
+
+	struct pios_sensor_sample accel;
+	struct pios_sensor_sample gyro;
+	PIOS_MPU6000_ParseFrame(&mpu6000_rec_buf[1], PIOS_DELAY_GetRaw(), &accel, &gyro);
+
+	bool published = PIOS_MPU6000_Publish(&accel, &gyro, 1);
 
+	return published || woken == true;
 }
 
 #endif
@@ -36,11 +36,24 @@
 //! The list of queue handles
 static xQueueHandle queues[PIOS_SENSOR_LAST];
 
+//! Which sensor types publish batches and who is subscribed to them
+static bool batched[PIOS_SENSOR_LAST];
+static uint16_t burst_sizes[PIOS_SENSOR_LAST];
+static struct pios_sensor_channel *subscribers[PIOS_SENSOR_LAST][PIOS_SENSORS_MAX_SUBSCRIBERS];
+
+static uint16_t channel_available(const struct pios_sensor_channel *channel);
+static bool channel_wait(struct pios_sensor_channel *channel, uint32_t timeout_ms);
+
 //! Initialize the sensors interface
 int32_t PIOS_SENSORS_Init()
 {
-	for (uint32_t i = 0; i < PIOS_SENSOR_LAST; i++)
+	for (uint32_t i = 0; i < PIOS_SENSOR_LAST; i++) {
 		queues[i] = NULL;
+		batched[i] = false;
+		burst_sizes[i] = 1;
+		for (uint32_t j = 0; j < PIOS_SENSORS_MAX_SUBSCRIBERS; j++)
+			subscribers[i][j] = NULL;
+	}
 
 	return 0;
 }
@@ -48,7 +61,7 @@ int32_t PIOS_SENSORS_Init()
 //! Register a sensor with the PIOS_SENSORS interface
 int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, xQueueHandle queue)
 {
-	if(queues[type] != NULL)
+	if(queues[type] != NULL || batched[type])
 		return -1;
 
 	queues[type] = queue;
@@ -63,4 +76,251 @@ xQueueHandle PIOS_SENSORS_GetQueue(enum pios_sensor_type type)
 		return NULL;
 
 	return queues[type];
-}
\ No newline at end of file
+}
+
+//! Register a sensor that publishes batches of samples instead of using a queue
+int32_t PIOS_SENSORS_RegisterBatched(enum pios_sensor_type type)
+{
+	if (type < 0 || type >= PIOS_SENSOR_LAST)
+		return -1;
+
+	if (queues[type] != NULL || batched[type])
+		return -1;
+
+	batched[type] = true;
+
+	return 0;
+}
+
+//! Check whether a sensor type publishes batches of samples
+bool PIOS_SENSORS_IsBatched(enum pios_sensor_type type)
+{
+	if (type < 0 || type >= PIOS_SENSOR_LAST)
+		return false;
+
+	return batched[type];
+}
+
+//! Set the number of samples the driver of a batched type publishes at once
+void PIOS_SENSORS_SetBurstSize(enum pios_sensor_type type, uint16_t samples)
+{
+	if (type < 0 || type >= PIOS_SENSOR_LAST)
+		return;
+
+	burst_sizes[type] = samples > 0 ? samples : 1;
+}
+
+//! Get the number of samples the driver of a batched type publishes at once
+uint16_t PIOS_SENSORS_GetBurstSize(enum pios_sensor_type type)
+{
+	if (type < 0 || type >= PIOS_SENSOR_LAST)
+		return 1;
+
+	return burst_sizes[type];
+}
+
+/**
+ * Subscribe to the samples of a batched sensor type. Every subscriber gets
+ * its own channel and sees every sample, so an analysis module can take the
+ * full rate stream while the attitude loop averages it.
+ * @param[in] type The sensor type
+ * @param[in] size Samples the channel holds, rounded up to a power of two
+ * @param[in] wakeup_threshold Samples that must be waiting before the consumer is woken
+ * @return The channel or NULL if the type is not batched or out of memory
+ */
+struct pios_sensor_channel *PIOS_SENSORS_Subscribe(enum pios_sensor_type type, uint16_t size, uint16_t wakeup_threshold)
+{
+	if (!PIOS_SENSORS_IsBatched(type) || size == 0 || size > 0x8000)
+		return NULL;
+
+	uint32_t slot;
+	for (slot = 0; slot < PIOS_SENSORS_MAX_SUBSCRIBERS; slot++)
+		if (subscribers[type][slot] == NULL)
+			break;
+	if (slot == PIOS_SENSORS_MAX_SUBSCRIBERS)
+		return NULL;
+
+	// The indices wrap at 2^16 so the ring size must divide that
+	uint16_t ring_size = 1;
+	while (ring_size < size)
+		ring_size <<= 1;
+
+	struct pios_sensor_channel *channel = pvPortMalloc(sizeof(*channel));
+	if (channel == NULL)
+		return NULL;
+
+	channel->samples = pvPortMalloc(ring_size * sizeof(*channel->samples));
+	if (channel->samples == NULL) {
+		vPortFree(channel);
+		return NULL;
+	}
+
+	vSemaphoreCreateBinary(channel->data_ready);
+	if (channel->data_ready == NULL) {
+		vPortFree(channel->samples);
+		vPortFree(channel);
+		return NULL;
+	}
+	xSemaphoreTake(channel->data_ready, 0);
+
+	channel->type = type;
+	channel->size = ring_size;
+	channel->wakeup_threshold = wakeup_threshold > 0 ? wakeup_threshold : 1;
+	channel->head = 0;
+	channel->tail = 0;
+	channel->dropped = 0;
+
+	// Only publish the channel once it is complete, the driver may be running
+	__sync_synchronize();
+	subscribers[type][slot] = channel;
+
+	return channel;
+}
+
+/**
+ * Publish a burst of samples to every subscriber. Must only be called by the
+ * one driver registered for the type. Samples that do not fit in a channel
+ * are dropped and counted.
+ * @return true if a higher priority task was woken
+ */
+bool PIOS_SENSORS_PushFromISR(enum pios_sensor_type type, const struct pios_sensor_sample *samples, uint16_t count)
+{
+	portBASE_TYPE woken = pdFALSE;
+
+	if (type < 0 || type >= PIOS_SENSOR_LAST)
+		return false;
+
+	for (uint32_t i = 0; i < PIOS_SENSORS_MAX_SUBSCRIBERS; i++) {
+		struct pios_sensor_channel *channel = subscribers[type][i];
+		if (channel == NULL)
+			continue;
+
+		uint16_t head = channel->head;
+		uint16_t space = channel->size - (uint16_t)(head - channel->tail);
+		uint16_t n = count < space ? count : space;
+
+		for (uint16_t j = 0; j < n; j++)
+			channel->samples[(uint16_t)(head + j) & (channel->size - 1)] = samples[j];
+
+		// The samples must be in place before the consumer can see them
+		__sync_synchronize();
+		channel->head = head + n;
+		channel->dropped += count - n;
+
+		if (channel_available(channel) >= channel->wakeup_threshold) {
+			portBASE_TYPE channel_woken = pdFALSE;
+			xSemaphoreGiveFromISR(channel->data_ready, &channel_woken);
+			if (channel_woken == pdTRUE)
+				woken = pdTRUE;
+		}
+	}
+
+	return woken == pdTRUE;
+}
+
+/**
+ * Take up to max samples from a channel, oldest first
+ * @param[in] timeout_ms How long to wait if the channel is empty
+ * @return The number of samples copied, 0 on timeout
+ */
+uint16_t PIOS_SENSORS_Drain(struct pios_sensor_channel *channel, struct pios_sensor_sample *samples, uint16_t max, uint32_t timeout_ms)
+{
+	if (channel == NULL || !channel_wait(channel, timeout_ms))
+		return 0;
+
+	uint16_t tail = channel->tail;
+	uint16_t n = channel_available(channel);
+	if (n > max)
+		n = max;
+
+	for (uint16_t i = 0; i < n; i++)
+		samples[i] = channel->samples[(uint16_t)(tail + i) & (channel->size - 1)];
+
+	// Finish reading the slots before handing them back to the driver
+	__sync_synchronize();
+	channel->tail = tail + n;
+
+	return n;
+}
+
+/**
+ * Take every sample from a channel and average them into one. This is what
+ * a loop running slower than the sensor wants: the mean rate over the
+ * interval, which integrates to the same angle as the individual samples.
+ * @param[out] average The mean of each field, stamped with the time of the newest sample
+ * @param[in] timeout_ms How long to wait if the channel is empty
+ * @return The number of samples averaged, 0 on timeout
+ */
+uint16_t PIOS_SENSORS_DrainAverage(struct pios_sensor_channel *channel, struct pios_sensor_sample *average, uint32_t timeout_ms)
+{
+	if (channel == NULL || !channel_wait(channel, timeout_ms))
+		return 0;
+
+	// Every sensor structure is a plain list of floats
+	uint32_t num_fields;
+	switch (channel->type) {
+	case PIOS_SENSOR_ACCEL:
+		num_fields = sizeof(struct pios_sensor_accel_data) / sizeof(float);
+		break;
+	case PIOS_SENSOR_GYRO:
+		num_fields = sizeof(struct pios_sensor_gyro_data) / sizeof(float);
+		break;
+	case PIOS_SENSOR_MAG:
+		num_fields = sizeof(struct pios_sensor_mag_data) / sizeof(float);
+		break;
+	case PIOS_SENSOR_BARO:
+		num_fields = sizeof(struct pios_sensor_baro_data) / sizeof(float);
+		break;
+	default:
+		return 0;
+	}
+
+	float sum[4] = {0, 0, 0, 0};
+	uint16_t tail = channel->tail;
+	uint16_t n = channel_available(channel);
+
+	for (uint16_t i = 0; i < n; i++) {
+		const struct pios_sensor_sample *sample = &channel->samples[(uint16_t)(tail + i) & (channel->size - 1)];
+		const float *fields = (const float *) &sample->gyro;
+		for (uint32_t j = 0; j < num_fields; j++)
+			sum[j] += fields[j];
+		average->timestamp = sample->timestamp;
+	}
+
+	__sync_synchronize();
+	channel->tail = tail + n;
+
+	float *fields = (float *) &average->gyro;
+	for (uint32_t j = 0; j < num_fields; j++)
+		fields[j] = sum[j] / n;
+
+	return n;
+}
+
+//! Number of samples waiting in a channel
+static uint16_t channel_available(const struct pios_sensor_channel *channel)
+{
+	return channel->head - channel->tail;
+}
+
+/**
+ * Wait until a channel has samples. The semaphore can still be given from
+ * samples that were drained since, so one stale wakeup is tolerated.
+ */
+static bool channel_wait(struct pios_sensor_channel *channel, uint32_t timeout_ms)
+{
+	for (uint32_t attempt = 0; attempt < 2; attempt++) {
+		if (channel_available(channel) > 0)
+			return true;
+
+		if (xSemaphoreTake(channel->data_ready, timeout_ms / portTICK_RATE_MS) != pdTRUE)
+			return false;
+	}
+
+	return channel_available(channel) > 0;
+}
+
+/**
+ * @}
+ * @}
+ */
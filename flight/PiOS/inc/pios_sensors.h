@@ -32,8 +32,10 @@
 #define PIOS_SENSOR_H
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "semphr.h"
 
 //! Pios sensor structure for generic gyro data
 struct pios_sensor_gyro_data {
@@ -81,6 +83,38 @@ struct pios_sensor_registration {
 	xQueueHandle queue;
 };
 
+//! A sensor sample with the time it was taken
+struct pios_sensor_sample {
+	uint32_t timestamp;	//!< PIOS_DELAY_GetRaw() when the sample was taken
+	union {
+		struct pios_sensor_gyro_data gyro;
+		struct pios_sensor_accel_data accel;
+		struct pios_sensor_mag_data mag;
+		struct pios_sensor_baro_data baro;
+	};
+};
+
+//! The most consumers that can subscribe to one sensor type
+#define PIOS_SENSORS_MAX_SUBSCRIBERS 2
+
+/**
+ * A batched sensor channel is a lock free ring of samples with one producer,
+ * the driver, and one consumer, the subscribed task. The driver pushes a burst
+ * of samples from its interrupt and the consumer is woken once there are at
+ * least wakeup_threshold samples waiting, so per sample work is a copy rather
+ * than a queue operation and a context switch.
+ */
+struct pios_sensor_channel {
+	enum pios_sensor_type type;
+	struct pios_sensor_sample *samples;
+	uint16_t size;			//!< Number of slots, a power of two
+	uint16_t wakeup_threshold;
+	volatile uint16_t head;		//!< Total samples pushed, only written by the driver
+	volatile uint16_t tail;		//!< Total samples drained, only written by the consumer
+	volatile uint32_t dropped;	//!< Samples lost because the ring was full
+	xSemaphoreHandle data_ready;
+};
+
 //! Initialize the PIOS_SENSORS interface
 int32_t PIOS_SENSORS_Init();
 
@@ -90,4 +124,28 @@ int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, xQueueHandle queue);
 //! Get the data queue for a sensor type
 xQueueHandle PIOS_SENSORS_GetQueue(enum pios_sensor_type type);
 
+//! Register a sensor that publishes batches of samples instead of using a queue
+int32_t PIOS_SENSORS_RegisterBatched(enum pios_sensor_type type);
+
+//! Check whether a sensor type publishes batches of samples
+bool PIOS_SENSORS_IsBatched(enum pios_sensor_type type);
+
+//! Set the number of samples the driver of a batched type publishes at once
+void PIOS_SENSORS_SetBurstSize(enum pios_sensor_type type, uint16_t samples);
+
+//! Get the number of samples the driver of a batched type publishes at once
+uint16_t PIOS_SENSORS_GetBurstSize(enum pios_sensor_type type);
+
+//! Subscribe to the samples of a batched sensor type
+struct pios_sensor_channel *PIOS_SENSORS_Subscribe(enum pios_sensor_type type, uint16_t size, uint16_t wakeup_threshold);
+
+//! Publish a burst of samples to every subscriber from an interrupt
+bool PIOS_SENSORS_PushFromISR(enum pios_sensor_type type, const struct pios_sensor_sample *samples, uint16_t count);
+
+//! Take up to max samples from a channel, waiting for data if it is empty
+uint16_t PIOS_SENSORS_Drain(struct pios_sensor_channel *channel, struct pios_sensor_sample *samples, uint16_t max, uint32_t timeout_ms);
+
+//! Take every sample from a channel and average them into one
+uint16_t PIOS_SENSORS_DrainAverage(struct pios_sensor_channel *channel, struct pios_sensor_sample *average, uint32_t timeout_ms);
+
 #endif /* PIOS_SENSOR_H */
\ No newline at end of file
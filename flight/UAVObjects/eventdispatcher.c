@@ -61,17 +61,24 @@ typedef struct {
 
 /**
  * List of object properties that are needed for the periodic updates.
+ * Entries with a non-zero period are also linked into a pairing heap ordered
+ * by timeToNextUpdateMs so that only the due entries are visited on each wake.
  */
 struct PeriodicObjectListStruct {
 	EventCallbackInfo evInfo; /** Event callback information */
     uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
-    int32_t timeToNextUpdateMs; /** Time delay to the next update */
+    int32_t timeToNextUpdateMs; /** System time of the next update */
+    bool firstUpdate; /** Not fired since it was scheduled, the event task may still be sleeping past it */
     struct PeriodicObjectListStruct* next; /** Needed by linked list library (utlist.h) */
+    struct PeriodicObjectListStruct* heapChild; /** First child in the deadline heap */
+    struct PeriodicObjectListStruct* heapSibling; /** Next sibling in the deadline heap */
+    struct PeriodicObjectListStruct* heapPrev; /** Parent if first child, otherwise previous sibling */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
 // Private variables
 static PeriodicObjectList* objList;
+static PeriodicObjectList* deadlineHeap;
 static xQueueHandle queue;
 static xTaskHandle eventTaskHandle;
 static xSemaphoreHandle mutex;
@@ -83,6 +90,11 @@ static void eventTask();
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static uint16_t randomizePeriod(uint16_t periodMs);
+static PeriodicObjectList* heapMeld(PeriodicObjectList* a, PeriodicObjectList* b);
+static PeriodicObjectList* heapMergePairs(PeriodicObjectList* first);
+static void heapInsert(PeriodicObjectList* entry);
+static PeriodicObjectList* heapPop();
+static void heapRemove(PeriodicObjectList* entry);
 
 
 /**
@@ -93,6 +105,7 @@ int32_t EventDispatcherInitialize()
 {
 	// Initialize variables
 	objList = NULL;
+	deadlineHeap = NULL;
 	memset(&stats, 0, sizeof(EventStats));
 
 	// Create mutex
@@ -233,11 +246,17 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, xQue
 	objEntry->evInfo.cb = cb;
 	objEntry->evInfo.queue = queue;
     objEntry->updatePeriodMs = periodMs;
-    objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
+    objEntry->timeToNextUpdateMs = xTaskGetTickCount()*portTICK_RATE_MS + randomizePeriod(periodMs); // avoid bunching of updates
+    objEntry->firstUpdate = true;
+    objEntry->heapChild = NULL;
+    objEntry->heapSibling = NULL;
+    objEntry->heapPrev = NULL;
     // Add to list
     LL_APPEND(objList, objEntry);
-	// Release lock
-	xSemaphoreGiveRecursive(mutex);
+    if (periodMs > 0)
+    	heapInsert(objEntry);
+    // Release lock
+    xSemaphoreGiveRecursive(mutex);
     return 0;
 }
 
@@ -263,9 +282,14 @@ static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, xQue
 			objEntry->evInfo.ev.instId == ev->instId &&
 			objEntry->evInfo.ev.event == ev->event)
 		{
-			// Object found, update period
+			// Object found, update period and reschedule
+			if (objEntry->updatePeriodMs > 0)
+				heapRemove(objEntry);
 			objEntry->updatePeriodMs = periodMs;
-			objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
+			objEntry->timeToNextUpdateMs = xTaskGetTickCount()*portTICK_RATE_MS + randomizePeriod(periodMs); // avoid bunching of updates
+			objEntry->firstUpdate = true;
+			if (periodMs > 0)
+				heapInsert(objEntry);
 			// Release lock
 			xSemaphoreGiveRecursive(mutex);
 			return 0;
@@ -308,6 +332,7 @@ static void eventTask()
 			if ( evInfo.cb != 0)
 			{
 				evInfo.cb(&evInfo.ev); // the function is expected to copy the event information
+				++stats.eventsDispatched;
 			}
 		}
 
@@ -320,7 +345,7 @@ static void eventTask()
 }
 
 /**
- * Handle periodic updates for all objects.
+ * Handle periodic updates for all objects that are due.
  * \return The system time until the next update (in ms) or -1 if failed
  */
 static int32_t processPeriodicUpdates()
@@ -328,48 +353,56 @@ static int32_t processPeriodicUpdates()
 	PeriodicObjectList* objEntry;
 	int32_t timeNow;
     int32_t timeToNextUpdate;
-    int32_t offset;
+    int32_t lateMs;
 
 	// Get lock
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update.
-    timeToNextUpdate = xTaskGetTickCount()*portTICK_RATE_MS + MAX_UPDATE_PERIOD_MS;
-    LL_FOREACH(objList, objEntry)
+    // Pop every entry whose deadline has passed, reschedule it and dispatch its event.
+    // Only entries with periodic updates enabled are in the heap.
+    timeNow = xTaskGetTickCount()*portTICK_RATE_MS;
+    while (deadlineHeap != NULL && deadlineHeap->timeToNextUpdateMs <= timeNow)
     {
-        // If object is configured for periodic updates
-        if (objEntry->updatePeriodMs > 0)
-        {
-            // Check if time for the next update
-        	timeNow = xTaskGetTickCount()*portTICK_RATE_MS;
-            if (objEntry->timeToNextUpdateMs <= timeNow)
-            {
-                // Reset timer
-            	offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
-            	objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-    			// Invoke callback, if one
-    			if ( objEntry->evInfo.cb != 0)
-    			{
-    				objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
-    			}
-    			// Push event to queue, if one
-    			if ( objEntry->evInfo.queue != 0)
-    			{
-    				if ( xQueueSend(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != pdTRUE ) // do not block if queue is full
-    				{
-						if (objEntry->evInfo.ev.obj != NULL)
-							stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-    					++stats.eventErrors;
-    				}
-    			}
-            }
-            // Update minimum delay
-            if (objEntry->timeToNextUpdateMs < timeToNextUpdate)
-            {
-            	timeToNextUpdate = objEntry->timeToNextUpdateMs;
-            }
-        }
+    	objEntry = heapPop();
+
+    	// Track how late the event fires. The task may have been sleeping past
+    	// an entry's first deadline when it was set, so that fire does not count.
+    	lateMs = timeNow - objEntry->timeToNextUpdateMs;
+    	if (lateMs > 0 && !objEntry->firstUpdate)
+    	{
+    		++stats.lateEvents;
+    		if ((uint32_t)lateMs > stats.maxJitterMs)
+    			stats.maxJitterMs = lateMs;
+    	}
+
+        // Reset timer
+    	objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - (lateMs % objEntry->updatePeriodMs);
+    	objEntry->firstUpdate = false;
+    	heapInsert(objEntry);
+
+		// Invoke callback, if one
+		if ( objEntry->evInfo.cb != 0)
+		{
+			objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
+		}
+		// Push event to queue, if one
+		if ( objEntry->evInfo.queue != 0)
+		{
+			if ( xQueueSend(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != pdTRUE ) // do not block if queue is full
+			{
+				if (objEntry->evInfo.ev.obj != NULL)
+					stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
+				++stats.eventErrors;
+			}
+		}
+		++stats.eventsDispatched;
+    }
+
+    // The earliest deadline is at the root of the heap
+    timeToNextUpdate = timeNow + MAX_UPDATE_PERIOD_MS;
+    if (deadlineHeap != NULL && deadlineHeap->timeToNextUpdateMs < timeToNextUpdate)
+    {
+    	timeToNextUpdate = deadlineHeap->timeToNextUpdateMs;
     }
 
     // Done
@@ -377,6 +410,132 @@ static int32_t processPeriodicUpdates()
     return timeToNextUpdate;
 }
 
+/**
+ * Meld two deadline heaps. Both arguments must be heap roots (or NULL).
+ * \return The root of the combined heap
+ */
+static PeriodicObjectList* heapMeld(PeriodicObjectList* a, PeriodicObjectList* b)
+{
+	PeriodicObjectList* tmp;
+
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	// The root with the earlier deadline stays the root
+	if (b->timeToNextUpdateMs < a->timeToNextUpdateMs)
+	{
+		tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	// Make b the first child of a
+	b->heapPrev = a;
+	b->heapSibling = a->heapChild;
+	if (a->heapChild != NULL)
+		a->heapChild->heapPrev = b;
+	a->heapChild = b;
+
+	return a;
+}
+
+/**
+ * Combine a list of sibling heaps into a single heap using the two pass
+ * pairing heap merge. Implemented iteratively to keep stack usage constant.
+ * \return The root of the combined heap
+ */
+static PeriodicObjectList* heapMergePairs(PeriodicObjectList* first)
+{
+	PeriodicObjectList* pairs = NULL;
+	PeriodicObjectList* root = NULL;
+	PeriodicObjectList* a;
+	PeriodicObjectList* b;
+
+	// First pass: meld siblings in pairs from left to right, stacking the results
+	while (first != NULL)
+	{
+		a = first;
+		b = a->heapSibling;
+		first = (b != NULL) ? b->heapSibling : NULL;
+
+		a->heapSibling = NULL;
+		a->heapPrev = NULL;
+		if (b != NULL)
+		{
+			b->heapSibling = NULL;
+			b->heapPrev = NULL;
+		}
+
+		a = heapMeld(a, b);
+		a->heapSibling = pairs;
+		pairs = a;
+	}
+
+	// Second pass: meld the pairs from right to left
+	while (pairs != NULL)
+	{
+		a = pairs;
+		pairs = a->heapSibling;
+		a->heapSibling = NULL;
+		root = heapMeld(root, a);
+	}
+
+	return root;
+}
+
+/**
+ * Add an entry to the deadline heap
+ */
+static void heapInsert(PeriodicObjectList* entry)
+{
+	entry->heapChild = NULL;
+	entry->heapSibling = NULL;
+	entry->heapPrev = NULL;
+	deadlineHeap = heapMeld(deadlineHeap, entry);
+}
+
+/**
+ * Remove the entry with the earliest deadline from the heap
+ * \return The removed entry
+ */
+static PeriodicObjectList* heapPop()
+{
+	PeriodicObjectList* root = deadlineHeap;
+
+	deadlineHeap = heapMergePairs(root->heapChild);
+	root->heapChild = NULL;
+	return root;
+}
+
+/**
+ * Remove an arbitrary entry from the deadline heap
+ */
+static void heapRemove(PeriodicObjectList* entry)
+{
+	if (entry == deadlineHeap)
+	{
+		heapPop();
+		return;
+	}
+
+	// Unlink the entry from its parent or previous sibling
+	if (entry->heapPrev->heapChild == entry)
+		entry->heapPrev->heapChild = entry->heapSibling;
+	else
+		entry->heapPrev->heapSibling = entry->heapSibling;
+	if (entry->heapSibling != NULL)
+		entry->heapSibling->heapPrev = entry->heapPrev;
+
+	// Put its children back into the heap
+	deadlineHeap = heapMeld(deadlineHeap, heapMergePairs(entry->heapChild));
+
+	entry->heapChild = NULL;
+	entry->heapSibling = NULL;
+	entry->heapPrev = NULL;
+}
+
 /**
  * Return a psedorandom integer from 0 to periodMs
  * Based on the Park-Miller-Carta Pseudo-Random Number Generator
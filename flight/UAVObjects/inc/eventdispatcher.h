@@ -39,6 +39,9 @@
 typedef struct {
 	uint32_t lastErrorID;
 	uint32_t eventErrors;
+	uint32_t eventsDispatched; /** Callbacks invoked and periodic events fired */
+	uint32_t lateEvents; /** Periodic events that fired after their deadline */
+	uint32_t maxJitterMs; /** Largest delay of a periodic event past its deadline */
 } EventStats;
 
 // Public functions
@@ -128,6 +128,15 @@ typedef void (*UAVObjEventCallback)(UAVObjEvent* ev);
  */
 typedef void (*UAVObjInitializeCallback)(UAVObjHandle obj_handle, uint16_t instId);
 
+/**
+ * Entry of the generated object index (uavobjectsindex.c), which is sorted by object ID.
+ * The handle accessor is NULL for objects that are not built into the firmware.
+ */
+struct UAVOIndexEntry {
+	uint32_t id;
+	UAVObjHandle (*handle)();
+};
+
 /**
  * Event manager statistics
  */
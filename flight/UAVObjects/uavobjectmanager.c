@@ -58,11 +58,18 @@ struct ObjectEventEntry {
 /*
   MetaInstance   == [UAVOBase [UAVObjMetadata]]
   SingleInstance == [UAVOBase [UAVOData [InstanceData]]]
-  MultiInstance  == [UAVOBase [UAVOData [NumInstances [InstanceData0 [next]]]]
-                                                  ____________________/
-                                                  \-->[InstanceData1 [next]]
-                                                  _________...________/
-                                                  \-->[InstanceDataN [next]]
+  MultiInstance  == [UAVOBase [UAVOData [NumInstances [Blocks[1..N]] [InstanceData0]]]]
+                                                   \
+                                                    |->[InstanceData1 InstanceData2]
+                                                    |->[InstanceData3 ... InstanceData6]
+                                                    |->[InstanceData7 ... InstanceData14]
+                                                    \->...
+
+  Instance 0 is embedded in the object.  Further instances are allocated in
+  blocks that double in size up to UAVO_MULTI_MAX_BLOCK_INSTANCES, after which
+  every block holds that many.  Any instance is found with a single lookup.
+  Less of the last block is unused than the object has instances, and never
+  more than UAVO_MULTI_MAX_BLOCK_INSTANCES - 1 instances.
  */
 
 /*
@@ -113,22 +120,24 @@ struct UAVOSingle {
 	 */
 } __attribute__((packed));
 
-/* Part of a linked list of instances chained off of a multi instance UAVO. */
-struct UAVOMultiInst {
-	struct UAVOMultiInst * next;
-	uint8_t                instance[];
-	/* 
-	 * Additional space will be malloc'd here to hold the
-	 * the data for this instance.
-	 */
-} __attribute__((packed));
+/* Blocks stop doubling once they hold 2^UAVO_MULTI_BLOCK_SHIFT instances */
+#define UAVO_MULTI_BLOCK_SHIFT 6
+#define UAVO_MULTI_MAX_BLOCK_INSTANCES (1 << UAVO_MULTI_BLOCK_SHIFT)
+/* First instance held by a block of the maximum size after the doubling ones */
+#define UAVO_MULTI_FIXED_BLOCK_START (2 * UAVO_MULTI_MAX_BLOCK_INSTANCES - 1)
+
+/* Number of instance blocks of a multi instance UAVO, block 0 being instance 0 */
+#define UAVO_MULTI_MAX_BLOCKS (UAVO_MULTI_BLOCK_SHIFT + 1 + \
+	(UAVOBJ_MAX_INSTANCES - UAVO_MULTI_FIXED_BLOCK_START + UAVO_MULTI_MAX_BLOCK_INSTANCES - 1) / UAVO_MULTI_MAX_BLOCK_INSTANCES)
 
 /* Augmented type for Multi Instance Data UAVO */
 struct UAVOMulti {
 	struct UAVOData        uavo;
 
 	uint16_t               num_instances;
-	struct UAVOMultiInst   instance0;
+	/* Instance blocks 1 and up, allocated as they are needed */
+	uint8_t              * blocks[UAVO_MULTI_MAX_BLOCKS];
+	uint8_t                instance0[];
 	/*
 	 * Additional space will be malloc'd here to hold the
 	 * the data for instance 0.
@@ -145,7 +154,15 @@ struct UAVOMulti {
 
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void*)(&(( (struct UAVOSingle*)obj )->instance0)))
-#define InstanceDataOffset(inst) ((void*)&(( (struct UAVOMultiInst*)inst )->instance))
+/* Block holding a multi instance, the position of the instance within it and the block size */
+#define InstanceBlock(instId) ((instId) < UAVO_MULTI_FIXED_BLOCK_START ? \
+	31 - __builtin_clz((uint32_t)(instId) + 1) : \
+	UAVO_MULTI_BLOCK_SHIFT + 1 + ((instId) - UAVO_MULTI_FIXED_BLOCK_START) / UAVO_MULTI_MAX_BLOCK_INSTANCES)
+#define InstanceBlockIndex(instId) ((instId) < UAVO_MULTI_FIXED_BLOCK_START ? \
+	(uint32_t)(instId) + 1 - (1 << InstanceBlock(instId)) : \
+	((instId) - UAVO_MULTI_FIXED_BLOCK_START) % UAVO_MULTI_MAX_BLOCK_INSTANCES)
+#define InstanceBlockSize(block) ((block) < UAVO_MULTI_BLOCK_SHIFT ? \
+	1 << (block) : UAVO_MULTI_MAX_BLOCK_INSTANCES)
 #define InstanceData(instance) (void*)instance
 
 // Private functions
@@ -175,6 +192,10 @@ static const UAVObjMetadata defMetadata = {
 
 static UAVObjStats stats;
 
+/* Generated index of the objects, absent unless uavobjectsindex.c is built in */
+extern const struct UAVOIndexEntry uavo_index[] __attribute__((weak));
+extern const uint16_t uavo_index_count __attribute__((weak));
+
 /**
  * Initialize the object manager
  * \return 0 Success
@@ -278,10 +299,10 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 
 	/* Set up the type-specific part of the UAVO */
 	uavo_multi->num_instances = 1;
+	memset(uavo_multi->blocks, 0, sizeof(uavo_multi->blocks));
 
 	/* Clear the instance data carried in the UAVO */
-	uavo_multi->instance0.next = NULL;
-	memset (&(uavo_multi->instance0.instance), 0, num_bytes);
+	memset (&(uavo_multi->instance0), 0, num_bytes);
 
 	/* Give back the generic UAVO part */
 	return (&(uavo_multi->uavo));
@@ -357,6 +378,30 @@ unlock_exit:
 	return (UAVObjHandle) uavo_data;
 }
 
+/**
+ * Binary search the generated object index for an object ID
+ * \param[in] id The object ID
+ * \return The index entry or NULL if the ID is not in the index
+ */
+static const struct UAVOIndexEntry * findIndexEntry(uint32_t id)
+{
+	int32_t low = 0;
+	int32_t high = uavo_index_count - 1;
+
+	while (low <= high) {
+		int32_t mid = (low + high) / 2;
+		if (uavo_index[mid].id < id) {
+			low = mid + 1;
+		} else if (uavo_index[mid].id > id) {
+			high = mid - 1;
+		} else {
+			return &uavo_index[mid];
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * Retrieve an object from the list given its id
  * \param[in] The object ID
@@ -364,7 +409,25 @@ unlock_exit:
  */
 UAVObjHandle UAVObjGetByID(uint32_t id)
 {
-	UAVObjHandle * found_obj = (UAVObjHandle *) NULL;
+	UAVObjHandle found_obj = NULL;
+
+	/*
+	 * Generated objects are found through the flash resident index, which
+	 * also finds their meta objects under the next ID.  Objects registered
+	 * without being in the index are searched for in the object list.
+	 */
+	if (&uavo_index_count != NULL) {
+		const struct UAVOIndexEntry * entry = findIndexEntry(id);
+		if (entry) {
+			return entry->handle ? entry->handle() : NULL;
+		}
+
+		entry = findIndexEntry(id - 1);
+		if (entry) {
+			UAVObjHandle obj_handle = entry->handle ? entry->handle() : NULL;
+			return obj_handle ? UAVObjGetLinkedObj(obj_handle) : NULL;
+		}
+	}
 
 	// Get lock
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
@@ -373,11 +436,11 @@ UAVObjHandle UAVObjGetByID(uint32_t id)
 	struct UAVOData * tmp_obj;
 	LL_FOREACH(uavo_list, tmp_obj) {
 		if (tmp_obj->id == id) {
-			found_obj = (UAVObjHandle *)tmp_obj;
+			found_obj = (UAVObjHandle) tmp_obj;
 			goto unlock_exit;
 		}
 		if (MetaObjectId(tmp_obj->id) == id) {
-			found_obj = (UAVObjHandle *)&(tmp_obj->metaObj);
+			found_obj = (UAVObjHandle) &(tmp_obj->metaObj);
 			goto unlock_exit;
 		}
 	}
@@ -1581,7 +1644,7 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
  */
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 {
-	struct UAVOMultiInst *instEntry;
+	struct UAVOMulti * uavo_multi = (struct UAVOMulti *) obj;
 
 	/* Don't allow more than one instance for single instance objects */
 	if (UAVObjIsSingleInstance(&(obj->base))) {
@@ -1599,27 +1662,27 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 		return NULL;
 	}
 
-	// Create any missing instances (all instance IDs must be sequential)
-	for (uint16_t n = UAVObjGetNumInstances(&(obj->base)); n < instId; ++n) {
-		if (createInstance(obj, n) == NULL) {
-			return NULL;
+	// Create any missing instances too (all instance IDs must be sequential)
+	for (uint16_t n = uavo_multi->num_instances; n <= instId; ++n) {
+		uint8_t block = InstanceBlock(n);
+
+		/* The first instance of a block allocates the whole block */
+		if (InstanceBlockIndex(n) == 0) {
+			uint32_t block_size = InstanceBlockSize(block) * obj->instance_size;
+			uavo_multi->blocks[block] = (uint8_t *) pvPortMalloc(block_size);
+			if (!uavo_multi->blocks[block])
+				return NULL;
+			memset(uavo_multi->blocks[block], 0, block_size);
 		}
-	}
 
-	/* Create the actual instance */
-	instEntry = (struct UAVOMultiInst *) pvPortMalloc(sizeof(struct UAVOMultiInst)+obj->instance_size);
-	if (!instEntry)
-		return NULL;
-	memset(InstanceDataOffset(instEntry), 0, obj->instance_size);
-	LL_APPEND(( (struct UAVOMulti*)obj )->instance0.next, instEntry);
-
-	( (struct UAVOMulti*)obj )->num_instances++;
+		uavo_multi->num_instances++;
 
-	// Fire event
-	UAVObjInstanceUpdated((UAVObjHandle) obj, instId);
+		// Fire event
+		UAVObjInstanceUpdated((UAVObjHandle) obj, n);
+	}
 
 	// Done
-	return InstanceDataOffset(instEntry);
+	return getInstance(obj, instId);
 }
 
 /**
@@ -1653,17 +1716,11 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 		if (instId >= uavo_multi->num_instances)
 			return NULL;
 
-		// Look for specified instance ID
-		uint16_t instance = 0;
-		struct UAVOMultiInst *instEntry;
-		LL_FOREACH(&(uavo_multi->instance0), instEntry) {
-			if (instance++ == instId) {
-				/* Found it */
-				return &(instEntry->instance);
-			}
-		}
-		/* Instance was not found */
-		return NULL;
+		if (instId == 0)
+			return (&(uavo_multi->instance0));
+
+		return (uavo_multi->blocks[InstanceBlock(instId)] +
+			InstanceBlockIndex(instId) * obj->instance_size);
 	}
 }
 
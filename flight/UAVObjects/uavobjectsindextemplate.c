@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsCore Tau Labs Core components
+ * @{
+ * @addtogroup UAVObjectHandling UAVObject handling code
+ * @{
+ *
+ * @file       uavobjectsindex.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      Index of all objects sorted by object ID, used by UAVObjGetByID.
+ *             Automatically generated by the UAVObjectGenerator.
+ *
+ * @note       This is an automatically generated file.
+ *             DO NOT modify manually.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+
+/*
+ * The handle accessors are weak references so that objects which are not
+ * built into this firmware resolve to NULL instead of failing to link.
+ */
+$(OBJINDEXDECL)
+const struct UAVOIndexEntry uavo_index[] = {
+$(OBJINDEX)};
+
+const uint16_t uavo_index_count = sizeof(uavo_index) / sizeof(uavo_index[0]);
+
+/**
+ * @}
+ * @}
+ */
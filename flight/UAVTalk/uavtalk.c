@@ -43,6 +43,7 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId);
 static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t* data, int32_t length);
 static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static UAVTalkRxState processInputByte(UAVTalkConnectionData *connection, uint8_t rxbyte);
 
 /**
  * Initialize the UAVTalk library
@@ -300,6 +301,17 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 	UAVTalkConnectionData *connection;
     CHECKCONHANDLE(connectionHandle,connection,return -1);
 
+	return processInputByte(connection, rxbyte);
+}
+
+/**
+ * Run the receive state machine on a single byte
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] rxbyte Received byte
+ * \return UAVTalkRxState
+ */
+static UAVTalkRxState processInputByte(UAVTalkConnectionData *connection, uint8_t rxbyte)
+{
 	UAVTalkInputProcessor *iproc = &connection->iproc;
 	++connection->stats.rxBytes;
 
@@ -561,6 +573,67 @@ UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uin
 	return state;
 }
 
+/**
+ * Process a chunk of bytes from the telemetry stream. Every complete packet found
+ * in the chunk is handled the same way as by UAVTalkProcessInputStream. Bytes
+ * preceding a sync byte are skipped and object payloads are copied and checksummed
+ * as blocks instead of running the state machine on each byte.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] rxbuffer Received bytes
+ * \param[in] length Number of bytes in rxbuffer
+ * \return UAVTalkRxState after the last byte of the chunk
+ */
+UAVTalkRxState UAVTalkProcessInputBuffer(UAVTalkConnection connectionHandle, const uint8_t *rxbuffer, uint16_t length)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+	uint16_t position = 0;
+
+	while (position < length) {
+		uint16_t remaining = length - position;
+
+		if (iproc->state == UAVTALK_STATE_SYNC || iproc->state == UAVTALK_STATE_ERROR ||
+				iproc->state == UAVTALK_STATE_COMPLETE) {
+			// Skip straight to the next sync byte
+			const uint8_t *sync = memchr(&rxbuffer[position], UAVTALK_SYNC_VAL, remaining);
+			uint16_t skipped = sync ? (uint16_t)(sync - &rxbuffer[position]) : remaining;
+
+			connection->stats.rxBytes += skipped;
+			position += skipped;
+			if (position >= length)
+				break;
+		} else if (iproc->state == UAVTALK_STATE_DATA) {
+			// Copy as much of the payload as this chunk holds and checksum it as a block
+			uint16_t count = iproc->length - iproc->rxCount;
+			if (count > remaining)
+				count = remaining;
+
+			memcpy(&connection->rxBuffer[iproc->rxCount], &rxbuffer[position], count);
+			iproc->cs = PIOS_CRC_updateCRC(iproc->cs, &rxbuffer[position], count);
+			iproc->rxCount += count;
+			iproc->rxPacketLength += count;
+			connection->stats.rxBytes += count;
+			position += count;
+
+			if (iproc->rxCount >= iproc->length) {
+				iproc->state = UAVTALK_STATE_CS;
+				iproc->rxCount = 0;
+			}
+			continue;
+		}
+
+		if (processInputByte(connection, rxbuffer[position++]) == UAVTALK_STATE_COMPLETE) {
+			xSemaphoreTakeRecursive(connection->lock, portMAX_DELAY);
+			receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer, iproc->length);
+			xSemaphoreGiveRecursive(connection->lock);
+		}
+	}
+
+	return iproc->state;
+}
+
 /**
  * Process an byte from the telemetry stream, sending the packet out the output stream when it's complete
  * This allows the interlieving of packets on an output UAVTalk stream, and is used by the OPLink device to
@@ -242,6 +242,7 @@ static const struct flashfs_logfs_cfg flashfs_settings_cfg = {
 	.fs_magic      = 0x99abcfef,
 	.arena_size    = 0x00004000, /* 64 * slot size = 16K bytes = 1 sector */
 	.slot_size     = 0x00000100, /* 256 bytes */
+	.ram_directory = true, /* 8 bytes of RAM per slot */
 };
 
 #include "pios_flash_internal_priv.h"
@@ -573,6 +573,7 @@ static const struct flashfs_logfs_cfg flashfs_settings_cfg = {
 	.fs_magic      = 0x3bb141cf,
 	.arena_size    = 0x00010000, /* 256 * slot size */
 	.slot_size     = 0x00000100, /* 256 bytes */
+	.ram_directory = true, /* 8 bytes of RAM per slot */
 };
 
 static const struct flashfs_logfs_cfg flashfs_waypoints_cfg = {
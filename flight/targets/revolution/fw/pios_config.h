@@ -60,6 +60,7 @@
 #define PIOS_INCLUDE_HMC5883
 #define PIOS_INCLUDE_MPU6000
 #define PIOS_MPU6000_ACCEL
+#define PIOS_MPU6000_FIFO_BURST 8	/* most samples read from the FIFO at once at high sample rates */
 #define PIOS_INCLUDE_L3GD20
 #define PIOS_INCLUDE_MS5611
 //#define PIOS_INCLUDE_ETASV3
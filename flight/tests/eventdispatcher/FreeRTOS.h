@@ -0,0 +1,29 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffff
+#define portTICK_RATE_MS 1
+#define tskIDLE_PRIORITY 0
+#define configMINIMAL_STACK_SIZE 128
+
+typedef void * xQueueHandle;
+typedef void * xSemaphoreHandle;
+typedef void * xTaskHandle;
+
+#define pvPortMalloc(xSize) (malloc(xSize))
+#define vPortFree(pv) (free(pv))
+
+/* The unit tests are single threaded so the mutexes never block */
+static inline xSemaphoreHandle xSemaphoreCreateRecursiveMutex(void) { return (xSemaphoreHandle) 1; }
+static inline int xSemaphoreTakeRecursive(xSemaphoreHandle m, uint32_t t) { (void) m; (void) t; return pdTRUE; }
+static inline int xSemaphoreGiveRecursive(xSemaphoreHandle m) { (void) m; return pdTRUE; }
+
+/* The task and the clock are run by the test, see eventdispatcher_ut.c */
+extern int xTaskCreate(void (*task)(void *), const signed char * name, uint16_t stack, void * params, uint32_t priority, xTaskHandle * handle);
+extern uint32_t xTaskGetTickCount(void);
+
+extern xQueueHandle xQueueCreate(uint32_t length, uint32_t item_size);
+extern int xQueueSend(xQueueHandle queue, const void * item, uint32_t ticks);
+extern int xQueueReceive(xQueueHandle queue, void * item, uint32_t ticks);
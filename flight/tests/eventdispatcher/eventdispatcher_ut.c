@@ -0,0 +1,60 @@
+#include "openpilot.h"
+
+#include <setjmp.h>
+
+/* System time in ms, only advanced by the event task sleeping or by the test */
+uint32_t ut_ticks;
+
+static void (*ut_event_task)(void *);
+static uint32_t ut_waits_left;
+static jmp_buf ut_task_exit;
+
+int xTaskCreate(void (*task)(void *), const signed char * name, uint16_t stack, void * params, uint32_t priority, xTaskHandle * handle)
+{
+	ut_event_task = task;
+	return pdTRUE;
+}
+
+uint32_t xTaskGetTickCount(void)
+{
+	return ut_ticks;
+}
+
+xQueueHandle xQueueCreate(uint32_t length, uint32_t item_size)
+{
+	return (xQueueHandle) 1;
+}
+
+/* Nothing reads the queues the tests connect */
+int xQueueSend(xQueueHandle queue, const void * item, uint32_t ticks)
+{
+	return pdTRUE;
+}
+
+/* No events are ever queued, so waiting on the queue sleeps for the whole timeout */
+int xQueueReceive(xQueueHandle queue, void * item, uint32_t ticks)
+{
+	if (ut_waits_left == 0)
+		longjmp(ut_task_exit, 1);
+
+	ut_waits_left--;
+	ut_ticks += ticks;
+	return pdFALSE;
+}
+
+void ut_run_event_task(uint32_t waits)
+{
+	ut_waits_left = waits;
+	if (setjmp(ut_task_exit) == 0)
+		ut_event_task(NULL);
+}
+
+int32_t TaskMonitorAdd(uint32_t task, xTaskHandle handle)
+{
+	return 0;
+}
+
+uint32_t UAVObjGetID(UAVObjHandle obj)
+{
+	return 0;
+}
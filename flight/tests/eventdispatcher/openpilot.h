@@ -0,0 +1,13 @@
+#include <pios.h>
+
+#include "utlist.h"
+#include "uavobjectmanager.h"
+#include "eventdispatcher.h"
+
+/* Would be from taskmonitor.h and the generated taskinfo.h */
+#define TASKINFO_RUNNING_EVENTDISPATCHER 0
+extern int32_t TaskMonitorAdd(uint32_t task, xTaskHandle handle);
+
+/* Runs the event task until it has waited on its queue this many times */
+extern void ut_run_event_task(uint32_t waits);
+extern uint32_t ut_ticks;
@@ -0,0 +1,13 @@
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+/* C Lib Includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+/* FreeRTOS Includes */
+#include "FreeRTOS.h"
+#endif
@@ -0,0 +1,120 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "openpilot.h"
+
+}
+
+static uint32_t fires;
+
+static void countFire(UAVObjEvent *)
+{
+  fires++;
+}
+
+class EventDispatcherTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ut_ticks = 0;
+    fires = 0;
+    EXPECT_EQ(0, EventDispatcherInitialize());
+
+    memset(&ev, 0, sizeof(ev));
+    ev.event = EV_UPDATED_PERIODIC;
+  }
+
+  EventStats getStats() {
+    EventStats stats;
+    EventGetStats(&stats);
+    return stats;
+  }
+
+  UAVObjEvent ev;
+};
+
+TEST_F(EventDispatcherTest, RegisteredLateIsOnTime) {
+  /* Let the system run for a while before anything is scheduled */
+  ut_run_event_task(5);
+  EXPECT_GE(ut_ticks, 4000u);
+
+  EXPECT_EQ(0, EventPeriodicCallbackCreate(&ev, countFire, 100));
+  ut_run_event_task(50);
+  EXPECT_GE(fires, 40u);
+
+  EventStats stats = getStats();
+  EXPECT_EQ(fires, stats.eventsDispatched);
+  EXPECT_EQ(0u, stats.lateEvents);
+  EXPECT_EQ(0u, stats.maxJitterMs);
+}
+
+TEST_F(EventDispatcherTest, UpdatedLateIsOnTime) {
+  EXPECT_EQ(0, EventPeriodicCallbackCreate(&ev, countFire, 100));
+  ut_run_event_task(20);
+
+  /* Rescheduling after a while starts from the current time too */
+  ut_ticks += 5000;
+  EXPECT_EQ(0, EventPeriodicCallbackUpdate(&ev, countFire, 50));
+  ut_run_event_task(20);
+
+  EventStats stats = getStats();
+  EXPECT_EQ(0u, stats.lateEvents);
+  EXPECT_EQ(0u, stats.maxJitterMs);
+}
+
+TEST_F(EventDispatcherTest, LateWakeIsCounted) {
+  EXPECT_EQ(0, EventPeriodicCallbackCreate(&ev, countFire, 100));
+  ut_run_event_task(10);
+  EXPECT_EQ(0u, getStats().lateEvents);
+
+  /* The next deadline is at most 100 ms away, stall the task past it */
+  ut_ticks += 250;
+  ut_run_event_task(1);
+
+  EventStats stats = getStats();
+  EXPECT_EQ(1u, stats.lateEvents);
+  EXPECT_GE(stats.maxJitterMs, 150u);
+  EXPECT_LE(stats.maxJitterMs, 250u);
+
+  EventClearStats();
+  EXPECT_EQ(0u, getStats().lateEvents);
+  EXPECT_EQ(0u, getStats().maxJitterMs);
+}
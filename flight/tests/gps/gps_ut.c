@@ -0,0 +1,40 @@
+#include "openpilot.h"
+#include "GPS.h"
+
+/* The tests look at the last value written to each object */
+GPSPositionData ut_gpsposition;
+GPSVelocityData ut_gpsvelocity;
+GPSSatellitesData ut_gpssatellites;
+GPSTimeData ut_gpstime;
+uint32_t ut_gpsposition_sets;
+
+int32_t GPSPositionSet(GPSPositionData *data)
+{
+	ut_gpsposition = *data;
+	ut_gpsposition_sets++;
+	return 0;
+}
+
+int32_t GPSVelocitySet(GPSVelocityData *data)
+{
+	ut_gpsvelocity = *data;
+	return 0;
+}
+
+int32_t GPSSatellitesSet(GPSSatellitesData *data)
+{
+	ut_gpssatellites = *data;
+	return 0;
+}
+
+int32_t GPSTimeGet(GPSTimeData *data)
+{
+	*data = ut_gpstime;
+	return 0;
+}
+
+int32_t GPSTimeSet(GPSTimeData *data)
+{
+	ut_gpstime = *data;
+	return 0;
+}
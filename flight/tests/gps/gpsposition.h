@@ -0,0 +1,30 @@
+#ifndef GPSPOSITION_H
+#define GPSPOSITION_H
+
+/* Would be generated from gpsposition.xml */
+#define GPSPOSITION_OBJID 0x1
+
+typedef struct {
+	uint8_t Status;
+	int32_t Latitude;
+	int32_t Longitude;
+	float Altitude;
+	float GeoidSeparation;
+	float Heading;
+	float Groundspeed;
+	int8_t Satellites;
+	float PDOP;
+	float HDOP;
+	float VDOP;
+} GPSPositionData;
+
+typedef enum {
+	GPSPOSITION_STATUS_NOGPS = 0,
+	GPSPOSITION_STATUS_NOFIX = 1,
+	GPSPOSITION_STATUS_FIX2D = 2,
+	GPSPOSITION_STATUS_FIX3D = 3,
+} GPSPositionStatusOptions;
+
+int32_t GPSPositionSet(GPSPositionData *data);
+
+#endif /* GPSPOSITION_H */
@@ -0,0 +1,17 @@
+#ifndef GPSSATELLITES_H
+#define GPSSATELLITES_H
+
+/* Would be generated from gpssatellites.xml */
+#define GPSSATELLITES_PRN_NUMELEM 16
+
+typedef struct {
+	int8_t SatsInView;
+	int8_t PRN[16];
+	float Elevation[16];
+	float Azimuth[16];
+	int8_t SNR[16];
+} GPSSatellitesData;
+
+int32_t GPSSatellitesSet(GPSSatellitesData *data);
+
+#endif /* GPSSATELLITES_H */
@@ -0,0 +1,17 @@
+#ifndef GPSTIME_H
+#define GPSTIME_H
+
+/* Would be generated from gpstime.xml */
+typedef struct {
+	int8_t Month;
+	int8_t Day;
+	int16_t Year;
+	int8_t Hour;
+	int8_t Minute;
+	int8_t Second;
+} GPSTimeData;
+
+int32_t GPSTimeGet(GPSTimeData *data);
+int32_t GPSTimeSet(GPSTimeData *data);
+
+#endif /* GPSTIME_H */
@@ -0,0 +1,13 @@
+#ifndef GPSVELOCITY_H
+#define GPSVELOCITY_H
+
+/* Would be generated from gpsvelocity.xml */
+typedef struct {
+	float North;
+	float East;
+	float Down;
+} GPSVelocityData;
+
+int32_t GPSVelocitySet(GPSVelocityData *data);
+
+#endif /* GPSVELOCITY_H */
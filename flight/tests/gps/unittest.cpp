@@ -0,0 +1,405 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test and throughput of the UBX and NMEA stream parsers
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* getenv */
+#include <string.h>		/* memcpy */
+#include <time.h>		/* clock_gettime */
+#include <string>
+#include <vector>
+
+extern "C" {
+
+#include "GPS.h"		/* struct GPS_RX_STATS, PARSER_* */
+#include "NMEA.h"		/* parse_nmea_buffer */
+
+/* UBX.h names a struct member 'class' so it can't be included from C++ */
+int parse_ubx_buffer(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+
+extern GPSPositionData ut_gpsposition;
+extern GPSVelocityData ut_gpsvelocity;
+extern GPSSatellitesData ut_gpssatellites;
+extern GPSTimeData ut_gpstime;
+extern uint32_t ut_gpsposition_sets;
+
+}
+
+// Large enough for struct UBXPacket and for NMEA_MAX_PACKET_LENGTH
+#define RX_BUFFER_LEN 256
+
+// The size of one COM read in the GPS module
+#define READ_LEN 64
+
+typedef std::vector<uint8_t> Bytes;
+
+static void put8(Bytes &b, uint8_t v) { b.push_back(v); }
+static void put16(Bytes &b, uint16_t v) { put8(b, v); put8(b, v >> 8); }
+static void put32(Bytes &b, uint32_t v) { put16(b, v); put16(b, v >> 16); }
+
+// Appends a UBX frame with its sync characters and checksum
+static void ubx(Bytes &out, uint8_t cls, uint8_t id, const Bytes &payload)
+{
+  Bytes frame;
+  put8(frame, cls);
+  put8(frame, id);
+  put16(frame, payload.size());
+  frame.insert(frame.end(), payload.begin(), payload.end());
+
+  uint8_t ck_a = 0, ck_b = 0;
+  for (size_t i = 0; i < frame.size(); i++) {
+    ck_a += frame[i];
+    ck_b += ck_a;
+  }
+
+  put8(out, 0xb5);
+  put8(out, 0x62);
+  out.insert(out.end(), frame.begin(), frame.end());
+  put8(out, ck_a);
+  put8(out, ck_b);
+}
+
+// Appends the messages the UBX parser combines into one GPSPosition update
+static void ubxEpoch(Bytes &out, uint32_t tow, bool full)
+{
+  Bytes p;
+
+  // NAV-SOL, 3D fix with 9 satellites
+  put32(p, tow); put32(p, 0); put16(p, 1700); put8(p, 0x03); put8(p, 0x01);
+  for (int i = 0; i < 3; i++) put32(p, 0);
+  put32(p, 250);
+  for (int i = 0; i < 3; i++) put32(p, 0);
+  put32(p, 40); put16(p, 150); put8(p, 0); put8(p, 9); put32(p, 0);
+  ubx(out, 0x01, 0x06, p);
+
+  // NAV-POSLLH
+  p.clear();
+  put32(p, tow); put32(p, 113000000); put32(p, 481173000); put32(p, 592300); put32(p, 545400);
+  put32(p, 1200); put32(p, 2400);
+  ubx(out, 0x01, 0x02, p);
+
+  // NAV-DOP
+  p.clear();
+  put32(p, tow);
+  put16(p, 180); put16(p, 150); put16(p, 90); put16(p, 110); put16(p, 95); put16(p, 60); put16(p, 70);
+  ubx(out, 0x01, 0x04, p);
+
+  // NAV-VELNED
+  p.clear();
+  put32(p, tow); put32(p, 120); put32(p, -340); put32(p, 15); put32(p, 361); put32(p, 360);
+  put32(p, 28942000); put32(p, 50); put32(p, 100000);
+  ubx(out, 0x01, 0x12, p);
+
+  if (!full)
+    return;
+
+  // NAV-TIMEUTC
+  p.clear();
+  put32(p, tow); put32(p, 30); put32(p, 0); put16(p, 2013); put8(p, 6); put8(p, 21);
+  put8(p, 12); put8(p, 34); put8(p, 56); put8(p, 0x07);
+  ubx(out, 0x01, 0x21, p);
+
+  // NAV-SVINFO, 12 channels
+  p.clear();
+  put32(p, tow); put8(p, 12); put8(p, 0); put16(p, 0);
+  for (int i = 0; i < 12; i++) {
+    put8(p, i); put8(p, i + 1); put8(p, 0x0d); put8(p, 7); put8(p, 30 + i); put8(p, 10 + 5 * i);
+    put16(p, 30 * i); put32(p, 0);
+  }
+  ubx(out, 0x01, 0x30, p);
+}
+
+// Appends an NMEA sentence with its checksum and terminator
+static void nmea(Bytes &out, const char *body)
+{
+  uint8_t checksum = 0;
+  for (const char *c = body; *c; c++)
+    checksum ^= *c;
+
+  char sentence[128];
+  int len = snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+  out.insert(out.end(), sentence, sentence + len);
+}
+
+// Appends one second of output from an NMEA receiver
+static void nmeaEpoch(Bytes &out, bool full)
+{
+  nmea(out, "GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1");
+  nmea(out, "GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,210613,003.1,W,A");
+  nmea(out, "GPVTG,054.7,T,034.4,M,005.5,N,010.2,K");
+  nmea(out, "GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+
+  if (!full)
+    return;
+
+  nmea(out, "GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00");
+  nmea(out, "GPGSV,3,2,11,14,25,170,00,16,57,208,39,18,67,296,40,19,40,246,00");
+  nmea(out, "GPGSV,3,3,11,22,42,067,42,24,14,311,43,27,05,244,00");
+}
+
+// Reads a raw capture of a GPS port
+static bool loadCapture(const char *path, Bytes &out)
+{
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return false;
+
+  uint8_t block[4096];
+  size_t n;
+  while ((n = fread(block, 1, sizeof(block), file)) > 0)
+    out.insert(out.end(), block, block + n);
+  fclose(file);
+
+  return !out.empty();
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class GpsParser : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(&position, 0, sizeof(position));
+    memset(&stats, 0, sizeof(stats));
+    memset(&ut_gpsposition, 0, sizeof(ut_gpsposition));
+    memset(&ut_gpsvelocity, 0, sizeof(ut_gpsvelocity));
+    ut_gpsposition_sets = 0;
+  }
+
+  virtual void TearDown() {
+  }
+
+  // Hands the stream to a parser the way the GPS module does, one COM read
+  // at a time. Returns the number of reads that completed a message.
+  int feed(const Bytes &stream, size_t readLen, bool ubxProtocol) {
+    uint8_t read[READ_LEN];
+    int completed = 0;
+
+    for (size_t i = 0; i < stream.size(); i += readLen) {
+      uint16_t len = stream.size() - i < readLen ? stream.size() - i : readLen;
+      memcpy(read, &stream[i], len);
+
+      int res;
+      if (ubxProtocol)
+        res = parse_ubx_buffer(read, len, rxBuffer, &position, &stats);
+      else
+        res = parse_nmea_buffer((char *) read, len, rxBuffer, &position, &stats);
+      if (res == PARSER_COMPLETE)
+        completed++;
+    }
+
+    return completed;
+  }
+
+  // Returns the parsed bytes per second at the given read size
+  double throughput(const Bytes &stream, size_t readLen, bool ubxProtocol) {
+    int passes = 0;
+    double start = now(), elapsed;
+    do {
+      feed(stream, readLen, ubxProtocol);
+      passes++;
+      elapsed = now() - start;
+    } while (elapsed < 0.2);
+
+    return (double) stream.size() * passes / elapsed;
+  }
+
+  // Each test starts a new message set, the UBX parser ignores older ones
+  static uint32_t nextTow() {
+    static uint32_t tow = 1000;
+    return tow += 200;
+  }
+
+  char rxBuffer[RX_BUFFER_LEN];
+  GPSPositionData position;
+  struct GPS_RX_STATS stats;
+};
+
+TEST_F(GpsParser, UbxAtEveryReadSize) {
+  for (size_t readLen = 1; readLen <= READ_LEN; readLen++) {
+    Bytes stream;
+    ubxEpoch(stream, nextTow(), true);
+
+    ut_gpsposition_sets = 0;
+    memset(&stats, 0, sizeof(stats));
+    EXPECT_GT(feed(stream, readLen, true), 0) << "read size " << readLen;
+
+    EXPECT_EQ(6, stats.gpsRxReceived) << "read size " << readLen;
+    EXPECT_EQ(0, stats.gpsRxChkSumError);
+    EXPECT_EQ(0, stats.gpsRxOverflow);
+    EXPECT_EQ(1u, ut_gpsposition_sets) << "read size " << readLen;
+  }
+
+  EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, ut_gpsposition.Status);
+  EXPECT_EQ(481173000, ut_gpsposition.Latitude);
+  EXPECT_EQ(113000000, ut_gpsposition.Longitude);
+  EXPECT_FLOAT_EQ(545.4f, ut_gpsposition.Altitude);
+  EXPECT_FLOAT_EQ(46.9f, ut_gpsposition.GeoidSeparation);
+  EXPECT_EQ(9, ut_gpsposition.Satellites);
+  EXPECT_FLOAT_EQ(1.5f, ut_gpsposition.PDOP);
+  EXPECT_FLOAT_EQ(3.6f, ut_gpsposition.Groundspeed);
+  EXPECT_FLOAT_EQ(289.42f, ut_gpsposition.Heading);
+  EXPECT_FLOAT_EQ(1.2f, ut_gpsvelocity.North);
+  EXPECT_FLOAT_EQ(-3.4f, ut_gpsvelocity.East);
+
+  EXPECT_EQ(2013, ut_gpstime.Year);
+  EXPECT_EQ(56, ut_gpstime.Second);
+  EXPECT_EQ(12, ut_gpssatellites.SatsInView);
+  EXPECT_EQ(12, ut_gpssatellites.PRN[11]);
+  EXPECT_EQ(0, ut_gpssatellites.PRN[12]);
+}
+
+TEST_F(GpsParser, UbxChecksumError) {
+  Bytes bad, good;
+  ubxEpoch(bad, nextTow(), false);
+  bad[10] ^= 0x40;	// inside the NAV-SOL payload
+  ubxEpoch(good, nextTow(), false);
+
+  feed(bad, READ_LEN, true);
+  EXPECT_EQ(1, stats.gpsRxChkSumError);
+  EXPECT_EQ(3, stats.gpsRxReceived);
+  EXPECT_EQ(0u, ut_gpsposition_sets);
+
+  feed(good, READ_LEN, true);
+  EXPECT_EQ(1, stats.gpsRxChkSumError);
+  EXPECT_EQ(7, stats.gpsRxReceived);
+  EXPECT_EQ(1u, ut_gpsposition_sets);
+}
+
+TEST_F(GpsParser, UbxResyncAfterNoise) {
+  // Stray sync characters and an oversized length in the noise
+  const uint8_t noise[] = { 0x00, 0xb5, 0xb5, 0x62, 0x01, 0x02, 0xff, 0xff, 0x24, 0xb5, 0x13 };
+  Bytes stream(noise, noise + sizeof(noise));
+  ubxEpoch(stream, nextTow(), false);
+
+  for (size_t readLen = 1; readLen <= READ_LEN; readLen *= 2) {
+    memset(&stats, 0, sizeof(stats));
+    feed(stream, readLen, true);
+    EXPECT_EQ(1, stats.gpsRxOverflow) << "read size " << readLen;
+    EXPECT_EQ(4, stats.gpsRxReceived) << "read size " << readLen;
+  }
+}
+
+TEST_F(GpsParser, NmeaAtEveryReadSize) {
+  Bytes stream;
+  nmeaEpoch(stream, true);
+
+  for (size_t readLen = 1; readLen <= READ_LEN; readLen++) {
+    ut_gpsposition_sets = 0;
+    memset(&stats, 0, sizeof(stats));
+    EXPECT_GT(feed(stream, readLen, false), 0) << "read size " << readLen;
+
+    EXPECT_EQ(7, stats.gpsRxReceived) << "read size " << readLen;
+    EXPECT_EQ(0, stats.gpsRxChkSumError);
+    EXPECT_EQ(0, stats.gpsRxParserError);
+    EXPECT_EQ(0, stats.gpsRxOverflow);
+    EXPECT_EQ(1u, ut_gpsposition_sets) << "read size " << readLen;
+  }
+
+  EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, ut_gpsposition.Status);
+  EXPECT_NEAR(481173000, ut_gpsposition.Latitude, 1);
+  EXPECT_NEAR(115166666, ut_gpsposition.Longitude, 1);
+  EXPECT_FLOAT_EQ(545.4f, ut_gpsposition.Altitude);
+  EXPECT_FLOAT_EQ(46.9f, ut_gpsposition.GeoidSeparation);
+  EXPECT_EQ(8, ut_gpsposition.Satellites);
+  EXPECT_FLOAT_EQ(2.5f, ut_gpsposition.PDOP);
+  EXPECT_FLOAT_EQ(1.3f, ut_gpsposition.HDOP);
+  EXPECT_FLOAT_EQ(54.7f, ut_gpsposition.Heading);
+
+  EXPECT_EQ(2013, ut_gpstime.Year);
+  EXPECT_EQ(35, ut_gpstime.Minute);
+  EXPECT_EQ(11, ut_gpssatellites.SatsInView);
+  EXPECT_EQ(27, ut_gpssatellites.PRN[10]);
+}
+
+TEST_F(GpsParser, NmeaErrors) {
+  Bytes stream;
+
+  // Corrupted character
+  nmea(stream, "GPVTG,054.7,T,034.4,M,005.5,N,010.2,K");
+  stream[8] = '6';
+
+  // Missing checksum
+  const char *unterminated = "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K\r\n";
+  stream.insert(stream.end(), unterminated, unterminated + strlen(unterminated));
+
+  // Longer than any valid sentence
+  stream.push_back('$');
+  stream.insert(stream.end(), NMEA_MAX_PACKET_LENGTH, 'A');
+
+  nmea(stream, "GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+
+  for (size_t readLen = 1; readLen <= READ_LEN; readLen *= 2) {
+    ut_gpsposition_sets = 0;
+    memset(&stats, 0, sizeof(stats));
+    feed(stream, readLen, false);
+
+    EXPECT_EQ(2, stats.gpsRxChkSumError) << "read size " << readLen;
+    EXPECT_EQ(1, stats.gpsRxOverflow) << "read size " << readLen;
+    EXPECT_EQ(1, stats.gpsRxReceived) << "read size " << readLen;
+    EXPECT_EQ(1u, ut_gpsposition_sets) << "read size " << readLen;
+  }
+}
+
+TEST_F(GpsParser, BytesPerSecond) {
+  // Raw captures of a GPS port can be replayed in place of the synthetic
+  // streams, which hold 10 Hz solutions with satellite information
+  Bytes ubxStream, nmeaStream;
+  const char *ubxCapture = getenv("GPS_BENCH_UBX");
+  const char *nmeaCapture = getenv("GPS_BENCH_NMEA");
+
+  if (!ubxCapture || !loadCapture(ubxCapture, ubxStream)) {
+    for (int i = 0; i < 1000; i++)
+      ubxEpoch(ubxStream, nextTow(), true);
+  }
+  if (!nmeaCapture || !loadCapture(nmeaCapture, nmeaStream)) {
+    for (int i = 0; i < 1000; i++)
+      nmeaEpoch(nmeaStream, true);
+  }
+
+  printf("Bytes/s parsed on this host:\n");
+  printf("            %10s %10s\n", "1 byte", "64 bytes");
+  printf("  UBX       %10.3g %10.3g\n", throughput(ubxStream, 1, true), throughput(ubxStream, READ_LEN, true));
+  printf("  NMEA      %10.3g %10.3g\n", throughput(nmeaStream, 1, false), throughput(nmeaStream, READ_LEN, false));
+
+  // Every synthetic message makes it through
+  if (!ubxCapture) {
+    EXPECT_EQ(0, stats.gpsRxChkSumError);
+    EXPECT_EQ(0, stats.gpsRxOverflow);
+  }
+}
@@ -0,0 +1,189 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memcmp */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "insgps.h"		/* API for the INS/GPS filter */
+
+}
+
+#include <math.h>		/* sinf() */
+
+// To use a test fixture, derive a class from testing::Test.
+class InsGps : public testing::Test {
+protected:
+  virtual void SetUp() {
+    const float Be[3] = { 0.4f, 0.05f, 0.9f };
+
+    INSGPSInit();
+    INSSetMagNorth(Be);
+
+    insgps_init(&ins);
+    insgps_set_mag_north(&ins, Be);
+  }
+
+  virtual void TearDown() {
+  }
+
+  // Drives a filter through a short, gently rotating trajectory with GPS,
+  // mag and baro updates at a lower rate than the prediction
+  void step(struct insgps_state *filter, int i, float scale) {
+    const float dT = 0.002f;
+    float gyro[3] = { 0.1f * scale * sinf(i * 0.01f), 0.05f * scale, -0.02f * scale };
+    float accel[3] = { 0.1f * scale, -0.2f * scale, -9.81f };
+    float mag[3] = { 0.4f + 0.01f * sinf(i * 0.02f), 0.05f, 0.9f };
+    float pos[3] = { 0.001f * i * scale, -0.002f * i, -0.5f };
+    float vel[3] = { 0.5f * scale, -1.0f, 0.0f };
+    float baro = 0.5f + 0.01f * scale;
+
+    uint16_t sensors = (i % 5 == 0) ? MAG_SENSORS | BARO_SENSOR : 0;
+    if (i % 50 == 0)
+      sensors |= POS_SENSORS | HORIZ_SENSORS | VERT_SENSORS;
+
+    if (filter) {
+      insgps_state_prediction(filter, gyro, accel, dT);
+      insgps_covariance_prediction(filter, dT);
+      if (sensors)
+        insgps_correction(filter, mag, pos, vel, baro, sensors);
+    } else {
+      INSStatePrediction(gyro, accel, dT);
+      INSCovariancePrediction(dT);
+      if (sensors)
+        INSCorrection(mag, pos, vel, baro, sensors);
+    }
+  }
+
+  struct insgps_state ins;
+};
+
+TEST_F(InsGps, InitialState) {
+  float pos[3], vel[3], q[4], bias[3];
+  float var[INSGPS_NUMX];
+
+  insgps_get_state(&ins, pos, vel, q, bias);
+  EXPECT_EQ(1.0f, q[0]);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(0.0f, pos[i]);
+    EXPECT_EQ(0.0f, vel[i]);
+    EXPECT_EQ(0.0f, q[i + 1]);
+    EXPECT_EQ(0.0f, bias[i]);
+  }
+
+  insgps_get_variance(&ins, var);
+  EXPECT_EQ(25.0f, var[0]);
+  EXPECT_EQ(5.0f, var[3]);
+  EXPECT_EQ(1e-5f, var[6]);
+  EXPECT_EQ(1e-9f, var[10]);
+
+  EXPECT_EQ(INSGPS_NUMX, ins_get_num_states());
+}
+
+TEST_F(InsGps, DefaultInstanceMatchesInstance) {
+  for (int i = 0; i < 1000; i++) {
+    step(&ins, i, 1.0f);
+    step(NULL, i, 1.0f);
+  }
+
+  float pos[2][3], vel[2][3], q[2][4], bias[2][3];
+  float var[2][INSGPS_NUMX];
+
+  INSGetState(pos[0], vel[0], q[0], bias[0]);
+  INSGetVariance(var[0]);
+  insgps_get_state(&ins, pos[1], vel[1], q[1], bias[1]);
+  insgps_get_variance(&ins, var[1]);
+
+  // Same arithmetic in the same order, so bit for bit equal
+  EXPECT_EQ(0, memcmp(pos[0], pos[1], sizeof(pos[0])));
+  EXPECT_EQ(0, memcmp(vel[0], vel[1], sizeof(vel[0])));
+  EXPECT_EQ(0, memcmp(q[0], q[1], sizeof(q[0])));
+  EXPECT_EQ(0, memcmp(bias[0], bias[1], sizeof(bias[0])));
+  EXPECT_EQ(0, memcmp(var[0], var[1], sizeof(var[0])));
+}
+
+TEST_F(InsGps, InstancesAreIndependent) {
+  struct insgps_state other;
+  struct insgps_state reference;
+  const float Be[3] = { 0.4f, 0.05f, 0.9f };
+
+  insgps_init(&other);
+  insgps_set_mag_north(&other, Be);
+  insgps_init(&reference);
+  insgps_set_mag_north(&reference, Be);
+
+  const float accel_var[3] = { 1e-3f, 1e-3f, 1e-3f };
+  insgps_set_accel_var(&other, accel_var);
+  insgps_set_baro_var(&other, 4.0f);
+
+  // Interleave a differently tuned filter fed different data
+  for (int i = 0; i < 500; i++) {
+    step(&ins, i, 1.0f);
+    step(&other, i, 3.0f);
+    step(NULL, i, 2.0f);
+  }
+  for (int i = 0; i < 500; i++)
+    step(&reference, i, 1.0f);
+
+  EXPECT_EQ(0, memcmp(ins.X, reference.X, sizeof(ins.X)));
+  EXPECT_EQ(0, memcmp(ins.P, reference.P, sizeof(ins.P)));
+  EXPECT_NE(0, memcmp(ins.X, other.X, sizeof(ins.X)));
+}
+
+TEST_F(InsGps, SettersTargetTheirInstance) {
+  struct insgps_state before = ins;
+
+  const float gyro_var[3] = { 1.0f, 2.0f, 3.0f };
+  const float mag_var[3] = { 4.0f, 5.0f, 6.0f };
+  INSSetGyroVar(gyro_var);
+  INSSetMagVar(mag_var);
+  INSSetBaroVar(7.0f);
+  EXPECT_EQ(0, memcmp(&before, &ins, sizeof(ins)));
+
+  insgps_set_gyro_var(&ins, gyro_var);
+  insgps_set_mag_var(&ins, mag_var);
+  insgps_set_baro_var(&ins, 7.0f);
+  insgps_set_pos_vel_var(&ins, 8.0f, 9.0f, 10.0f);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(gyro_var[i], ins.Q[i]);
+    EXPECT_EQ(mag_var[i], ins.R[6 + i]);
+  }
+  EXPECT_EQ(7.0f, ins.R[9]);
+  EXPECT_EQ(8.0f, ins.R[0]);
+  EXPECT_EQ(9.0f, ins.R[3]);
+  EXPECT_EQ(10.0f, ins.R[2]);
+}
@@ -0,0 +1,157 @@
+/**
+ ******************************************************************************
+ * @file       insgps_dense.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Dense INS/GPS measurement update the benchmark compares against
+ *
+ * This is the correction step as it was before the sparse kernels: every
+ * measurement multiplies the full row of H into P and P is updated with
+ * Pnew = (I - K*H)*P.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "insgps.h"
+#include <math.h>
+
+#define NUMX INSGPS_NUMX
+#define NUMV INSGPS_NUMV
+
+static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
+		  float K[NUMX][NUMV], uint16_t SensorsUsed)
+{
+	float HP[NUMX], HPHR, Error;
+	uint8_t i, j, k, m;
+
+	for (m = 0; m < NUMV; m++) {
+
+		if (SensorsUsed & (0x01 << m)) {	// use this sensor for update
+
+			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
+				HP[j] = 0;
+				for (k = 0; k < NUMX; k++)
+					HP[j] += H[m][k] * P[k][j];
+			}
+			HPHR = R[m];	// Find  HPHR = H*P*H' + R
+			for (k = 0; k < NUMX; k++)
+				HPHR += HP[k] * H[m][k];
+
+			for (k = 0; k < NUMX; k++)
+				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
+
+			for (i = 0; i < NUMX; i++) {	// Find P(m)= P(m-1) + K*HP
+				for (j = i; j < NUMX; j++)
+					P[i][j] = P[j][i] =
+					    P[i][j] - K[i][m] * HP[j];
+			}
+
+			Error = Z[m] - Y[m];
+			for (i = 0; i < NUMX; i++)	// Find X(m)= X(m-1) + K*Error
+				X[i] = X[i] + K[i][m] * Error;
+
+		}
+	}
+}
+
+static void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
+{
+	float q0 = X[6], q1 = X[7], q2 = X[8], q3 = X[9];
+
+	Y[0] = X[0];
+	Y[1] = X[1];
+	Y[2] = X[2];
+	Y[3] = X[3];
+	Y[4] = X[4];
+	Y[5] = X[5];
+
+	Y[6] = (q0 * q0 + q1 * q1 - q2 * q2 - q3 * q3) * Be[0] +
+	    2.0f * (q1 * q2 + q0 * q3) * Be[1] + 2.0f * (q1 * q3 - q0 * q2) * Be[2];
+	Y[7] = 2.0f * (q1 * q2 - q0 * q3) * Be[0] +
+	    (q0 * q0 - q1 * q1 + q2 * q2 - q3 * q3) * Be[1] + 2.0f * (q2 * q3 + q0 * q1) * Be[2];
+	Y[8] = 2.0f * (q1 * q3 + q0 * q2) * Be[0] + 2.0f * (q2 * q3 - q0 * q1) * Be[1] +
+	    (q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3) * Be[2];
+
+	Y[9] = -1.0f * X[2];
+}
+
+static void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX])
+{
+	float q0 = X[6], q1 = X[7], q2 = X[8], q3 = X[9];
+
+	H[0][0] = H[1][1] = H[2][2] = 1.0f;
+	H[3][3] = H[4][4] = H[5][5] = 1.0f;
+
+	H[6][6] = 2.0f * (q0 * Be[0] + q3 * Be[1] - q2 * Be[2]);
+	H[6][7] = 2.0f * (q1 * Be[0] + q2 * Be[1] + q3 * Be[2]);
+	H[6][8] = 2.0f * (-q2 * Be[0] + q1 * Be[1] - q0 * Be[2]);
+	H[6][9] = 2.0f * (-q3 * Be[0] + q0 * Be[1] + q1 * Be[2]);
+	H[7][6] = 2.0f * (-q3 * Be[0] + q0 * Be[1] + q1 * Be[2]);
+	H[7][7] = 2.0f * (q2 * Be[0] - q1 * Be[1] + q0 * Be[2]);
+	H[7][8] = 2.0f * (q1 * Be[0] + q2 * Be[1] + q3 * Be[2]);
+	H[7][9] = 2.0f * (-q0 * Be[0] - q3 * Be[1] + q2 * Be[2]);
+	H[8][6] = 2.0f * (q2 * Be[0] - q1 * Be[1] + q0 * Be[2]);
+	H[8][7] = 2.0f * (q3 * Be[0] - q0 * Be[1] - q1 * Be[2]);
+	H[8][8] = 2.0f * (q0 * Be[0] + q3 * Be[1] - q2 * Be[2]);
+	H[8][9] = 2.0f * (q1 * Be[0] + q2 * Be[1] + q3 * Be[2]);
+
+	H[9][2] = -1.0f;
+}
+
+/**
+ * Same interface as insgps_correction(), using the dense update
+ */
+void insgps_dense_correction(struct insgps_state *ins, const float mag_data[3], const float Pos[3],
+		   const float Vel[3], float BaroAlt, uint16_t SensorsUsed)
+{
+	float *X = ins->X;
+	float Z[NUMV], Y[NUMV];
+	float Bmag, qmag;
+
+	Z[0] = Pos[0];
+	Z[1] = Pos[1];
+	Z[2] = Pos[2];
+
+	Z[3] = Vel[0];
+	Z[4] = Vel[1];
+	Z[5] = Vel[2];
+
+	Bmag = sqrtf(mag_data[0] * mag_data[0] + mag_data[1] * mag_data[1] +
+		 mag_data[2] * mag_data[2]);
+	Z[6] = mag_data[0] / Bmag;
+	Z[7] = mag_data[1] / Bmag;
+	Z[8] = mag_data[2] / Bmag;
+
+	Z[9] = BaroAlt;
+
+	LinearizeH(X, ins->Be, ins->H);
+	MeasurementEq(X, ins->Be, Y);
+	SerialUpdate(ins->H, ins->R, Z, Y, ins->P, X, ins->K, SensorsUsed);
+	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
+	X[6] /= qmag;
+	X[7] /= qmag;
+	X[8] /= qmag;
+	X[9] /= qmag;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,276 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Benchmark of the INS/GPS measurement update
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* getenv */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "insgps.h"		/* API for the INS/GPS filter */
+
+void insgps_dense_correction(struct insgps_state *ins, const float mag_data[3], const float Pos[3],
+		   const float Vel[3], float BaroAlt, uint16_t SensorsUsed);
+
+}
+
+#include <math.h>		/* sinf() */
+#include <time.h>		/* clock_gettime() */
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>		/* __rdtsc() */
+#define TICK_UNIT "cycles"
+static inline uint64_t ticks() { return __rdtsc(); }
+#else
+#define TICK_UNIT "ns"
+static inline uint64_t ticks() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+#endif
+
+// One filter update, in the form the attitude module feeds the filter
+struct Sample {
+  float dT;
+  float gyro[3];
+  float accel[3];
+  float mag[3];
+  float pos[3];
+  float vel[3];
+  float baro;
+  uint16_t sensors;
+};
+
+// To use a test fixture, derive a class from testing::Test.
+class InsGpsBench : public testing::Test {
+protected:
+  virtual void SetUp() {
+    const char *log = getenv("INSGPS_BENCH_LOG");
+    if (!log || !loadLog(log))
+      synthesize(30000);
+    ASSERT_GT(samples.size(), 1u);
+
+    start(&sparse);
+    start(&dense);
+  }
+
+  virtual void TearDown() {
+  }
+
+  // Reads a sensor stream in the insgps_replay CSV format
+  bool loadLog(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file)
+      return false;
+
+    char line[1024];
+    float lastTime = 0;
+    while (fgets(line, sizeof(line), file)) {
+      Sample s;
+      float time;
+      unsigned int sensors;
+      if (sscanf(line, "%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%i", &time,
+                 &s.gyro[0], &s.gyro[1], &s.gyro[2], &s.accel[0], &s.accel[1], &s.accel[2],
+                 &s.mag[0], &s.mag[1], &s.mag[2], &s.pos[0], &s.pos[1], &s.pos[2],
+                 &s.vel[0], &s.vel[1], &s.vel[2], &s.baro, &sensors) != 18)
+        continue;
+      s.dT = samples.empty() ? 0 : time - lastTime;
+      s.sensors = sensors & FULL_SENSORS;
+      lastTime = time;
+      samples.push_back(s);
+    }
+    fclose(file);
+
+    return samples.size() > 1;
+  }
+
+  // Gaussian noise from a fixed seed so every run sees the same data
+  float noise(float sigma) {
+    seed = seed * 1103515245u + 12345u;
+    float u1 = ((seed >> 8) + 1) / 16777217.0f;
+    seed = seed * 1103515245u + 12345u;
+    float u2 = (seed >> 8) / 16777216.0f;
+    return sigma * sqrtf(-2 * logf(u1)) * cosf(2 * (float) M_PI * u2);
+  }
+
+  // A slow circle at 500 Hz with a wobbling attitude, mag and baro at
+  // 100 Hz and GPS at 10 Hz
+  void synthesize(int count) {
+    seed = 1;
+    for (int i = 0; i < count; i++) {
+      const float t = i * 0.002f;
+      Sample s;
+      s.dT = 0.002f;
+      s.gyro[0] = 0.2f * sinf(t) + noise(0.01f);
+      s.gyro[1] = 0.2f * cosf(0.7f * t) + noise(0.01f);
+      s.gyro[2] = 0.1f + noise(0.01f);
+      s.accel[0] = noise(0.2f);
+      s.accel[1] = noise(0.2f);
+      s.accel[2] = -9.81f + noise(0.2f);
+      s.mag[0] = 400 * cosf(0.1f * t) + noise(5);
+      s.mag[1] = -400 * sinf(0.1f * t) + noise(5);
+      s.mag[2] = 900 + noise(5);
+      s.pos[0] = 20 * sinf(0.1f * t) + noise(1);
+      s.pos[1] = 20 * (1 - cosf(0.1f * t)) + noise(1);
+      s.pos[2] = -10 + noise(2);
+      s.vel[0] = 2 * cosf(0.1f * t) + noise(0.1f);
+      s.vel[1] = 2 * sinf(0.1f * t) + noise(0.1f);
+      s.vel[2] = noise(0.2f);
+      s.baro = 10 + noise(0.5f);
+
+      s.sensors = 0;
+      if (i % 5 == 0)
+        s.sensors |= MAG_SENSORS | BARO_SENSOR;
+      if (i % 50 == 0)
+        s.sensors |= POS_SENSORS | HORIZ_SENSORS | VERT_SENSORS;
+      samples.push_back(s);
+    }
+  }
+
+  void start(struct insgps_state *ins) {
+    const float Be[3] = { 0.4f, 0.0f, 0.9f };
+    const float zeros[3] = { 0, 0, 0 };
+    const float q[4] = { 1, 0, 0, 0 };
+
+    insgps_init(ins);
+    insgps_set_mag_north(ins, Be);
+    insgps_set_state(ins, samples[0].pos, zeros, q, zeros, zeros);
+  }
+
+  std::vector<Sample> samples;
+  uint32_t seed;
+  struct insgps_state sparse;
+  struct insgps_state dense;
+};
+
+TEST_F(InsGpsBench, SingleUpdateMatchesDense) {
+  // Spread the covariance out so every measurement couples to many states
+  for (int i = 0; i < 500; i++) {
+    const Sample &s = samples[i];
+    insgps_state_prediction(&sparse, s.gyro, s.accel, s.dT);
+    insgps_covariance_prediction(&sparse, s.dT);
+  }
+
+  const uint16_t groups[] = { POS_SENSORS, HORIZ_SENSORS | VERT_SENSORS, MAG_SENSORS, BARO_SENSOR, FULL_SENSORS };
+  const Sample &s = samples[500];
+  for (unsigned int g = 0; g < sizeof(groups) / sizeof(groups[0]); g++) {
+    struct insgps_state a = sparse, b = sparse;
+    insgps_correction(&a, s.mag, s.pos, s.vel, s.baro, groups[g]);
+    insgps_dense_correction(&b, s.mag, s.pos, s.vel, s.baro, groups[g]);
+
+    for (int i = 0; i < INSGPS_NUMX; i++) {
+      EXPECT_NEAR(b.X[i], a.X[i], 1e-5f * (1 + fabsf(b.X[i]))) << "group " << groups[g] << " state " << i;
+      for (int j = 0; j < INSGPS_NUMX; j++) {
+        EXPECT_NEAR(b.P[i][j], a.P[i][j], 1e-5f * (fabsf(b.P[i][i]) + fabsf(b.P[j][j])))
+          << "group " << groups[g] << " P[" << i << "][" << j << "]";
+        EXPECT_EQ(a.P[i][j], a.P[j][i]);
+      }
+    }
+  }
+}
+
+TEST_F(InsGpsBench, DriftAgainstDense) {
+  float maxPos = 0, maxVel = 0, maxQ = 0, maxBias = 0;
+
+  for (size_t i = 1; i < samples.size(); i++) {
+    const Sample &s = samples[i];
+    insgps_state_prediction(&sparse, s.gyro, s.accel, s.dT);
+    insgps_covariance_prediction(&sparse, s.dT);
+    insgps_state_prediction(&dense, s.gyro, s.accel, s.dT);
+    insgps_covariance_prediction(&dense, s.dT);
+    if (s.sensors) {
+      insgps_correction(&sparse, s.mag, s.pos, s.vel, s.baro, s.sensors);
+      insgps_dense_correction(&dense, s.mag, s.pos, s.vel, s.baro, s.sensors);
+    }
+
+    for (int j = 0; j < 3; j++) {
+      maxPos = fmaxf(maxPos, fabsf(sparse.X[j] - dense.X[j]));
+      maxVel = fmaxf(maxVel, fabsf(sparse.X[3 + j] - dense.X[3 + j]));
+      maxBias = fmaxf(maxBias, fabsf(sparse.X[10 + j] - dense.X[10 + j]));
+    }
+    for (int j = 6; j < 10; j++)
+      maxQ = fmaxf(maxQ, fabsf(sparse.X[j] - dense.X[j]));
+  }
+
+  printf("Largest difference from the dense update over %u samples:\n", (unsigned int) samples.size());
+  printf("  position %g m, velocity %g m/s, quaternion %g, gyro bias %g rad/s\n", maxPos, maxVel, maxQ, maxBias);
+
+  EXPECT_LT(maxPos, 1e-2f);
+  EXPECT_LT(maxVel, 1e-2f);
+  EXPECT_LT(maxQ, 1e-3f);
+  EXPECT_LT(maxBias, 1e-4f);
+
+  // The Joseph form keeps the covariance symmetric with a positive diagonal
+  for (int i = 0; i < INSGPS_NUMX; i++) {
+    EXPECT_GT(sparse.P[i][i], 0.0f);
+    for (int j = 0; j < INSGPS_NUMX; j++)
+      EXPECT_EQ(sparse.P[i][j], sparse.P[j][i]);
+  }
+}
+
+TEST_F(InsGpsBench, TicksPerStep) {
+  uint64_t predict = 0, sparseUpdate = 0, denseUpdate = 0;
+  unsigned int updates = 0;
+
+  for (size_t i = 1; i < samples.size(); i++) {
+    const Sample &s = samples[i];
+
+    uint64_t t0 = ticks();
+    insgps_state_prediction(&sparse, s.gyro, s.accel, s.dT);
+    insgps_covariance_prediction(&sparse, s.dT);
+    predict += ticks() - t0;
+
+    // Both filters update from the same prior so they do the same work
+    dense = sparse;
+    if (s.sensors) {
+      t0 = ticks();
+      insgps_dense_correction(&dense, s.mag, s.pos, s.vel, s.baro, s.sensors);
+      denseUpdate += ticks() - t0;
+
+      t0 = ticks();
+      insgps_correction(&sparse, s.mag, s.pos, s.vel, s.baro, s.sensors);
+      sparseUpdate += ticks() - t0;
+      updates++;
+    }
+  }
+  ASSERT_GT(updates, 0u);
+
+  const unsigned int steps = samples.size() - 1;
+  printf("Average " TICK_UNIT " on this host:\n");
+  printf("  predict        %8.0f\n", (double) predict / steps);
+  printf("  update, sparse %8.0f\n", (double) sparseUpdate / updates);
+  printf("  update, dense  %8.0f\n", (double) denseUpdate / updates);
+}
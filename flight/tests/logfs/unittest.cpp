@@ -33,7 +33,6 @@
 
 #include "gtest/gtest.h"
 
-#include <stdio.h>		/* printf */
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
@@ -55,6 +54,7 @@ extern struct pios_flash_posix_cfg flash_config;
 #include "pios_flashfs_logfs_priv.h"
 
 extern struct flashfs_logfs_cfg flashfs_config_settings;
+extern struct flashfs_logfs_cfg flashfs_config_settings_dir;
 extern struct flashfs_logfs_cfg flashfs_config_waypoints;
 
 #include "pios_flashfs.h"	/* PIOS_FLASHFS_* */
@@ -75,6 +75,10 @@ extern struct flashfs_logfs_cfg flashfs_config_waypoints;
 #define OBJ4_ID 0x90901111
 #define OBJ4_SIZE (768)		// only fits in partition b slots
 
+#define OBJ5_BASE_ID 0x55000000
+#define OBJ5_SIZE 100
+#define OBJ5_COUNT 120		// roughly the number of settings objects on a board
+
 // To use a test fixture, derive a class from testing::Test.
 class LogfsTestRaw : public testing::Test {
 protected:
@@ -425,3 +429,121 @@ TEST_F(LogfsTestCookedMultiPart, WriteLarge) {
   memset(obj4_check, 0, sizeof(obj4_check));
   EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id_b, OBJ4_ID, 0, obj4_check, sizeof(obj4_check)));
 }
+
+class LogfsTestDirectory : public LogfsTestRaw {
+protected:
+  virtual void SetUp() {
+    /* First, we need to set up the super fixture (LogfsTestRaw) */
+    LogfsTestRaw::SetUp();
+
+    /* Init the flash and a flashfs that keeps its slot directory in RAM */
+    EXPECT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings_dir, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+
+  virtual void TearDown() {
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+  }
+
+  /* Load every OBJ5 instance and return the number of flash reads it took */
+  uint32_t LoadAllObj5(uintptr_t load_fs_id) {
+    uint32_t reads_before = PIOS_Flash_Posix_GetReadCount(pios_posix_flash_id);
+    unsigned char obj5_check[OBJ5_SIZE];
+    for (uint32_t i = 0; i < OBJ5_COUNT; i++) {
+      memset(obj5_check, 0, sizeof(obj5_check));
+      EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(load_fs_id, OBJ5_BASE_ID + i, 0, obj5_check, sizeof(obj5_check)));
+      EXPECT_EQ((unsigned char)i, obj5_check[0]);
+    }
+    return PIOS_Flash_Posix_GetReadCount(pios_posix_flash_id) - reads_before;
+  }
+
+  uintptr_t fs_id;
+};
+
+TEST_F(LogfsTestDirectory, WriteVerifyDeleteVerifyOne) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, 0));
+
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+}
+
+TEST_F(LogfsTestDirectory, WriteManyVerify) {
+  /* Enough writes to garbage collect the log many times */
+  for (uint32_t i = 0; i < 2000; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ0_ID, 0, NULL, 0));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 123, obj1_alt, sizeof(obj1_alt)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ3_ID, 0, obj3, sizeof(obj3)));
+  }
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ0_ID, 0, NULL, 0));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+  unsigned char obj1_alt_check[OBJ1_SIZE];
+  memset(obj1_alt_check, 0, sizeof(obj1_alt_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 123, obj1_alt_check, sizeof(obj1_alt_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_alt_check, sizeof(obj1_alt)));
+
+  unsigned char obj2_check[OBJ2_SIZE];
+  memset(obj2_check, 0, sizeof(obj2_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+  EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+
+  unsigned char obj3_check[OBJ3_SIZE];
+  memset(obj3_check, 0, sizeof(obj3_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ3_ID, 0, obj3_check, sizeof(obj3_check)));
+  EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
+}
+
+TEST_F(LogfsTestDirectory, RemountVerify) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ2_ID, 0));
+
+  /* The directory is rebuilt from flash when the log is mounted again */
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings_dir, FLASH_PARTITION_LABEL_SETTINGS));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+  unsigned char obj2_check[OBJ2_SIZE];
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+}
+
+TEST_F(LogfsTestDirectory, LoadSettingsFlashReads) {
+  /* Store a full set of settings objects */
+  unsigned char obj5[OBJ5_SIZE];
+  for (uint32_t i = 0; i < OBJ5_COUNT; i++) {
+    memset(obj5, i, sizeof(obj5));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ5_BASE_ID + i, 0, obj5, sizeof(obj5)));
+  }
+
+  /* Load them all back the way UAVObjLoadSettings does at boot */
+  uint32_t dir_reads = LoadAllObj5(fs_id);
+
+  /* Mount the same arena without the directory and load again */
+  uintptr_t scan_fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&scan_fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  uint32_t scan_reads = LoadAllObj5(scan_fs_id);
+  PIOS_FLASHFS_Logfs_Destroy(scan_fs_id);
+
+  /* One header and one data read per object, where the scan reads slot headers until it finds each one */
+  EXPECT_EQ((uint32_t)(2 * OBJ5_COUNT), dir_reads);
+  EXPECT_LT(dir_reads, scan_reads);
+}
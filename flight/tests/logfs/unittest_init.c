@@ -5,6 +5,7 @@
 
 #define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
 
+#include <stdbool.h>
 #include "pios_flashfs_logfs_priv.h"
 
 const struct flashfs_logfs_cfg flashfs_config_settings = {
@@ -13,6 +14,13 @@ const struct flashfs_logfs_cfg flashfs_config_settings = {
 	.slot_size     = 0x00000100, /* 256 bytes */
 };
 
+const struct flashfs_logfs_cfg flashfs_config_settings_dir = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = 0x00010000, /* 256 * slot size */
+	.slot_size     = 0x00000100, /* 256 bytes */
+	.ram_directory = true,
+};
+
 const struct flashfs_logfs_cfg flashfs_config_waypoints = {
 	.fs_magic      = 0x89abceef,
 	.arena_size    = 0x00010000, /* 64 * slot size */
@@ -0,0 +1,45 @@
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffff
+#define portTICK_RATE_MS 1
+
+typedef long portBASE_TYPE;
+typedef void * xQueueHandle;
+
+/* The unit tests are single threaded, so a binary semaphore is just a flag
+ * and taking one never blocks */
+struct ut_semaphore {
+	int given;
+	int gives;
+};
+typedef struct ut_semaphore * xSemaphoreHandle;
+
+#define pvPortMalloc(xSize) (malloc(xSize))
+#define vPortFree(pv) (free(pv))
+
+#define vSemaphoreCreateBinary(s) do { (s) = calloc(1, sizeof(struct ut_semaphore)); if (s) (s)->given = 1; } while (0)
+
+static inline portBASE_TYPE xSemaphoreTake(xSemaphoreHandle s, uint32_t ticks)
+{
+	(void) ticks;
+	if (!s->given)
+		return pdFALSE;
+	s->given = 0;
+	return pdTRUE;
+}
+
+static inline portBASE_TYPE xSemaphoreGiveFromISR(xSemaphoreHandle s, portBASE_TYPE *woken)
+{
+	s->given = 1;
+	s->gives++;
+	*woken = pdTRUE;
+	return pdTRUE;
+}
+
+#endif /* INC_FREERTOS_H */
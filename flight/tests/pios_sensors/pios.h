@@ -0,0 +1,26 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+/* C Lib Includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "pios_delay.h"
+#include "pios_spi.h"
+#include "pios_sensors.h"
+
+/* Would be from pios_exti.h */
+struct pios_exti_cfg;
+extern int32_t PIOS_EXTI_Init(const struct pios_exti_cfg *cfg);
+
+#if defined(PIOS_INCLUDE_MPU6000)
+#include "pios_mpu6000.h"
+#endif
+
+#endif /* PIOS_H */
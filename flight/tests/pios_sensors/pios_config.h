@@ -0,0 +1,3 @@
+#define PIOS_INCLUDE_MPU6000
+#define PIOS_MPU6000_ACCEL
+#define PIOS_MPU6000_FIFO_BURST 8
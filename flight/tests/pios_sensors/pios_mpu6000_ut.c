@@ -0,0 +1,133 @@
+#include "pios.h"
+
+/* An MPU6000 on the other end of the SPI bus. The registers keep what was
+ * written to them and the tests fill the data registers and the FIFO. */
+uint8_t ut_mpu6000_regs[0x80];
+uint8_t ut_mpu6000_fifo[1024];
+uint16_t ut_mpu6000_fifo_bytes;
+uint32_t ut_mpu6000_fifo_resets;
+
+/* The raw time the driver stamps its samples with */
+uint32_t ut_raw_time;
+
+/* Register transactions sent a byte at a time */
+static uint8_t byte_address;
+static uint32_t byte_count;
+
+static void write_reg(uint8_t reg, uint8_t value)
+{
+	ut_mpu6000_regs[reg] = value;
+
+	// The reset bits clear themselves once the reset is done
+	if (reg == PIOS_MPU60X0_PWR_MGMT_REG) {
+		ut_mpu6000_regs[reg] &= ~PIOS_MPU60X0_PWRMGMT_IMU_RST;
+	} else if (reg == PIOS_MPU60X0_USER_CTRL_REG) {
+		if (value & PIOS_MPU60X0_USERCTL_FIFO_RST) {
+			ut_mpu6000_fifo_bytes = 0;
+			ut_mpu6000_fifo_resets++;
+		}
+		ut_mpu6000_regs[reg] &= ~0x07;
+	}
+}
+
+static uint8_t read_fifo(void)
+{
+	if (ut_mpu6000_fifo_bytes == 0)
+		return 0;
+
+	uint8_t value = ut_mpu6000_fifo[0];
+	memmove(ut_mpu6000_fifo, &ut_mpu6000_fifo[1], --ut_mpu6000_fifo_bytes);
+	return value;
+}
+
+static uint8_t read_reg(uint8_t reg)
+{
+	switch (reg) {
+	case PIOS_MPU60X0_FIFO_CNT_MSB:
+		return ut_mpu6000_fifo_bytes >> 8;
+	case PIOS_MPU60X0_FIFO_CNT_LSB:
+		return ut_mpu6000_fifo_bytes & 0xff;
+	case PIOS_MPU60X0_FIFO_REG:
+		return read_fifo();
+	default:
+		return ut_mpu6000_regs[reg];
+	}
+}
+
+int32_t PIOS_SPI_SetClockSpeed(uint32_t spi_id, SPIPrescalerTypeDef spi_prescaler)
+{
+	return 0;
+}
+
+int32_t PIOS_SPI_RC_PinSet(uint32_t spi_id, uint32_t slave_id, uint8_t pin_value)
+{
+	// Selecting the chip starts a transaction
+	if (pin_value == 0)
+		byte_count = 0;
+
+	return 0;
+}
+
+int32_t PIOS_SPI_TransferByte(uint32_t spi_id, uint8_t b)
+{
+	if (byte_count++ == 0) {
+		byte_address = b;
+		return 0;
+	}
+
+	// Bursts move on to the next register, except in the FIFO
+	uint8_t reg = byte_address & 0x7f;
+	if (reg != PIOS_MPU60X0_FIFO_REG)
+		reg += byte_count - 2;
+	if (byte_address & 0x80)
+		return read_reg(reg);
+
+	write_reg(reg, b);
+	return 0;
+}
+
+int32_t PIOS_SPI_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len, void *callback)
+{
+	for (uint16_t i = 0; i < len; i++) {
+		int32_t value = PIOS_SPI_TransferByte(spi_id, send_buffer[i]);
+		if (receive_buffer != NULL)
+			receive_buffer[i] = value;
+	}
+
+	return 0;
+}
+
+int32_t PIOS_SPI_ClaimBus(uint32_t spi_id)
+{
+	return 0;
+}
+
+int32_t PIOS_SPI_ClaimBusISR(uint32_t spi_id, bool *woken)
+{
+	return 0;
+}
+
+int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id)
+{
+	return 0;
+}
+
+int32_t PIOS_SPI_ReleaseBusISR(uint32_t spi_id, bool *woken)
+{
+	return 0;
+}
+
+int32_t PIOS_EXTI_Init(const struct pios_exti_cfg *cfg)
+{
+	return 0;
+}
+
+uint32_t PIOS_DELAY_GetRaw()
+{
+	return ut_raw_time;
+}
+
+int32_t PIOS_DELAY_WaitmS(uint32_t mS)
+{
+	return 0;
+}
@@ -0,0 +1 @@
+/* Provided by FreeRTOS.h in the unit test */
@@ -0,0 +1,339 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "pios_sensors.h"	/* API for the sensor channels */
+#include "pios_mpu6000.h"	/* API for the MPU6000 driver */
+#include "physical_constants.h"	/* GRAVITY */
+
+/* The emulated chip in pios_mpu6000_ut.c */
+extern uint8_t ut_mpu6000_regs[0x80];
+extern uint8_t ut_mpu6000_fifo[1024];
+extern uint16_t ut_mpu6000_fifo_bytes;
+extern uint32_t ut_mpu6000_fifo_resets;
+extern uint32_t ut_raw_time;
+
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class SensorChannel : public testing::Test {
+protected:
+  virtual void SetUp() {
+    PIOS_SENSORS_Init();
+    ASSERT_EQ(0, PIOS_SENSORS_RegisterBatched(PIOS_SENSOR_GYRO));
+  }
+
+  virtual void TearDown() {
+  }
+
+  static struct pios_sensor_sample gyro(uint32_t timestamp, float value) {
+    struct pios_sensor_sample sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp = timestamp;
+    sample.gyro.x = value;
+    sample.gyro.y = -value;
+    sample.gyro.z = 2 * value;
+    sample.gyro.temperature = 25;
+    return sample;
+  }
+};
+
+TEST_F(SensorChannel, Registration) {
+  EXPECT_TRUE(PIOS_SENSORS_IsBatched(PIOS_SENSOR_GYRO));
+  EXPECT_FALSE(PIOS_SENSORS_IsBatched(PIOS_SENSOR_ACCEL));
+  EXPECT_TRUE(PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO) == NULL);
+
+  // A type is either queued or batched, by one driver
+  EXPECT_EQ(-1, PIOS_SENSORS_RegisterBatched(PIOS_SENSOR_GYRO));
+  EXPECT_EQ(-1, PIOS_SENSORS_Register(PIOS_SENSOR_GYRO, (xQueueHandle) 1));
+  EXPECT_EQ(0, PIOS_SENSORS_Register(PIOS_SENSOR_ACCEL, (xQueueHandle) 1));
+  EXPECT_EQ(-1, PIOS_SENSORS_RegisterBatched(PIOS_SENSOR_ACCEL));
+
+  // Only batched types can be subscribed to, by a limited number of consumers
+  EXPECT_TRUE(PIOS_SENSORS_Subscribe(PIOS_SENSOR_ACCEL, 8, 1) == NULL);
+  for (int i = 0; i < PIOS_SENSORS_MAX_SUBSCRIBERS; i++)
+    EXPECT_TRUE(PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 8, 1) != NULL);
+  EXPECT_TRUE(PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 8, 1) == NULL);
+}
+
+TEST_F(SensorChannel, SizeRoundsUpToPowerOfTwo) {
+  struct pios_sensor_channel *channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 20, 1);
+  ASSERT_TRUE(channel != NULL);
+  EXPECT_EQ(32, channel->size);
+}
+
+TEST_F(SensorChannel, DrainsInOrderAcrossIndexWrap) {
+  struct pios_sensor_channel *channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 16, 1);
+  ASSERT_TRUE(channel != NULL);
+
+  // Bursts of 5 drained 3 and then 2 at a time, well past the 16 bit indices
+  uint32_t next_pushed = 0, next_drained = 0;
+  for (int burst = 0; burst < 30000; burst++) {
+    struct pios_sensor_sample samples[5];
+    for (int i = 0; i < 5; i++, next_pushed++)
+      samples[i] = gyro(next_pushed, (float) (next_pushed % 1000));
+    PIOS_SENSORS_PushFromISR(PIOS_SENSOR_GYRO, samples, 5);
+
+    struct pios_sensor_sample first[3], rest[3];
+    ASSERT_EQ(3, PIOS_SENSORS_Drain(channel, first, 3, 0));
+    ASSERT_EQ(2, PIOS_SENSORS_Drain(channel, rest, 3, 0));
+    ASSERT_EQ(next_drained, first[0].timestamp);
+    next_drained += 5;
+    ASSERT_EQ(next_drained - 1, rest[1].timestamp);
+    ASSERT_EQ((float) ((next_drained - 1) % 1000), rest[1].gyro.x);
+  }
+
+  EXPECT_EQ(0u, channel->dropped);
+  EXPECT_EQ(0, PIOS_SENSORS_Drain(channel, NULL, 3, 0));
+}
+
+TEST_F(SensorChannel, FullChannelDropsNewest) {
+  struct pios_sensor_channel *channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 4, 1);
+  ASSERT_TRUE(channel != NULL);
+
+  struct pios_sensor_sample samples[6];
+  for (int i = 0; i < 6; i++)
+    samples[i] = gyro(i, i);
+  PIOS_SENSORS_PushFromISR(PIOS_SENSOR_GYRO, samples, 6);
+  EXPECT_EQ(2u, channel->dropped);
+
+  struct pios_sensor_sample out[8];
+  ASSERT_EQ(4, PIOS_SENSORS_Drain(channel, out, 8, 0));
+  for (int i = 0; i < 4; i++)
+    EXPECT_EQ((uint32_t) i, out[i].timestamp);
+}
+
+TEST_F(SensorChannel, WakesAtThreshold) {
+  struct pios_sensor_channel *channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 16, 4);
+  ASSERT_TRUE(channel != NULL);
+
+  struct pios_sensor_sample sample = gyro(0, 1);
+  for (int i = 0; i < 3; i++)
+    EXPECT_FALSE(PIOS_SENSORS_PushFromISR(PIOS_SENSOR_GYRO, &sample, 1));
+  EXPECT_EQ(0, channel->data_ready->gives);
+
+  EXPECT_TRUE(PIOS_SENSORS_PushFromISR(PIOS_SENSOR_GYRO, &sample, 1));
+  EXPECT_EQ(1, channel->data_ready->gives);
+}
+
+TEST_F(SensorChannel, EverySubscriberSeesEverySample) {
+  struct pios_sensor_channel *attitude = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 8, 1);
+  struct pios_sensor_channel *analysis = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 64, 32);
+  ASSERT_TRUE(attitude != NULL);
+  ASSERT_TRUE(analysis != NULL);
+
+  struct pios_sensor_sample out[64];
+  for (int i = 0; i < 40; i++) {
+    struct pios_sensor_sample sample = gyro(i, i);
+    PIOS_SENSORS_PushFromISR(PIOS_SENSOR_GYRO, &sample, 1);
+    ASSERT_EQ(1, PIOS_SENSORS_Drain(attitude, out, 64, 0));
+    EXPECT_EQ((uint32_t) i, out[0].timestamp);
+  }
+
+  ASSERT_EQ(40, PIOS_SENSORS_Drain(analysis, out, 64, 0));
+  for (int i = 0; i < 40; i++)
+    EXPECT_EQ((float) i, out[i].gyro.x);
+  EXPECT_EQ(0u, attitude->dropped);
+  EXPECT_EQ(0u, analysis->dropped);
+}
+
+TEST_F(SensorChannel, DrainAverage) {
+  struct pios_sensor_channel *channel = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 8, 1);
+  ASSERT_TRUE(channel != NULL);
+
+  struct pios_sensor_sample samples[4] = { gyro(10, 1), gyro(20, 2), gyro(30, 3), gyro(40, 6) };
+  PIOS_SENSORS_PushFromISR(PIOS_SENSOR_GYRO, samples, 4);
+
+  struct pios_sensor_sample average;
+  ASSERT_EQ(4, PIOS_SENSORS_DrainAverage(channel, &average, 0));
+  EXPECT_EQ(40u, average.timestamp);
+  EXPECT_FLOAT_EQ(3.0f, average.gyro.x);
+  EXPECT_FLOAT_EQ(-3.0f, average.gyro.y);
+  EXPECT_FLOAT_EQ(6.0f, average.gyro.z);
+  EXPECT_FLOAT_EQ(25.0f, average.gyro.temperature);
+
+  EXPECT_EQ(0, PIOS_SENSORS_DrainAverage(channel, &average, 0));
+}
+
+static const struct pios_mpu60x0_cfg mpu6000_cfg = {
+  NULL,
+  8000,
+  PIOS_MPU60X0_INT_CLR_ANYRD,
+  PIOS_MPU60X0_INTEN_DATA_RDY,
+  PIOS_MPU60X0_USERCTL_DIS_I2C,
+  PIOS_MPU60X0_PWRMGMT_PLL_X_CLK,
+  PIOS_MPU60X0_LOWPASS_256_HZ,
+  PIOS_MPU60X0_TOP_0DEG,
+};
+
+class Mpu6000Fifo : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(ut_mpu6000_regs, 0, sizeof(ut_mpu6000_regs));
+    ut_mpu6000_fifo_bytes = 0;
+    ut_mpu6000_fifo_resets = 0;
+    ut_raw_time = 0;
+
+    PIOS_SENSORS_Init();
+    ASSERT_EQ(0, PIOS_MPU6000_Init(1, 0, &mpu6000_cfg));
+  }
+
+  virtual void TearDown() {
+  }
+
+  // One sample laid out as the chip stores it, big endian in register order
+  static void frame(uint8_t *out, int16_t accel_x, int16_t accel_y, int16_t accel_z, int16_t temp,
+                    int16_t gyro_x, int16_t gyro_y, int16_t gyro_z) {
+    int16_t values[7] = { accel_x, accel_y, accel_z, temp, gyro_x, gyro_y, gyro_z };
+    for (int i = 0; i < 7; i++) {
+      out[2 * i] = (uint16_t) values[i] >> 8;
+      out[2 * i + 1] = (uint16_t) values[i] & 0xff;
+    }
+  }
+
+  static void queueFrames(int count) {
+    for (int i = 0; i < count; i++) {
+      frame(&ut_mpu6000_fifo[ut_mpu6000_fifo_bytes], 100 * i, -200, 4096, -512, 655, -1310, 131);
+      ut_mpu6000_fifo_bytes += 14;
+    }
+  }
+};
+
+TEST_F(Mpu6000Fifo, BurstFollowsSampleRate) {
+  // At 8 kHz the samples are read eight at a time from the FIFO
+  EXPECT_EQ(8, PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_GYRO));
+  EXPECT_EQ(8, PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_ACCEL));
+  EXPECT_EQ(0xf8, ut_mpu6000_regs[PIOS_MPU60X0_FIFO_EN_REG]);
+  EXPECT_TRUE(ut_mpu6000_regs[PIOS_MPU60X0_USER_CTRL_REG] & PIOS_MPU60X0_USERCTL_FIFO_EN);
+
+  PIOS_MPU6000_SetSampleRate(2000);
+  EXPECT_EQ(2, PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_GYRO));
+  EXPECT_TRUE(ut_mpu6000_regs[PIOS_MPU60X0_USER_CTRL_REG] & PIOS_MPU60X0_USERCTL_FIFO_EN);
+
+  // Slow enough to read every sample from the data registers
+  PIOS_MPU6000_SetSampleRate(1000);
+  EXPECT_EQ(1, PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_GYRO));
+  EXPECT_EQ(0, ut_mpu6000_regs[PIOS_MPU60X0_FIFO_EN_REG]);
+  EXPECT_FALSE(ut_mpu6000_regs[PIOS_MPU60X0_USER_CTRL_REG] & PIOS_MPU60X0_USERCTL_FIFO_EN);
+}
+
+TEST_F(Mpu6000Fifo, ParsesBurst) {
+  struct pios_sensor_channel *gyros = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 32, PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_GYRO));
+  struct pios_sensor_channel *accels = PIOS_SENSORS_Subscribe(PIOS_SENSOR_ACCEL, 32, PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_ACCEL));
+  ASSERT_TRUE(gyros != NULL);
+  ASSERT_TRUE(accels != NULL);
+
+  queueFrames(8);
+  ut_raw_time = 1000;
+
+  // The FIFO is only read once a burst has collected
+  for (int i = 0; i < 7; i++)
+    EXPECT_FALSE(PIOS_MPU6000_IRQHandler());
+  EXPECT_EQ(8 * 14, ut_mpu6000_fifo_bytes);
+  EXPECT_TRUE(PIOS_MPU6000_IRQHandler());
+  EXPECT_EQ(0, ut_mpu6000_fifo_bytes);
+
+  // One wakeup for the whole burst
+  EXPECT_EQ(1, gyros->data_ready->gives);
+
+  struct pios_sensor_sample out[16];
+  ASSERT_EQ(8, PIOS_SENSORS_Drain(gyros, out, 16, 0));
+  for (int i = 0; i < 8; i++) {
+    // Spread evenly since the last burst, which was at the init
+    EXPECT_EQ((uint32_t) (125 * (i + 1)), out[i].timestamp);
+    // 500 deg/s range, with X and Y swapped and Z flipped for TOP_0DEG
+    EXPECT_FLOAT_EQ(-20.0f, out[i].gyro.x);
+    EXPECT_FLOAT_EQ(10.0f, out[i].gyro.y);
+    EXPECT_FLOAT_EQ(-2.0f, out[i].gyro.z);
+    EXPECT_FLOAT_EQ(35.0f, out[i].gyro.temperature);
+  }
+
+  ASSERT_EQ(8, PIOS_SENSORS_Drain(accels, out, 16, 0));
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ((uint32_t) (125 * (i + 1)), out[i].timestamp);
+    // 8 g range
+    EXPECT_FLOAT_EQ(-200 * GRAVITY / 4096.0f, out[i].accel.x);
+    EXPECT_FLOAT_EQ(100 * i * GRAVITY / 4096.0f, out[i].accel.y);
+    EXPECT_FLOAT_EQ(-GRAVITY, out[i].accel.z);
+  }
+}
+
+TEST_F(Mpu6000Fifo, ResetsMisalignedFifo) {
+  struct pios_sensor_channel *gyros = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 32, 8);
+  ASSERT_TRUE(gyros != NULL);
+  uint32_t resets = ut_mpu6000_fifo_resets;
+
+  // An overflow leaves part of a sample in the FIFO
+  queueFrames(8);
+  ut_mpu6000_fifo_bytes += 3;
+  ut_raw_time = 1000;
+  for (int i = 0; i < 8; i++)
+    EXPECT_FALSE(PIOS_MPU6000_IRQHandler());
+  EXPECT_EQ(resets + 1, ut_mpu6000_fifo_resets);
+
+  struct pios_sensor_sample out[16];
+  EXPECT_EQ(0, PIOS_SENSORS_Drain(gyros, out, 16, 0));
+
+  // The next burst is timed from the reset
+  queueFrames(8);
+  ut_raw_time = 2000;
+  for (int i = 0; i < 8; i++)
+    PIOS_MPU6000_IRQHandler();
+  ASSERT_EQ(8, PIOS_SENSORS_Drain(gyros, out, 16, 0));
+  EXPECT_EQ(1125u, out[0].timestamp);
+  EXPECT_EQ(2000u, out[7].timestamp);
+}
+
+TEST_F(Mpu6000Fifo, SlowRateReadsRegisters) {
+  PIOS_MPU6000_SetSampleRate(500);
+  struct pios_sensor_channel *gyros = PIOS_SENSORS_Subscribe(PIOS_SENSOR_GYRO, 32, PIOS_SENSORS_GetBurstSize(PIOS_SENSOR_GYRO));
+  ASSERT_TRUE(gyros != NULL);
+
+  frame(&ut_mpu6000_regs[PIOS_MPU60X0_ACCEL_X_OUT_MSB], 0, 0, 4096, -512, 655, -1310, 131);
+  ut_raw_time = 42;
+  EXPECT_TRUE(PIOS_MPU6000_IRQHandler());
+
+  struct pios_sensor_sample out[4];
+  ASSERT_EQ(1, PIOS_SENSORS_Drain(gyros, out, 4, 0));
+  EXPECT_EQ(42u, out[0].timestamp);
+  EXPECT_FLOAT_EQ(-20.0f, out[0].gyro.x);
+  EXPECT_FLOAT_EQ(10.0f, out[0].gyro.y);
+  EXPECT_FLOAT_EQ(-2.0f, out[0].gyro.z);
+}
@@ -0,0 +1,18 @@
+#include <stdlib.h>
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffff
+
+typedef void * xQueueHandle;
+typedef void * xSemaphoreHandle;
+
+#define pvPortMalloc(xSize) (malloc(xSize))
+#define vPortFree(pv) (free(pv))
+
+/* The unit tests are single threaded so the mutexes never block */
+static inline xSemaphoreHandle xSemaphoreCreateRecursiveMutex(void) { return (xSemaphoreHandle) 1; }
+static inline int xSemaphoreTakeRecursive(xSemaphoreHandle m, uint32_t t) { (void) m; (void) t; return pdTRUE; }
+static inline int xSemaphoreGiveRecursive(xSemaphoreHandle m) { (void) m; return pdTRUE; }
+
+extern int xQueueSend(xQueueHandle queue, const void * item, uint32_t ticks);
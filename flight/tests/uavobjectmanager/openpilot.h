@@ -0,0 +1,7 @@
+#include <pios.h>
+
+#include "utlist.h"
+#include "uavobjectmanager.h"
+
+/* Would be from eventdispatcher.h but that file pulls on way too many dependencies */
+extern int32_t EventCallbackDispatch(UAVObjEvent * ev, UAVObjEventCallback cb);
@@ -0,0 +1 @@
+#define PIOS_INCLUDE_FREERTOS
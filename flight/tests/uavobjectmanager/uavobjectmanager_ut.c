@@ -0,0 +1,30 @@
+#include "openpilot.h"
+
+/* No settings filesystem, objects are never found in flash */
+uintptr_t pios_uavo_settings_fs_id;
+
+int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	return -1;
+}
+
+/* No queues or callbacks are connected by the tests */
+int xQueueSend(xQueueHandle queue, const void * item, uint32_t ticks)
+{
+	return pdTRUE;
+}
+
+int32_t EventCallbackDispatch(UAVObjEvent * ev, UAVObjEventCallback cb)
+{
+	return pdTRUE;
+}
@@ -0,0 +1,237 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "openpilot.h"
+
+}
+
+#define OBJ_ID_SINGLE  0x1000
+#define OBJ_ID_MULTI   0x2000
+#define OBJ_ID_INDEXED 0x3000
+#define OBJ_ID_ABSENT  0x4000
+
+/* Stand in for the generated object index and a generated object */
+static UAVObjHandle indexed_handle;
+
+static UAVObjHandle IndexedHandle()
+{
+  return indexed_handle;
+}
+
+extern "C" {
+
+extern const struct UAVOIndexEntry uavo_index[] = {
+  { OBJ_ID_INDEXED, IndexedHandle },
+  { OBJ_ID_ABSENT, NULL },
+};
+
+extern const uint16_t uavo_index_count = sizeof(uavo_index) / sizeof(uavo_index[0]);
+
+}
+
+/* An awkward size so that instances are not nicely aligned in their blocks */
+struct test_data {
+	uint32_t value;
+	uint8_t  pattern[7];
+} __attribute__((packed));
+
+class UAVObjectManagerTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    EXPECT_EQ(0, UAVObjInitialize());
+    indexed_handle = NULL;
+
+    single = UAVObjRegister(OBJ_ID_SINGLE, 1, 0, sizeof(struct test_data), NULL);
+    EXPECT_TRUE(single != NULL);
+
+    multi = UAVObjRegister(OBJ_ID_MULTI, 0, 0, sizeof(struct test_data), NULL);
+    EXPECT_TRUE(multi != NULL);
+  }
+
+  void fillData(struct test_data * data, uint32_t value) {
+    data->value = value;
+    memset(data->pattern, value & 0xff, sizeof(data->pattern));
+  }
+
+  UAVObjHandle single;
+  UAVObjHandle multi;
+};
+
+TEST_F(UAVObjectManagerTest, SingleInstance) {
+  struct test_data data;
+
+  EXPECT_EQ(1, UAVObjGetNumInstances(single));
+
+  fillData(&data, 42);
+  EXPECT_EQ(0, UAVObjSetData(single, &data));
+
+  struct test_data readback;
+  EXPECT_EQ(0, UAVObjGetData(single, &readback));
+  EXPECT_EQ(0, memcmp(&data, &readback, sizeof(data)));
+
+  /* Only instance 0 exists */
+  EXPECT_EQ(-1, UAVObjGetInstanceData(single, 1, &readback));
+}
+
+TEST_F(UAVObjectManagerTest, CreateInstances) {
+  EXPECT_EQ(1, UAVObjGetNumInstances(multi));
+
+  for (uint16_t i = 1; i < 50; i++) {
+    EXPECT_EQ(i, UAVObjCreateInstance(multi, NULL));
+    EXPECT_EQ(i + 1, UAVObjGetNumInstances(multi));
+  }
+
+  /* Write every instance then check none of them overlap */
+  struct test_data data;
+  for (uint16_t i = 0; i < 50; i++) {
+    fillData(&data, 1000 + i);
+    EXPECT_EQ(0, UAVObjSetInstanceData(multi, i, &data));
+  }
+
+  for (uint16_t i = 0; i < 50; i++) {
+    struct test_data readback;
+    fillData(&data, 1000 + i);
+    EXPECT_EQ(0, UAVObjGetInstanceData(multi, i, &readback));
+    EXPECT_EQ(0, memcmp(&data, &readback, sizeof(data))) << "instance " << i;
+  }
+
+  /* Instances past the end don't exist */
+  struct test_data readback;
+  EXPECT_EQ(-1, UAVObjGetInstanceData(multi, 50, &readback));
+}
+
+TEST_F(UAVObjectManagerTest, InstanceFields) {
+  for (uint16_t i = 1; i < 10; i++) {
+    EXPECT_EQ(i, UAVObjCreateInstance(multi, NULL));
+  }
+
+  /* Each new instance starts out cleared */
+  struct test_data readback;
+  struct test_data zero;
+  memset(&zero, 0, sizeof(zero));
+  EXPECT_EQ(0, UAVObjGetInstanceData(multi, 7, &readback));
+  EXPECT_EQ(0, memcmp(&zero, &readback, sizeof(zero)));
+
+  uint32_t value = 0xdeadbeef;
+  EXPECT_EQ(0, UAVObjSetInstanceDataField(multi, 7, &value, offsetof(struct test_data, value), sizeof(value)));
+
+  uint32_t value_readback = 0;
+  EXPECT_EQ(0, UAVObjGetInstanceDataField(multi, 7, &value_readback, offsetof(struct test_data, value), sizeof(value_readback)));
+  EXPECT_EQ(value, value_readback);
+
+  /* The neighbouring instances are untouched */
+  EXPECT_EQ(0, UAVObjGetInstanceData(multi, 6, &readback));
+  EXPECT_EQ(0, memcmp(&zero, &readback, sizeof(zero)));
+  EXPECT_EQ(0, UAVObjGetInstanceData(multi, 8, &readback));
+  EXPECT_EQ(0, memcmp(&zero, &readback, sizeof(zero)));
+}
+
+TEST_F(UAVObjectManagerTest, UnpackCreatesMissingInstances) {
+  struct test_data data;
+  fillData(&data, 37);
+
+  /* Unpacking an instance creates it along with all the ones before it */
+  EXPECT_EQ(0, UAVObjUnpack(multi, 37, (uint8_t *) &data));
+  EXPECT_EQ(38, UAVObjGetNumInstances(multi));
+
+  struct test_data readback;
+  EXPECT_EQ(0, UAVObjGetInstanceData(multi, 37, &readback));
+  EXPECT_EQ(0, memcmp(&data, &readback, sizeof(data)));
+
+  struct test_data zero;
+  memset(&zero, 0, sizeof(zero));
+  for (uint16_t i = 0; i < 37; i++) {
+    EXPECT_EQ(0, UAVObjGetInstanceData(multi, i, &readback));
+    EXPECT_EQ(0, memcmp(&zero, &readback, sizeof(zero))) << "instance " << i;
+  }
+}
+
+TEST_F(UAVObjectManagerTest, MaxInstances) {
+  struct test_data data;
+  fillData(&data, UAVOBJ_MAX_INSTANCES - 1);
+
+  EXPECT_EQ(0, UAVObjUnpack(multi, UAVOBJ_MAX_INSTANCES - 1, (uint8_t *) &data));
+  EXPECT_EQ(UAVOBJ_MAX_INSTANCES, UAVObjGetNumInstances(multi));
+
+  struct test_data readback;
+  EXPECT_EQ(0, UAVObjGetInstanceData(multi, UAVOBJ_MAX_INSTANCES - 1, &readback));
+  EXPECT_EQ(0, memcmp(&data, &readback, sizeof(data)));
+
+  /* Past the doubling blocks, the fixed size blocks don't overlap either */
+  for (uint16_t i = 0; i < UAVOBJ_MAX_INSTANCES; i++) {
+    fillData(&data, i);
+    EXPECT_EQ(0, UAVObjSetInstanceData(multi, i, &data));
+  }
+
+  for (uint16_t i = 0; i < UAVOBJ_MAX_INSTANCES; i++) {
+    fillData(&data, i);
+    EXPECT_EQ(0, UAVObjGetInstanceData(multi, i, &readback));
+    EXPECT_EQ(0, memcmp(&data, &readback, sizeof(data))) << "instance " << i;
+  }
+
+  /* No more instances can be created */
+  UAVObjCreateInstance(multi, NULL);
+  EXPECT_EQ(UAVOBJ_MAX_INSTANCES, UAVObjGetNumInstances(multi));
+  EXPECT_EQ(-1, UAVObjUnpack(multi, UAVOBJ_MAX_INSTANCES, (uint8_t *) &data));
+  EXPECT_EQ(-1, UAVObjGetInstanceData(multi, UAVOBJ_MAX_INSTANCES, &readback));
+}
+
+TEST_F(UAVObjectManagerTest, GetByID) {
+  /* Objects missing from the index are found in the object list */
+  EXPECT_EQ(single, UAVObjGetByID(OBJ_ID_SINGLE));
+  EXPECT_EQ(multi, UAVObjGetByID(OBJ_ID_MULTI));
+  EXPECT_EQ(UAVObjGetLinkedObj(multi), UAVObjGetByID(OBJ_ID_MULTI + 1));
+
+  /* Objects in the index are found through their handle accessor, not the list */
+  UAVObjHandle registered = UAVObjRegister(OBJ_ID_INDEXED, 1, 0, sizeof(struct test_data), NULL);
+  EXPECT_TRUE(registered != NULL);
+  EXPECT_TRUE(UAVObjGetByID(OBJ_ID_INDEXED) == NULL);
+
+  indexed_handle = registered;
+  EXPECT_EQ(indexed_handle, UAVObjGetByID(OBJ_ID_INDEXED));
+  EXPECT_EQ(UAVObjGetLinkedObj(indexed_handle), UAVObjGetByID(OBJ_ID_INDEXED + 1));
+
+  /* Objects that are in the index but not built in are never found */
+  EXPECT_TRUE(UAVObjGetByID(OBJ_ID_ABSENT) == NULL);
+  EXPECT_TRUE(UAVObjGetByID(OBJ_ID_ABSENT + 1) == NULL);
+  EXPECT_TRUE(UAVObjGetByID(0x5000) == NULL);
+}
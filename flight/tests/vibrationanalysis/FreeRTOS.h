@@ -0,0 +1,12 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdlib.h>
+
+typedef void * xQueueHandle;
+typedef void * xSemaphoreHandle;
+
+#define pvPortMalloc(xSize) (malloc(xSize))
+#define vPortFree(pv) (free(pv))
+
+#endif /* FREERTOS_H */
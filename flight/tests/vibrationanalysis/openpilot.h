@@ -0,0 +1,14 @@
+/* C Lib Includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "pios_sensors.h"
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+/* Would be from pios_delay.h, raw times in the unit tests are in us */
+extern uint32_t PIOS_DELAY_DiffuS(uint32_t raw);
@@ -0,0 +1 @@
+/* Everything pios_sensors.h needs is in FreeRTOS.h */
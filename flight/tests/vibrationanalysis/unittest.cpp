@@ -0,0 +1,287 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test of the Welch spectrum estimate used for vibration analysis
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+#include "gtest/gtest.h"
+
+#include <math.h>		/* sin, sqrt */
+#include <stdlib.h>		/* rand */
+
+extern "C" {
+
+#include "openpilot.h"
+
+/* arm_math.h has inline helpers that -Wextra objects to in C++ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#include "welch.h"
+#pragma GCC diagnostic pop
+
+extern uint32_t ut_now_us;
+
+}
+
+#define SAMPLE_RATE 1000.0f
+#define GRAVITY_MS2 9.81f
+
+static const uint16_t fft_sizes[] = { 128, 512, 2048 };
+
+// To use a test fixture, derive a class from testing::Test.
+class WelchTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    sample_index = 0;
+  }
+
+  // A tone on each axis at frequencies that fall between bins, with gravity on z
+  void AddTones(struct welch_state *welch, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++, sample_index++) {
+      double t = sample_index / SAMPLE_RATE;
+      float sample[WELCH_AXES] = {
+        (float) (3.0 * sin(2 * M_PI * 123.4 * t)),
+        (float) (0.2 + 1.5 * sin(2 * M_PI * 47.3 * t)),
+        (float) (-GRAVITY_MS2 + 0.5 * sin(2 * M_PI * 310.7 * t)),
+      };
+      welch_add_sample(welch, sample);
+    }
+  }
+
+  // Uniform white noise with unit variance on every axis
+  void AddNoise(struct welch_state *welch, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+      float sample[WELCH_AXES];
+      for (int j = 0; j < WELCH_AXES; j++)
+        sample[j] = (float) (sqrt(12.0) * ((double) rand() / RAND_MAX - 0.5));
+      welch_add_sample(welch, sample);
+    }
+  }
+
+  // Spread of the bins of a flat spectrum relative to their mean
+  double BinSpread(struct welch_state *welch, uint8_t axis) {
+    double sum = 0, sum_sq = 0;
+    uint16_t n = 0;
+    for (uint16_t k = 4; k < welch->fft_size / 2 - 4; k++, n++) {
+      double a = welch_amplitude(welch, axis, k);
+      sum += a * a;
+      sum_sq += a * a * a * a;
+    }
+    double mean = sum / n;
+    return sqrt(sum_sq / n - mean * mean) / mean;
+  }
+
+  // Accel samples at SAMPLE_RATE, timestamped in us, with a tone on x
+  void MakeBatch(struct pios_sensor_sample *samples, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++, sample_index++) {
+      samples[i].timestamp = (uint32_t) (sample_index * 1e6 / SAMPLE_RATE);
+      samples[i].accel.x = (float) (3.0 * sin(2 * M_PI * 123.4 * sample_index / SAMPLE_RATE));
+      samples[i].accel.y = 0;
+      samples[i].accel.z = -GRAVITY_MS2;
+    }
+    ut_now_us = samples[count - 1].timestamp;
+  }
+
+  uint32_t sample_index;
+};
+
+TEST_F(WelchTest, SupportedSizes) {
+  struct welch_state welch;
+
+  for (uint32_t i = 0; i < NELEMENTS(fft_sizes); i++)
+    EXPECT_EQ(0, welch_init(&welch, fft_sizes[i]));
+
+  // Only the lengths the q15 real FFT has tables for
+  EXPECT_EQ(-1, welch_init(&welch, 256));
+  EXPECT_EQ(-1, welch_init(&welch, 0));
+}
+
+TEST_F(WelchTest, SegmentsOverlapByHalf) {
+  struct welch_state welch;
+  ASSERT_EQ(0, welch_init(&welch, 128));
+
+  AddTones(&welch, 127);
+  EXPECT_EQ(0, welch.segments);
+  AddTones(&welch, 1);
+  EXPECT_EQ(1, welch.segments);
+
+  // Every further half segment completes another one
+  AddTones(&welch, 63);
+  EXPECT_EQ(1, welch.segments);
+  AddTones(&welch, 1);
+  EXPECT_EQ(2, welch.segments);
+  AddTones(&welch, 64 * 10);
+  EXPECT_EQ(12, welch.segments);
+
+  welch_reset(&welch);
+  EXPECT_EQ(0, welch.segments);
+  EXPECT_EQ(0.0f, welch_amplitude(&welch, 0, 10));
+  AddTones(&welch, 127);
+  EXPECT_EQ(0, welch.segments);
+}
+
+TEST_F(WelchTest, TonePeaks) {
+  for (uint32_t i = 0; i < NELEMENTS(fft_sizes); i++) {
+    struct welch_state welch;
+    ASSERT_EQ(0, welch_init(&welch, fft_sizes[i]));
+    AddTones(&welch, 8 * fft_sizes[i]);
+
+    float bin_width = SAMPLE_RATE / fft_sizes[i];
+    float amplitude;
+
+    EXPECT_NEAR(123.4f, welch_peak(&welch, 0, SAMPLE_RATE, &amplitude), 0.1f * bin_width) << fft_sizes[i];
+    EXPECT_NEAR(3.0f, amplitude, 0.03f * 3.0f) << fft_sizes[i];
+
+    EXPECT_NEAR(47.3f, welch_peak(&welch, 1, SAMPLE_RATE, &amplitude), 0.1f * bin_width) << fft_sizes[i];
+    EXPECT_NEAR(1.5f, amplitude, 0.03f * 1.5f) << fft_sizes[i];
+
+    // Gravity is removed with the mean, so the small tone still wins
+    EXPECT_NEAR(310.7f, welch_peak(&welch, 2, SAMPLE_RATE, &amplitude), 0.1f * bin_width) << fft_sizes[i];
+    EXPECT_NEAR(0.5f, amplitude, 0.03f * 0.5f) << fft_sizes[i];
+  }
+}
+
+TEST_F(WelchTest, BinnedTone) {
+  struct welch_state welch;
+  ASSERT_EQ(0, welch_init(&welch, 512));
+
+  // A tone centred on bin 64 reads as its amplitude with no interpolation
+  for (uint32_t i = 0; i < 4 * 512; i++) {
+    float sample[WELCH_AXES] = { (float) (2.0 * cos(2 * M_PI * 64 * i / 512)), 0, 0 };
+    welch_add_sample(&welch, sample);
+  }
+
+  EXPECT_NEAR(2.0f, welch_amplitude(&welch, 0, 64), 0.01f);
+  EXPECT_NEAR(1.0f, welch_amplitude(&welch, 0, 63), 0.01f);
+  EXPECT_NEAR(0.0f, welch_amplitude(&welch, 0, 62), 0.01f);
+  EXPECT_NEAR(125.0f, welch_peak(&welch, 0, SAMPLE_RATE, NULL), 0.01f);
+
+  // A silent axis has no peak worth reporting
+  float amplitude;
+  welch_peak(&welch, 1, SAMPLE_RATE, &amplitude);
+  EXPECT_EQ(0.0f, amplitude);
+}
+
+TEST_F(WelchTest, BandPower) {
+  for (uint32_t i = 0; i < NELEMENTS(fft_sizes); i++) {
+    struct welch_state welch;
+    ASSERT_EQ(0, welch_init(&welch, fft_sizes[i]));
+    AddTones(&welch, 8 * fft_sizes[i]);
+
+    // A sine wave of amplitude A has a mean square of A^2 / 2
+    EXPECT_NEAR(4.5f, welch_band_power(&welch, 0, SAMPLE_RATE, 100, 200), 0.02f * 4.5f) << fft_sizes[i];
+    EXPECT_NEAR(1.125f, welch_band_power(&welch, 1, SAMPLE_RATE, 25, 100), 0.02f * 1.125f) << fft_sizes[i];
+    EXPECT_NEAR(0.125f, welch_band_power(&welch, 2, SAMPLE_RATE, 200, 500), 0.02f * 0.125f) << fft_sizes[i];
+
+    // Nothing leaks into bands away from the tones, including gravity at DC
+    EXPECT_LT(welch_band_power(&welch, 0, SAMPLE_RATE, 0, 50), 1e-3f * 4.5f) << fft_sizes[i];
+    EXPECT_LT(welch_band_power(&welch, 1, SAMPLE_RATE, 100, 500), 1e-3f * 1.125f) << fft_sizes[i];
+    EXPECT_LT(welch_band_power(&welch, 2, SAMPLE_RATE, 0, 200), 1e-3f * 0.125f) << fft_sizes[i];
+  }
+}
+
+TEST_F(WelchTest, AveragingReducesVariance) {
+  struct welch_state welch;
+  ASSERT_EQ(0, welch_init(&welch, 512));
+  srand(1);
+
+  // The bins of a single periodogram of white noise are as noisy as their mean
+  AddNoise(&welch, 512);
+  ASSERT_EQ(1, welch.segments);
+  double single = BinSpread(&welch, 0);
+  EXPECT_GT(single, 0.7);
+
+  welch_reset(&welch);
+  AddNoise(&welch, 512 + 63 * 256);
+  ASSERT_EQ(64, welch.segments);
+  double averaged = BinSpread(&welch, 0);
+  EXPECT_LT(averaged, 0.2);
+
+  // All of the unit variance is in the spectrum
+  for (uint8_t axis = 0; axis < WELCH_AXES; axis++)
+    EXPECT_NEAR(1.0f, welch_band_power(&welch, axis, SAMPLE_RATE, 0, SAMPLE_RATE), 0.05f);
+}
+
+TEST_F(WelchTest, BatchStopsAtSpectrum) {
+  struct welch_state welch;
+  ASSERT_EQ(0, welch_init(&welch, 128));
+
+  struct pios_sensor_sample samples[100];
+  uint16_t used = 0;
+
+  // Two segments of 128 samples overlapping by 64 end at sample 192
+  MakeBatch(samples, 100);
+  EXPECT_EQ(100, welch_add_batch(&welch, samples, 100, 2));
+  EXPECT_EQ(0, welch.segments);
+  MakeBatch(samples, 100);
+  used = welch_add_batch(&welch, samples, 100, 2);
+  EXPECT_EQ(92, used);
+  EXPECT_EQ(2, welch.segments);
+  EXPECT_NEAR(SAMPLE_RATE, welch_sample_rate(&welch), 0.01f);
+
+  // The rest of the batch starts the next spectrum, timed from its own first sample
+  welch_reset(&welch);
+  EXPECT_EQ(0.0f, welch_sample_rate(&welch));
+  EXPECT_EQ(8, welch_add_batch(&welch, &samples[used], 100 - used, 2));
+  EXPECT_NEAR(SAMPLE_RATE, welch_sample_rate(&welch), 0.01f);
+}
+
+TEST_F(WelchTest, EmptyDrainMidSpectrum) {
+  struct welch_state welch;
+  ASSERT_EQ(0, welch_init(&welch, 512));
+
+  struct pios_sensor_sample samples[32];
+  for (uint32_t i = 0; i < 2 * 512 / 32; i++) {
+    MakeBatch(samples, 32);
+    EXPECT_EQ(32, welch_add_batch(&welch, samples, 32, 8));
+
+    // A drain that times out while the sensor stalls adds nothing, however
+    // long the stall, and leaves the timing of the samples alone
+    if (i == 5) {
+      ut_now_us += 250000;
+      EXPECT_EQ(0, welch_add_batch(&welch, samples, 0, 8));
+    }
+  }
+  EXPECT_NEAR(SAMPLE_RATE, welch_sample_rate(&welch), 0.01f);
+
+  uint16_t used;
+  do {
+    MakeBatch(samples, 32);
+    used = welch_add_batch(&welch, samples, 32, 8);
+    EXPECT_EQ(0, welch_add_batch(&welch, samples, 0, 8));
+  } while (welch.segments < 8);
+  EXPECT_EQ(32, used);
+
+  float sample_rate = welch_sample_rate(&welch);
+  EXPECT_NEAR(SAMPLE_RATE, sample_rate, 0.01f);
+
+  float amplitude;
+  EXPECT_NEAR(123.4f, welch_peak(&welch, 0, sample_rate, &amplitude), 0.1f * sample_rate / 512);
+  EXPECT_NEAR(3.0f, amplitude, 0.03f * 3.0f);
+}
@@ -0,0 +1,9 @@
+#include "openpilot.h"
+
+/* The tests set the time the delay functions measure against */
+uint32_t ut_now_us;
+
+uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
+{
+	return ut_now_us - raw;
+}
@@ -0,0 +1,835 @@
+/**
+ ******************************************************************************
+ * @addtogroup Tools
+ * @{
+ *
+ * @file       insgps_replay.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      Replays logged sensor data through many INS/GPS filters at once
+ *             to sweep the noise parameters.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * The input is a .tll log recorded by the GCS logging plugin. The UAVTalk
+ * packets of Gyros, Accels, Magnetometer, GPSPosition, GPSVelocity and
+ * BaroAltitude are decoded from it, along with HomeLocation and GyrosBias,
+ * and turned into the sensor stream the Revolution attitude module feeds the
+ * filter in outdoor mode: one update per Gyros packet, the gyro bias added
+ * back as when the filter computes it, the GPS position converted to NED
+ * around the home location, the baro altitude offset to the NED frame and
+ * the same rules for which sensors are used. The log only holds what telemetry sent, so the update periods of the
+ * sensor objects should be raised before recording a log for replay. The
+ * objects are decoded with the flight headers generated from the UAVObject
+ * definitions, so those have to match the ones the log was recorded with.
+ *
+ * Every combination of the swept variances gets its own filter. The filters
+ * are spread over worker threads and each is scored by the RMS of its
+ * innovations, the measurements minus the predicted measurements, for each
+ * group of sensors. One CSV line per filter is written to stdout.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "insgps.h"
+#include "coordinate_conversions.h"
+#include "physical_constants.h"
+
+/* The generated object headers only need the types of the object manager */
+typedef void * xQueueHandle;
+#include "uavobjectmanager.h"
+#include "accels.h"
+#include "baroaltitude.h"
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "gyros.h"
+#include "gyrosbias.h"
+#include "homelocation.h"
+#include "magnetometer.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Log and UAVTalk framing, as written by the GCS logging plugin
+#define LOG_SEPARATOR "##\n"
+#define LOG_DEFINITIONS_TAG "UAVO definitions: "
+#define LOG_HEADER_MAX_LINES 10
+#define UAVTALK_SYNC_VAL 0x3C
+#define UAVTALK_TYPE_MASK 0x78
+#define UAVTALK_TYPE_VER 0x20
+#define UAVTALK_TIMESTAMPED 0x80
+#define UAVTALK_TYPE_OBJ (UAVTALK_TYPE_VER | 0x00)
+#define UAVTALK_TYPE_OBJ_ACK (UAVTALK_TYPE_VER | 0x02)
+#define UAVTALK_MIN_HEADER_LENGTH 8
+#define UAVTALK_TIMESTAMP_LENGTH 2
+
+// As in the attitude module
+#define BARO_OFFSET_LOWPASS_ALPHA 0.9997f
+
+//! One filter update. The first sample only starts the filter.
+struct sample {
+	float time;		//!< Log time in s
+	float gyro[3];		//!< rad/s, bias included
+	float accel[3];		//!< m/s^2
+	float mag[3];
+	float pos[3];		//!< NED in m
+	float vel[3];		//!< NED in m/s
+	float baro;		//!< Baro altitude offset to the NED frame, in m
+	uint16_t sensors;	//!< Mask passed to the correction, 0 to only predict
+};
+
+//! Latest objects decoded from the log, and the attitude module's view of them
+struct extract {
+	HomeLocationData home;
+	GyrosBiasData gyros_bias;
+	AccelsData accels;
+	MagnetometerData mag;
+	BaroAltitudeData baro;
+	GPSPositionData gps;
+	GPSVelocityData gps_vel;
+
+	float Be[3];
+	bool home_set;
+	float T[3];		//!< Scale from LLA differences to NED
+	bool have_accels;
+	bool mag_updated;
+	bool baro_updated;
+	bool gps_updated;
+	bool gps_vel_updated;
+	bool inited;
+	float baro_offset;
+
+	struct sample *samples;
+	int num_samples;
+	int capacity;
+};
+
+//! A log spaced range of variances
+struct sweep {
+	float min;
+	float max;
+	int steps;
+};
+
+struct params {
+	float accel_var;
+	float gyro_var;
+	float mag_var;
+	float baro_var;
+};
+
+struct result {
+	struct params params;
+	float pos_rms;
+	float vel_rms;
+	float mag_rms;
+	float baro_rms;
+	bool diverged;
+};
+
+struct replay {
+	const struct sample *samples;
+	int num_samples;
+	float Be[3];
+	float gps_var[3];
+
+	struct sweep accel, gyro, mag, baro;
+	int num_filters;
+	struct result *results;
+	volatile int next_filter;
+};
+
+/**
+ * Find the first record of a log, past the header lines, the separator and
+ * the UAVO definitions newer logs embed right after it
+ * @return the offset of the first record, or -1 if there is no separator
+ */
+static int64_t find_first_record(const uint8_t *log, int64_t size)
+{
+	int64_t pos = 0;
+
+	for (int line = 0; line < LOG_HEADER_MAX_LINES; line++) {
+		const uint8_t *eol = memchr(log + pos, '\n', size - pos);
+		if (!eol)
+			return -1;
+
+		bool separator = eol + 1 - (log + pos) == strlen(LOG_SEPARATOR) &&
+		                 memcmp(log + pos, LOG_SEPARATOR, strlen(LOG_SEPARATOR)) == 0;
+		pos = eol + 1 - log;
+		if (!separator)
+			continue;
+
+		if (size - pos < strlen(LOG_DEFINITIONS_TAG) ||
+		    memcmp(log + pos, LOG_DEFINITIONS_TAG, strlen(LOG_DEFINITIONS_TAG)) != 0)
+			return pos;
+
+		char count[32] = { 0 };
+		int64_t count_len = size - pos - strlen(LOG_DEFINITIONS_TAG);
+		memcpy(count, log + pos + strlen(LOG_DEFINITIONS_TAG),
+		       count_len < sizeof(count) - 1 ? count_len : sizeof(count) - 1);
+		char *end;
+		int64_t definitions = strtoll(count, &end, 10);
+		if (end == count || *end != '\n' || definitions < 0)
+			return -1;
+
+		pos += strlen(LOG_DEFINITIONS_TAG) + (end - count) + 1;
+		return definitions <= size - pos ? pos + definitions : -1;
+	}
+
+	return -1;
+}
+
+//! The UAVTalk checksum, a CRC-8 with polynomial 0x07
+static uint8_t uavtalk_crc(const uint8_t *data, int length)
+{
+	uint8_t crc = 0;
+
+	for (int i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+	}
+
+	return crc;
+}
+
+/**
+ * Compute the scale from LLA differences to NED around the home location,
+ * as the attitude module does
+ */
+static void set_home(struct extract *x, bool Be_given)
+{
+	float lat = x->home.Latitude / 10.0e6f * DEG2RAD;
+	float alt = x->home.Altitude;
+
+	x->home_set = x->home.Set == HOMELOCATION_SET_TRUE;
+	x->T[0] = alt + 6.378137E6f;
+	x->T[1] = cosf(lat) * (alt + 6.378137E6f);
+	x->T[2] = -1.0f;
+
+	if (!Be_given)
+		memcpy(x->Be, x->home.Be, sizeof(x->Be));
+}
+
+//! Convert the GPS position into NED coordinates
+static void get_ned(const struct extract *x, float NED[3])
+{
+	float dL[3] = { (x->gps.Latitude - x->home.Latitude) / 10.0e6f * DEG2RAD,
+		(x->gps.Longitude - x->home.Longitude) / 10.0e6f * DEG2RAD,
+		(x->gps.Altitude + x->gps.GeoidSeparation - x->home.Altitude) };
+
+	for (int i = 0; i < 3; i++)
+		NED[i] = x->T[i] * dL[i];
+}
+
+static bool add_sample(struct extract *x, float time, const GyrosData *gyros, uint16_t sensors,
+                       const float pos[3], const float vel[3])
+{
+	if (x->num_samples == x->capacity) {
+		int capacity = x->capacity ? 2 * x->capacity : 4096;
+		struct sample *grown = realloc(x->samples, capacity * sizeof(*x->samples));
+		if (!grown)
+			return false;
+		x->samples = grown;
+		x->capacity = capacity;
+	}
+
+	struct sample *s = &x->samples[x->num_samples++];
+	s->time = time;
+
+	// The sensors module removed the bias, the filter tracks it itself
+	s->gyro[0] = (gyros->x + x->gyros_bias.x) * DEG2RAD;
+	s->gyro[1] = (gyros->y + x->gyros_bias.y) * DEG2RAD;
+	s->gyro[2] = (gyros->z + x->gyros_bias.z) * DEG2RAD;
+	s->accel[0] = x->accels.x;
+	s->accel[1] = x->accels.y;
+	s->accel[2] = x->accels.z;
+	s->mag[0] = x->mag.x;
+	s->mag[1] = x->mag.y;
+	s->mag[2] = x->mag.z;
+	memcpy(s->pos, pos, sizeof(s->pos));
+	memcpy(s->vel, vel, sizeof(s->vel));
+	s->baro = x->baro.Altitude + x->baro_offset;
+	s->sensors = sensors;
+
+	return true;
+}
+
+/**
+ * Make the filter update for a gyro sample following updateAttitudeINSGPS()
+ * in outdoor mode: wait for a mag, baro and good GPS sample to start, then
+ * use every sensor that updated since the last gyro sample
+ * @return false if out of memory
+ */
+static bool gyro_update(struct extract *x, float time, const GyrosData *gyros)
+{
+	float NED[3] = { 0, 0, 0 };
+	float vel[3] = { 0, 0, 0 };
+	uint16_t sensors = 0;
+
+	if (!x->have_accels)
+		return true;
+
+	// Discard mag samples with NAN and mags without an earth field to compare with
+	x->mag_updated &= x->mag.x == x->mag.x && x->mag.y == x->mag.y && x->mag.z == x->mag.z;
+	x->mag_updated &= x->Be[0] != 0 || x->Be[1] != 0 || x->Be[2] != 0;
+
+	if (!x->inited) {
+		bool gps_init_usable = x->gps_updated && x->gps.Satellites >= 7 && x->gps.PDOP <= 3.5f && x->home_set;
+		if (!x->mag_updated || !x->baro_updated || !gps_init_usable)
+			return true;
+
+		get_ned(x, NED);
+		x->baro_offset = -NED[2] - x->baro.Altitude;
+		x->inited = true;
+
+		return add_sample(x, time, gyros, 0, NED, vel);
+	}
+
+	x->gps_updated &= x->gps.Satellites >= 6 && x->gps.PDOP <= 4.0f && x->home_set;
+
+	if (x->mag_updated) {
+		sensors |= MAG_SENSORS;
+		x->mag_updated = false;
+	}
+
+	if (x->baro_updated) {
+		sensors |= BARO_SENSOR;
+		x->baro_updated = false;
+	}
+
+	if (x->gps_updated) {
+		sensors |= HORIZ_POS_SENSORS | VERT_POS_SENSORS;
+		get_ned(x, NED);
+
+		// Track barometric altitude offset with a low pass filter
+		x->baro_offset = BARO_OFFSET_LOWPASS_ALPHA * x->baro_offset +
+		                 (1.0f - BARO_OFFSET_LOWPASS_ALPHA) * (-NED[2] - x->baro.Altitude);
+		x->gps_updated = false;
+	}
+
+	if (x->gps_vel_updated) {
+		sensors |= HORIZ_SENSORS | VERT_SENSORS;
+		vel[0] = x->gps_vel.North;
+		vel[1] = x->gps_vel.East;
+		vel[2] = x->gps_vel.Down;
+		x->gps_vel_updated = false;
+	}
+
+	return add_sample(x, time, gyros, sensors, NED, vel);
+}
+
+/**
+ * Take the data of one object. Objects of the wrong size come from other
+ * UAVObject definitions and are ignored.
+ * @return false if out of memory
+ */
+static bool decode_object(struct extract *x, bool Be_given, float time, uint32_t obj_id, const uint8_t *data, int size)
+{
+	GyrosData gyros;
+
+	switch (obj_id) {
+	case GYROS_OBJID:
+		if (size != GYROS_NUMBYTES)
+			break;
+		memcpy(&gyros, data, GYROS_NUMBYTES);
+		return gyro_update(x, time, &gyros);
+	case ACCELS_OBJID:
+		if (size != ACCELS_NUMBYTES)
+			break;
+		memcpy(&x->accels, data, ACCELS_NUMBYTES);
+		x->have_accels = true;
+		break;
+	case GYROSBIAS_OBJID:
+		if (size != GYROSBIAS_NUMBYTES)
+			break;
+		memcpy(&x->gyros_bias, data, GYROSBIAS_NUMBYTES);
+		break;
+	case MAGNETOMETER_OBJID:
+		if (size != MAGNETOMETER_NUMBYTES)
+			break;
+		memcpy(&x->mag, data, MAGNETOMETER_NUMBYTES);
+		x->mag_updated = true;
+		break;
+	case BAROALTITUDE_OBJID:
+		if (size != BAROALTITUDE_NUMBYTES)
+			break;
+		memcpy(&x->baro, data, BAROALTITUDE_NUMBYTES);
+		x->baro_updated = true;
+		break;
+	case GPSPOSITION_OBJID:
+		if (size != GPSPOSITION_NUMBYTES)
+			break;
+		memcpy(&x->gps, data, GPSPOSITION_NUMBYTES);
+		x->gps_updated = true;
+		break;
+	case GPSVELOCITY_OBJID:
+		if (size != GPSVELOCITY_NUMBYTES)
+			break;
+		memcpy(&x->gps_vel, data, GPSVELOCITY_NUMBYTES);
+		x->gps_vel_updated = true;
+		break;
+	case HOMELOCATION_OBJID:
+		// Like the attitude module while armed, keep the home the filter started with
+		if (size != HOMELOCATION_NUMBYTES || x->inited)
+			break;
+		memcpy(&x->home, data, HOMELOCATION_NUMBYTES);
+		set_home(x, Be_given);
+		break;
+	}
+
+	return true;
+}
+
+/**
+ * Decode the UAVTalk packets of one log record. A record holds every packet
+ * the GCS wrote to the log at once. Bytes that do not start a packet with a
+ * valid checksum are skipped.
+ * @return false if out of memory
+ */
+static bool decode_record(struct extract *x, bool Be_given, float time, const uint8_t *data, int64_t size)
+{
+	int64_t pos = 0;
+
+	while (size - pos > UAVTALK_MIN_HEADER_LENGTH) {
+		const uint8_t *p = data + pos;
+		uint8_t type = p[1];
+		int length = p[2] | (p[3] << 8);
+
+		if (p[0] != UAVTALK_SYNC_VAL || (type & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER ||
+		    length < UAVTALK_MIN_HEADER_LENGTH || length >= size - pos ||
+		    uavtalk_crc(p, length) != p[length]) {
+			pos++;
+			continue;
+		}
+		pos += length + 1;
+
+		uint8_t kind = type & ~UAVTALK_TIMESTAMPED;
+		if (kind != UAVTALK_TYPE_OBJ && kind != UAVTALK_TYPE_OBJ_ACK)
+			continue;
+
+		// Every object used is single instance, so there is no instance ID
+		int header = UAVTALK_MIN_HEADER_LENGTH + ((type & UAVTALK_TIMESTAMPED) ? UAVTALK_TIMESTAMP_LENGTH : 0);
+		if (length < header)
+			continue;
+
+		uint32_t obj_id = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t) p[7] << 24);
+		if (!decode_object(x, Be_given, time, obj_id, p + header, length - header))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Turn a .tll log into filter updates
+ * @param[in,out] Be the earth field, taken from HomeLocation unless given
+ * @return the number of samples, or -1 on error
+ */
+static int load_log(FILE *file, float Be[3], bool Be_given, struct sample **samples_out)
+{
+	const int64_t record_header = sizeof(uint32_t) + sizeof(int64_t);
+	struct extract x;
+
+	memset(&x, 0, sizeof(x));
+	if (Be_given)
+		memcpy(x.Be, Be, sizeof(x.Be));
+
+	if (fseek(file, 0, SEEK_END) != 0)
+		return -1;
+	int64_t size = ftell(file);
+	rewind(file);
+	uint8_t *log = malloc(size > 0 ? size : 1);
+	if (!log || fread(log, 1, size, file) != size) {
+		free(log);
+		return -1;
+	}
+
+	int64_t pos = find_first_record(log, size);
+	if (pos < 0) {
+		fprintf(stderr, "no log header separator, not a .tll log\n");
+		free(log);
+		return -1;
+	}
+
+	while (size - pos >= record_header) {
+		uint32_t timestamp;
+		int64_t data_size;
+		memcpy(&timestamp, log + pos, sizeof(timestamp));
+		memcpy(&data_size, log + pos + sizeof(timestamp), sizeof(data_size));
+
+		// The size doubles as sync bytes, resync a byte at a time like the GCS
+		if ((data_size & 0xFFFFFFFFFFFF0000) != 0) {
+			pos++;
+			continue;
+		}
+
+		// Drop a record truncated by the end of the file
+		if (data_size > size - pos - record_header)
+			break;
+
+		if (!decode_record(&x, Be_given, timestamp / 1000.0f, log + pos + record_header, data_size)) {
+			free(log);
+			free(x.samples);
+			return -1;
+		}
+		pos += record_header + data_size;
+	}
+
+	free(log);
+	memcpy(Be, x.Be, sizeof(x.Be));
+	*samples_out = x.samples;
+	return x.num_samples;
+}
+
+static float sweep_value(const struct sweep *sweep, int step)
+{
+	if (sweep->steps <= 1)
+		return sweep->min;
+	return sweep->min * powf(sweep->max / sweep->min, (float) step / (sweep->steps - 1));
+}
+
+static void filter_params(const struct replay *replay, int filter, struct params *params)
+{
+	params->accel_var = sweep_value(&replay->accel, filter % replay->accel.steps);
+	filter /= replay->accel.steps;
+	params->gyro_var = sweep_value(&replay->gyro, filter % replay->gyro.steps);
+	filter /= replay->gyro.steps;
+	params->mag_var = sweep_value(&replay->mag, filter % replay->mag.steps);
+	filter /= replay->mag.steps;
+	params->baro_var = sweep_value(&replay->baro, filter % replay->baro.steps);
+}
+
+/**
+ * Start a filter the way the attitude module does, with the attitude from
+ * the first accel and mag sample and the position from the first sample
+ */
+static void start_filter(const struct replay *replay, const struct params *params, struct insgps_state *ins)
+{
+	const struct sample *first = &replay->samples[0];
+	const float zeros[3] = { 0, 0, 0 };
+	const float accel_var[3] = { params->accel_var, params->accel_var, params->accel_var };
+	const float gyro_var[3] = { params->gyro_var, params->gyro_var, params->gyro_var };
+	const float mag_var[3] = { params->mag_var, params->mag_var, params->mag_var };
+	const float Pdiag[INSGPS_NUMX] = { 25.0f, 25.0f, 25.0f, 5.0f, 5.0f, 5.0f, 1e-5f, 1e-5f, 1e-5f, 1e-5f, 1e-5f, 1e-5f, 1e-5f };
+	float RPY[3], q[4];
+
+	insgps_init(ins);
+	insgps_set_mag_var(ins, mag_var);
+	insgps_set_accel_var(ins, accel_var);
+	insgps_set_gyro_var(ins, gyro_var);
+	insgps_set_baro_var(ins, params->baro_var);
+	insgps_reset_p(ins, Pdiag);
+	insgps_set_pos_vel_var(ins, replay->gps_var[0], replay->gps_var[1], replay->gps_var[2]);
+	insgps_set_mag_north(ins, replay->Be);
+
+	RPY[0] = atan2f(-first->accel[1], -first->accel[2]) * RAD2DEG;
+	RPY[1] = atan2f(first->accel[0], -first->accel[2]) * RAD2DEG;
+	RPY[2] = atan2f(-first->mag[1], first->mag[0]) * RAD2DEG;
+	RPY2Quaternion(RPY, q);
+
+	insgps_set_state(ins, first->pos, zeros, q, zeros, zeros);
+}
+
+/**
+ * Accumulate the innovations of the sensors about to be used, from the
+ * state before the correction
+ */
+static void add_innovations(const struct insgps_state *ins, const float Be[3], const struct sample *s,
+                            double sum[4], int count[4])
+{
+	const float *X = ins->X;
+
+	if (s->sensors & POS_SENSORS) {
+		for (int i = 0; i < 3; i++)
+			if (s->sensors & (1 << i))
+				sum[0] += (s->pos[i] - X[i]) * (s->pos[i] - X[i]);
+		count[0]++;
+	}
+
+	if (s->sensors & (HORIZ_SENSORS | VERT_SENSORS)) {
+		for (int i = 0; i < 3; i++)
+			if (s->sensors & (1 << (i + 3)))
+				sum[1] += (s->vel[i] - X[i + 3]) * (s->vel[i] - X[i + 3]);
+		count[1]++;
+	}
+
+	if (s->sensors & MAG_SENSORS) {
+		// Earth field rotated into the body frame, as in the measurement equation
+		const float q0 = X[6], q1 = X[7], q2 = X[8], q3 = X[9];
+		float Bb[3];
+		Bb[0] = (q0 * q0 + q1 * q1 - q2 * q2 - q3 * q3) * Be[0] +
+		        2.0f * (q1 * q2 + q0 * q3) * Be[1] + 2.0f * (q1 * q3 - q0 * q2) * Be[2];
+		Bb[1] = 2.0f * (q1 * q2 - q0 * q3) * Be[0] + (q0 * q0 - q1 * q1 + q2 * q2 - q3 * q3) * Be[1] +
+		        2.0f * (q2 * q3 + q0 * q1) * Be[2];
+		Bb[2] = 2.0f * (q1 * q3 + q0 * q2) * Be[0] + 2.0f * (q2 * q3 - q0 * q1) * Be[1] +
+		        (q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3) * Be[2];
+
+		float mag = VectorMagnitude(s->mag);
+		for (int i = 0; i < 3; i++)
+			sum[2] += (s->mag[i] / mag - Bb[i]) * (s->mag[i] / mag - Bb[i]);
+		count[2]++;
+	}
+
+	if (s->sensors & BARO_SENSOR) {
+		sum[3] += (s->baro + X[2]) * (s->baro + X[2]);
+		count[3]++;
+	}
+}
+
+static void run_filter(const struct replay *replay, int filter, struct result *result)
+{
+	struct insgps_state ins;
+	double sum[4] = { 0, 0, 0, 0 };
+	int count[4] = { 0, 0, 0, 0 };
+
+	filter_params(replay, filter, &result->params);
+	start_filter(replay, &result->params, &ins);
+	result->diverged = false;
+
+	for (int i = 1; i < replay->num_samples; i++) {
+		const struct sample *s = &replay->samples[i];
+		float dT = s->time - replay->samples[i - 1].time;
+
+		if (dT > 0) {
+			insgps_state_prediction(&ins, s->gyro, s->accel, dT);
+			insgps_covariance_prediction(&ins, dT);
+		}
+
+		if (s->sensors) {
+			add_innovations(&ins, ins.Be, s, sum, count);
+			insgps_correction(&ins, s->mag, s->pos, s->vel, s->baro, s->sensors);
+		}
+
+		if (isnan(ins.X[6]) || isnan(ins.X[0])) {
+			result->diverged = true;
+			break;
+		}
+	}
+
+	result->pos_rms = count[0] ? sqrt(sum[0] / count[0]) : 0;
+	result->vel_rms = count[1] ? sqrt(sum[1] / count[1]) : 0;
+	result->mag_rms = count[2] ? sqrt(sum[2] / count[2]) : 0;
+	result->baro_rms = count[3] ? sqrt(sum[3] / count[3]) : 0;
+}
+
+static void *worker(void *arg)
+{
+	struct replay *replay = arg;
+
+	for (;;) {
+		int filter = __sync_fetch_and_add(&replay->next_filter, 1);
+		if (filter >= replay->num_filters)
+			break;
+		run_filter(replay, filter, &replay->results[filter]);
+	}
+
+	return NULL;
+}
+
+static float result_score(const struct result *result)
+{
+	if (result->diverged)
+		return INFINITY;
+	return result->pos_rms + result->vel_rms + result->mag_rms + result->baro_rms;
+}
+
+static bool parse_floats(const char *arg, float *values, int n)
+{
+	char *end;
+	for (int i = 0; i < n; i++) {
+		values[i] = strtof(arg, &end);
+		if (end == arg || (i < n - 1 && *end != ','))
+			return false;
+		arg = end + 1;
+	}
+	return *end == '\0';
+}
+
+static bool parse_sweep(const char *arg, struct sweep *sweep)
+{
+	char *end;
+
+	sweep->min = strtof(arg, &end);
+	if (end == arg || sweep->min <= 0)
+		return false;
+	if (*end == '\0') {
+		sweep->max = sweep->min;
+		sweep->steps = 1;
+		return true;
+	}
+	if (*end != ':')
+		return false;
+
+	arg = end + 1;
+	sweep->max = strtof(arg, &end);
+	if (end == arg || *end != ':' || sweep->max <= 0)
+		return false;
+
+	arg = end + 1;
+	sweep->steps = strtol(arg, &end, 10);
+	return end != arg && *end == '\0' && sweep->steps >= 1;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options] <log.tll>\n"
+		"\n"
+		"  --accel-var MIN[:MAX:STEPS]  accelerometer noise variance sweep\n"
+		"  --gyro-var MIN[:MAX:STEPS]   gyro noise variance sweep\n"
+		"  --mag-var MIN[:MAX:STEPS]    magnetometer noise variance sweep\n"
+		"  --baro-var MIN[:MAX:STEPS]   barometer noise variance sweep\n"
+		"  --gps-var POS,VEL,VERTPOS    GPS noise variances\n"
+		"  --be X,Y,Z                   earth magnetic field in NED, instead of HomeLocation.Be\n"
+		"  --threads N                  worker threads, defaults to one per core\n"
+		"\n"
+		"Sweeps are log spaced. The defaults are the INSSettings defaults.\n",
+		name);
+}
+
+int main(int argc, char *argv[])
+{
+	struct replay replay = {
+		.gps_var = { 0.001f, 0.01f, 10.0f },
+		.accel = { 0.01f, 0.01f, 1 },
+		.gyro = { 0.00001f, 0.00001f, 1 },
+		.mag = { 0.005f, 0.005f, 1 },
+		.baro = { 0.1f, 0.1f, 1 },
+	};
+	int num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	bool Be_given = false;
+
+	static const struct option options[] = {
+		{ "accel-var", required_argument, NULL, 'a' },
+		{ "gyro-var", required_argument, NULL, 'g' },
+		{ "mag-var", required_argument, NULL, 'm' },
+		{ "baro-var", required_argument, NULL, 'b' },
+		{ "gps-var", required_argument, NULL, 'p' },
+		{ "be", required_argument, NULL, 'e' },
+		{ "threads", required_argument, NULL, 'j' },
+		{ NULL, 0, NULL, 0 },
+	};
+
+	int opt;
+	while ((opt = getopt_long(argc, argv, "j:", options, NULL)) != -1) {
+		bool ok;
+		switch (opt) {
+		case 'a':
+			ok = parse_sweep(optarg, &replay.accel);
+			break;
+		case 'g':
+			ok = parse_sweep(optarg, &replay.gyro);
+			break;
+		case 'm':
+			ok = parse_sweep(optarg, &replay.mag);
+			break;
+		case 'b':
+			ok = parse_sweep(optarg, &replay.baro);
+			break;
+		case 'p':
+			ok = parse_floats(optarg, replay.gps_var, 3);
+			break;
+		case 'e':
+			ok = parse_floats(optarg, replay.Be, 3);
+			Be_given = true;
+			break;
+		case 'j':
+			num_threads = atoi(optarg);
+			ok = num_threads > 0;
+			break;
+		default:
+			ok = false;
+		}
+		if (!ok) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	FILE *file = fopen(argv[optind], "rb");
+	if (!file) {
+		fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+		return 1;
+	}
+	struct sample *samples = NULL;
+	replay.num_samples = load_log(file, replay.Be, Be_given, &samples);
+	fclose(file);
+	if (replay.num_samples < 0) {
+		fprintf(stderr, "%s: could not load the log\n", argv[optind]);
+		return 1;
+	}
+	if (replay.num_samples < 2) {
+		fprintf(stderr, "%s: the filter never started, the log needs Gyros, Accels, Magnetometer, "
+			"BaroAltitude and a GPS fix with HomeLocation set\n", argv[optind]);
+		return 1;
+	}
+	replay.samples = samples;
+
+	replay.num_filters = replay.accel.steps * replay.gyro.steps * replay.mag.steps * replay.baro.steps;
+	replay.results = calloc(replay.num_filters, sizeof(*replay.results));
+	if (!replay.results)
+		return 1;
+
+	if (num_threads > replay.num_filters)
+		num_threads = replay.num_filters;
+	fprintf(stderr, "Replaying %d samples through %d filters on %d threads\n",
+		replay.num_samples, replay.num_filters, num_threads);
+
+	pthread_t threads[num_threads];
+	for (int i = 0; i < num_threads; i++)
+		pthread_create(&threads[i], NULL, worker, &replay);
+	for (int i = 0; i < num_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	int best = 0;
+	printf("accel_var,gyro_var,mag_var,baro_var,pos_rms,vel_rms,mag_rms,baro_rms,diverged\n");
+	for (int i = 0; i < replay.num_filters; i++) {
+		const struct result *r = &replay.results[i];
+		printf("%g,%g,%g,%g,%g,%g,%g,%g,%d\n",
+		       r->params.accel_var, r->params.gyro_var, r->params.mag_var, r->params.baro_var,
+		       r->pos_rms, r->vel_rms, r->mag_rms, r->baro_rms, r->diverged);
+		if (result_score(r) < result_score(&replay.results[best]))
+			best = i;
+	}
+
+	const struct result *r = &replay.results[best];
+	fprintf(stderr, "Lowest total innovation RMS: accel_var %g gyro_var %g mag_var %g baro_var %g\n",
+		r->params.accel_var, r->params.gyro_var, r->params.mag_var, r->params.baro_var);
+
+	free(replay.results);
+	free(samples);
+	return 0;
+}
+
+/**
+ * @}
+ */
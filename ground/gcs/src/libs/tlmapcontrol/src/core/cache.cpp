@@ -45,12 +45,18 @@ namespace core {
         routeCache = cache + "RouteCache" + QDir::separator();
         geoCache = cache + "GeocoderCache"+ QDir::separator();
         placemarkCache = cache + "PlacemarkCache" + QDir::separator();
+        tilePackCache = cache + "TilePacks" + QDir::separator();
         ImageCache.setGtileCache(value);
+        TilePacks.Load(tilePackCache);
     }
     QString Cache::CacheLocation()
     {
         return cache;
     }
+    QString Cache::TilePackLocation()
+    {
+        return tilePackCache;
+    }
     Cache::Cache()
     {
         if(cache.isNull()|cache.isEmpty())
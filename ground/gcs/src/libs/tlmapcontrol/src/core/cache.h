@@ -29,6 +29,7 @@
 #define CACHE_H
 
 #include "pureimagecache.h"
+#include "tilepack.h"
 #include "debugheader.h"
 
 namespace core {
@@ -39,7 +40,9 @@ namespace core {
 
 
         PureImageCache ImageCache;
+        TilePackCache TilePacks;
         QString CacheLocation();
+        QString TilePackLocation();
         void setCacheLocation(const QString& value);
         void CacheGeocoder(const QString &urlEnd,const QString &content);
         QString GetGeocoderFromCache(const QString &urlEnd);
@@ -57,6 +60,7 @@ namespace core {
         QString routeCache;
         QString geoCache;
         QString placemarkCache;
+        QString tilePackCache;
     };
 
 }
@@ -15,6 +15,7 @@ SOURCES += \
     size.cpp \
     kibertilecache.cpp \
     diagnostics.cpp \
+    tilepack.cpp \
     tlmaps.cpp
 HEADERS += \
     size.h \
@@ -36,4 +37,5 @@ HEADERS += \
     kibertilecache.h \
     debugheader.h \
     diagnostics.h \
+    tilepack.h \
     tlmaps.h
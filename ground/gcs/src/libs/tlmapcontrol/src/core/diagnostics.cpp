@@ -27,6 +27,7 @@
 */
 #include "diagnostics.h"
 
-diagnostics::diagnostics():networkerrors(0),emptytiles(0),timeouts(0),runningThreads(0),tilesFromMem(0),tilesFromNet(0),tilesFromDB(0)
+diagnostics::diagnostics():networkerrors(0),emptytiles(0),timeouts(0),runningThreads(0),tilesFromMem(0),tilesFromNet(0),tilesFromDB(0),tilesFromPack(0),
+    memCacheHits(0),memCacheMisses(0),memCacheEvictions(0),decodedCacheHits(0),decodedCacheMisses(0),decodedCacheEvictions(0)
 {
 }
@@ -38,10 +38,18 @@ struct diagnostics
     int tilesFromMem;
     int tilesFromNet;
     int tilesFromDB;
+    int tilesFromPack;
+    int memCacheHits;
+    int memCacheMisses;
+    int memCacheEvictions;
+    int decodedCacheHits;
+    int decodedCacheMisses;
+    int decodedCacheEvictions;
     QString toString()
     {
-        return QString("Network errors:%1\nEmpty Tiles:%2\nTimeOuts:%3\nRunningThreads:%4\nTilesFromMem:%5\nTilesFromNet:%6\nTilesFromDB:%7").arg(networkerrors).arg(emptytiles).arg(timeouts).arg(runningThreads).arg(tilesFromMem).arg(tilesFromNet).arg(tilesFromDB);
-       ;
+        return QString("Network errors:%1\nEmpty Tiles:%2\nTimeOuts:%3\nRunningThreads:%4\nTilesFromMem:%5\nTilesFromNet:%6\nTilesFromDB:%7").arg(networkerrors).arg(emptytiles).arg(timeouts).arg(runningThreads).arg(tilesFromMem).arg(tilesFromNet).arg(tilesFromDB)
+                +QString("\nTilesFromPack:%1").arg(tilesFromPack)
+                +QString("\nMemCache Hits/Misses/Evictions:%1/%2/%3\nDecodedCache Hits/Misses/Evictions:%4/%5/%6").arg(memCacheHits).arg(memCacheMisses).arg(memCacheEvictions).arg(decodedCacheHits).arg(decodedCacheMisses).arg(decodedCacheEvictions);
     }
 };
 
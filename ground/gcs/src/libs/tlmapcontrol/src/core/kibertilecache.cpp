@@ -27,44 +27,110 @@
 */
 #include "kibertilecache.h"
 
-//TODO add readwrite lock
-
 namespace core {
+    // Capacities are set in MB, costs counted in bytes
+    static int MegabytesToCost(int value)
+    {
+        return qBound(0,value,2047)*1048576;
+    }
+
     KiberTileCache::KiberTileCache()
+        :hits(0),misses(0),evictions(0),decodedHits(0),decodedMisses(0),decodedEvictions(0)
     {
-        memoryCacheSize = 0;
-        _MemoryCacheCapacity = 22;
+        tiles.setMaxCost(MegabytesToCost(22));
+        decodedTiles.setMaxCost(MegabytesToCost(64));
     }
 
     void KiberTileCache::setMemoryCacheCapacity(const int &value)
     {
-        kiberCacheLock.lockForWrite();
-        _MemoryCacheCapacity=value;
-        kiberCacheLock.unlock();
+        QMutexLocker locker(&mutex);
+        int count=tiles.count();
+        tiles.setMaxCost(MegabytesToCost(value));
+        evictions+=count-tiles.count();
     }
     int KiberTileCache::MemoryCacheCapacity()
     {
-        kiberCacheLock.lockForRead();
-        return _MemoryCacheCapacity;
-        kiberCacheLock.unlock();
+        QMutexLocker locker(&mutex);
+        return tiles.maxCost()/1048576;
+    }
+    double KiberTileCache::MemoryCacheSize()
+    {
+        QMutexLocker locker(&mutex);
+        return tiles.totalCost()/1048576.0;
+    }
+    void KiberTileCache::setDecodedCacheCapacity(const int &value)
+    {
+        QMutexLocker locker(&mutex);
+        int count=decodedTiles.count();
+        decodedTiles.setMaxCost(MegabytesToCost(value));
+        decodedEvictions+=count-decodedTiles.count();
+    }
+    int KiberTileCache::DecodedCacheCapacity()
+    {
+        QMutexLocker locker(&mutex);
+        return decodedTiles.maxCost()/1048576;
+    }
+    double KiberTileCache::DecodedCacheSize()
+    {
+        QMutexLocker locker(&mutex);
+        return decodedTiles.totalCost()/1048576.0;
     }
 
-    void KiberTileCache::RemoveMemoryOverload()
+    QByteArray KiberTileCache::GetTile(const RawTile &tile)
     {
-        while(MemoryCacheSize()>MemoryCacheCapacity())
+        QMutexLocker locker(&mutex);
+        // Looking a tile up makes it the most recently used
+        QByteArray *pic=tiles.object(tile);
+        if(!pic)
         {
-            if(cachequeue.count()>0 && list.count()>0)
-            {
+            ++misses;
+            return QByteArray();
+        }
+        ++hits;
+        return *pic;
+    }
+    void KiberTileCache::AddTile(const RawTile &tile, const QByteArray &pic)
+    {
+        QMutexLocker locker(&mutex);
+        int count=tiles.count()+(tiles.contains(tile)?0:1);
+        // Drops least recently used tiles until the new one fits
+        tiles.insert(tile,new QByteArray(pic),pic.size());
+        evictions+=count-tiles.count();
 #ifdef DEBUG_MEMORY_CACHE
-                qDebug()<<"Cleaning Memory cache="<<" started with "<<cachequeue.count()<<" tile "<<"ocupying "<<memoryCacheSize<<" bytes";
+        qDebug()<<"Current memory="<<tiles.totalCost()<<" in "<<tiles.count()<<" tiles";
 #endif
-                RawTile first=list.dequeue();
-                memoryCacheSize-=cachequeue.value(first).size();
-                cachequeue.remove(first);
-            }
+    }
+    QImage KiberTileCache::GetDecodedTile(const RawTile &tile)
+    {
+        QMutexLocker locker(&mutex);
+        QImage *image=decodedTiles.object(tile);
+        if(!image)
+        {
+            ++decodedMisses;
+            return QImage();
         }
+        ++decodedHits;
+        return *image;
+    }
+    void KiberTileCache::AddDecodedTile(const RawTile &tile, const QImage &image)
+    {
+        QMutexLocker locker(&mutex);
+        int count=decodedTiles.count()+(decodedTiles.contains(tile)?0:1);
+        decodedTiles.insert(tile,new QImage(image),image.byteCount());
+        decodedEvictions+=count-decodedTiles.count();
 #ifdef DEBUG_MEMORY_CACHE
-        qDebug()<<"Cleaning Memory cache="<<" ended with "<<cachequeue.count()<<" tile "<<"ocupying "<<memoryCacheSize<<" bytes";
+        qDebug()<<"Current decoded memory="<<decodedTiles.totalCost()<<" in "<<decodedTiles.count()<<" tiles";
 #endif
     }
+
+    void KiberTileCache::GetDiagnostics(diagnostics &diag)
+    {
+        QMutexLocker locker(&mutex);
+        diag.memCacheHits=hits;
+        diag.memCacheMisses=misses;
+        diag.memCacheEvictions=evictions;
+        diag.decodedCacheHits=decodedHits;
+        diag.decodedCacheMisses=decodedMisses;
+        diag.decodedCacheEvictions=decodedEvictions;
+    }
 }
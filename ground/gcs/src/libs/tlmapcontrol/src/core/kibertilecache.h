@@ -29,12 +29,20 @@
 #define KIBERTILECACHE_H
 
 #include "rawtile.h"
+#include "diagnostics.h"
 #include <QMutex>
-#include <QReadWriteLock>
-#include <QQueue>
+#include <QCache>
+#include <QByteArray>
+#include <QImage>
 #include <QDebug>
 #include "debugheader.h"
 namespace core {
+    /**
+     * Memory cache of map tiles in two tiers, each bounded by a byte budget
+     * and evicting the least recently used tile first. The first tier holds
+     * the tiles as fetched, the second the decoded images ready to draw.
+     * All methods are thread safe.
+     */
     class KiberTileCache
     {
     public:
@@ -42,14 +50,27 @@ namespace core {
 
         void setMemoryCacheCapacity(const int &value);
         int MemoryCacheCapacity();
-        double MemoryCacheSize(){return memoryCacheSize/1048576.0;}
-        void RemoveMemoryOverload();
-        QReadWriteLock kiberCacheLock;
-        QHash <RawTile,QByteArray> cachequeue;
-        QQueue <RawTile> list;
-        long memoryCacheSize;
+        double MemoryCacheSize();
+        void setDecodedCacheCapacity(const int &value);
+        int DecodedCacheCapacity();
+        double DecodedCacheSize();
+
+        QByteArray GetTile(const RawTile &tile);
+        void AddTile(const RawTile &tile,const QByteArray &pic);
+        QImage GetDecodedTile(const RawTile &tile);
+        void AddDecodedTile(const RawTile &tile,const QImage &image);
+
+        void GetDiagnostics(diagnostics &diag);
     private:
-        int _MemoryCacheCapacity;
+        QMutex mutex;
+        QCache<RawTile,QByteArray> tiles;
+        QCache<RawTile,QImage> decodedTiles;
+        int hits;
+        int misses;
+        int evictions;
+        int decodedHits;
+        int decodedMisses;
+        int decodedEvictions;
 
     };
 
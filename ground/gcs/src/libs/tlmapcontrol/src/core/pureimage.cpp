@@ -44,4 +44,15 @@ bool PureImageProxy::Save(const QByteArray &array, QPixmap &pic)
     pic=QPixmap::fromImage(QImage::fromData(array));
     return true;
 }
+/**
+ * Decodes a tile into a format that can be painted without converting it
+ * again. Unlike QPixmap this is safe outside the GUI thread.
+ */
+QImage PureImageProxy::Decode(const QByteArray &array)
+{
+    QImage image=QImage::fromData(array);
+    if(!image.isNull() && image.format()!=QImage::Format_RGB32 && image.format()!=QImage::Format_ARGB32_Premultiplied)
+        image=image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    return image;
+}
 }
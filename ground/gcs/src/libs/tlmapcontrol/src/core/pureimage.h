@@ -29,6 +29,7 @@
 #define PUREIMAGE_H
 
 #include <QPixmap>
+#include <QImage>
 #include <QByteArray>
 
 
@@ -39,6 +40,7 @@ namespace core {
         PureImageProxy();
         static QPixmap FromStream(const QByteArray &array);
         static bool Save(const QByteArray &array,QPixmap &pic);
+        static QImage Decode(const QByteArray &array);
     };
 
 }
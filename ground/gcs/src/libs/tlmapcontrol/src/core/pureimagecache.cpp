@@ -27,6 +27,8 @@
 */
 #include "pureimagecache.h"
 #include <QDateTime>
+#include <QReadLocker>
+#include <QMutexLocker>
 #include <QSettings>
 //#define DEBUG_PUREIMAGECACHE
 namespace core {
@@ -36,6 +38,19 @@ namespace core {
     {
 
     }
+    PureImageCache::~PureImageCache()
+    {
+        connections.setLocalData(0);
+
+        // Qt only deletes the connections of other threads when they finish
+        // while the thread storage still exists, so close them here. Their
+        // emptied structs are deleted if those threads finish first, and
+        // leaked otherwise.
+        QMutexLocker locker(&connectionsLock);
+        foreach(Connection *cn, openConnections)
+            cn->close();
+        openConnections.clear();
+    }
 
     void PureImageCache::setGtileCache(const QString &value)
     {
@@ -59,6 +74,8 @@ namespace core {
                 CreateEmptyDB(db);
             }
         }
+        // Threads reopen their connections on the new database
+        generation.ref();
         lock.unlock();
     }
     QString PureImageCache::GtileCache()
@@ -166,135 +183,188 @@ namespace core {
             db.close();
             return false;
         }
+        query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
         db.close();
         QSqlDatabase::removeDatabase(QLatin1String("CreateConn"));
         return true;
     }
-    bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
+    PureImageCache::Connection::Connection(PureImageCache *owner, const QString &name, int generation)
+        : owner(owner), name(name), generation(generation), selectTile(0), insertTile(0), insertTileData(0)
     {
-        if(gtilecache.isEmpty()|gtilecache.isNull())
-            return false;
-        lock.lockForRead();
+    }
+    PureImageCache::Connection::~Connection()
+    {
+        {
+            QMutexLocker locker(&owner->connectionsLock);
+            owner->openConnections.removeOne(this);
+        }
+        close();
+    }
+    /**
+     * Closes the connection, once. Called by the thread that owns it, or by
+     * the cache's destructor for threads that are still running.
+     */
+    void PureImageCache::Connection::close()
+    {
+        if(name.isEmpty())
+            return;
+
+        // The statements and handle must be gone before the connection is removed
+        delete selectTile;
+        delete insertTile;
+        delete insertTileData;
+        selectTile=0;
+        insertTile=0;
+        insertTileData=0;
+        db.close();
+        db=QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+        name.clear();
+    }
+    bool PureImageCache::Connection::open(const QString &file)
+    {
+        db = QSqlDatabase::addDatabase("QSQLITE",name);
+        db.setDatabaseName(file);
+        if(!db.open())
+        {
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"PutImageToCache Start:";//<<pos;
+            qDebug()<<"Connection: "<<db.lastError().driverText();
 #endif //DEBUG_PUREIMAGECACHE
+            return false;
+        }
+        {
+            // Write ahead logging lets readers carry on while tiles are written
+            QSqlQuery query(db);
+            query.exec("PRAGMA journal_mode=WAL");
+            query.exec("PRAGMA synchronous=NORMAL");
+            // Databases created before the index existed get it on first use
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+        }
+        selectTile=new QSqlQuery(db);
+        selectTile->prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)");
+        insertTile=new QSqlQuery(db);
+        insertTile->prepare("INSERT INTO Tiles(X, Y, Zoom, Type, Date) VALUES(?, ?, ?, ?, ?)");
+        insertTileData=new QSqlQuery(db);
+        insertTileData->prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
+        return true;
+    }
+    /**
+     * Returns this thread's connection to the current database, opening it
+     * if needed. Must be called with the lock held.
+     */
+    PureImageCache::Connection *PureImageCache::threadConnection()
+    {
+        Connection *cn=connections.localData();
+        if(cn && cn->generation==generation)
+            return cn;
+
+        // Drops any connection to a previous database
+        connections.setLocalData(0);
+
         Mcounter.lock();
         qlonglong id=++ConnCounter;
         Mcounter.unlock();
+        cn=new Connection(this,QString::number(id),generation);
+        if(!cn->open(gtilecache+"Data.qmdb"))
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
-            {
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
-                }
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
-                }
-                cn.close();
-            }
+            delete cn;
+            return 0;
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
-        lock.unlock();
-        return true;
+        connectionsLock.lock();
+        openConnections.append(cn);
+        connectionsLock.unlock();
+        connections.setLocalData(cn);
+        return cn;
+    }
+    bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
+    {
+        CacheItemQueue item(type,pos,tile,zoom);
+        return PutImagesToCache(QList<CacheItemQueue*>()<<&item);
+    }
+    /**
+     * Writes a batch of tiles in one transaction, so the disk is synced once
+     * per batch rather than once per tile.
+     */
+    bool PureImageCache::PutImagesToCache(const QList<CacheItemQueue*> &tiles)
+    {
+        if(gtilecache.isEmpty()|gtilecache.isNull())
+            return false;
+        QReadLocker locker(&lock);
+#ifdef DEBUG_PUREIMAGECACHE
+        qDebug()<<"PutImagesToCache Start:"<<tiles.count();
+#endif //DEBUG_PUREIMAGECACHE
+        Connection *cn=threadConnection();
+        if(!cn)
+            return false;
+        QString date=QDateTime::currentDateTime().toString();
+        cn->db.transaction();
+        foreach(CacheItemQueue *tile,tiles)
+        {
+            cn->insertTile->bindValue(0,tile->GetPosition().X());
+            cn->insertTile->bindValue(1,tile->GetPosition().Y());
+            cn->insertTile->bindValue(2,tile->GetZoom());
+            cn->insertTile->bindValue(3,(int)tile->GetMapType());
+            cn->insertTile->bindValue(4,date);
+            if(!cn->insertTile->exec())
+                continue;
+            cn->insertTileData->bindValue(0,tile->GetImg());
+            cn->insertTileData->exec();
+        }
+        return cn->db.commit();
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
-        lock.lockForRead();
         QByteArray ar;
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return ar;
-        QString dir=gtilecache;
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        QReadLocker locker(&lock);
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"Cache dir="<<dir<<" Try to GET:"<<pos.X()+","+pos.Y();
+        qDebug()<<"Cache dir="<<gtilecache<<" Try to GET:"<<pos.X()+","+pos.Y();
 #endif //DEBUG_PUREIMAGECACHE
-
-        {
-            QString db=dir+"Data.qmdb";
-            {
-                QSqlDatabase cn;
-
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int) type));
-                        query.next();
-                        if(query.isValid())
-                        {
-                            ar=query.value(0).toByteArray();
-                        }
-                    }
-                    cn.close();
-                }
-            }
-        }
-        QSqlDatabase::removeDatabase(QString::number(id));
-        lock.unlock();
+        Connection *cn=threadConnection();
+        if(!cn)
+            return ar;
+        cn->selectTile->bindValue(0,pos.X());
+        cn->selectTile->bindValue(1,pos.Y());
+        cn->selectTile->bindValue(2,zoom);
+        cn->selectTile->bindValue(3,(int)type);
+        if(cn->selectTile->exec() && cn->selectTile->next())
+            ar=cn->selectTile->value(0).toByteArray();
+        // Release the read snapshot so the log can be checkpointed
+        cn->selectTile->finish();
         return ar;
     }
     void PureImageCache::deleteOlderTiles(int const& days)
     {
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return;
+        QReadLocker locker(&lock);
+        if(!QFileInfo(gtilecache+"Data.qmdb").exists())
+            return;
+        Connection *cn=threadConnection();
+        if(!cn)
+            return;
         QList<long> add;
-        bool ret=true;
-        QString dir=gtilecache;
         {
-            QString db=dir+"Data.qmdb";
-            ret=QFileInfo(db).exists();
-            if(ret)
+            QSqlQuery query(cn->db);
+            query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
+            while(query.next())
             {
-                QSqlDatabase cn;
-                Mcounter.lock();
-                qlonglong id=++ConnCounter;
-                Mcounter.unlock();
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
-                        while(query.next())
-                        {
-                            if(QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime())>days)
-                                add.append(query.value(0).toLongLong());
-                        }
-                        foreach(long i,add)
-                        {
-                            query.exec(QString("DELETE FROM Tiles WHERE id = %1;").arg(i));
-                        }
-                    }
-
-                    cn.close();
-                }
-                QSqlDatabase::removeDatabase(QString::number(id));
+                if(QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime())>days)
+                    add.append(query.value(0).toLongLong());
+            }
+        }
+        cn->db.transaction();
+        {
+            QSqlQuery query(cn->db);
+            query.prepare("DELETE FROM Tiles WHERE id = ?");
+            foreach(long i,add)
+            {
+                query.bindValue(0,(qlonglong)i);
+                query.exec();
             }
         }
+        cn->db.commit();
     }
     // PureImageCache::ExportMapDataToDB("C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data.qmdb","C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data2.qmdb");
     bool PureImageCache::ExportMapDataToDB(QString sourceFile, QString destFile)
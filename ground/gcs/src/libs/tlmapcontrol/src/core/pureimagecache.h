@@ -43,24 +43,58 @@
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
+#include <QAtomicInt>
+#include "cacheitemqueue.h"
 namespace core {
     class PureImageCache
     {
 
     public:
         PureImageCache();
+        ~PureImageCache();
         static bool CreateEmptyDB(const QString &file);
         bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
+        bool PutImagesToCache(const QList<CacheItemQueue*> &tiles);
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
         QString GtileCache();
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
     private:
+        /**
+         * An open database connection and its prepared statements. Qt only
+         * allows a connection to be used by the thread that opened it, so
+         * each thread keeps its own for as long as it runs.
+         */
+        struct Connection
+        {
+            Connection(PureImageCache *owner, const QString &name, int generation);
+            ~Connection();
+            bool open(const QString &file);
+            void close();
+
+            PureImageCache *owner;
+            QString name;
+            int generation;
+            QSqlDatabase db;
+            QSqlQuery *selectTile;
+            QSqlQuery *insertTile;
+            QSqlQuery *insertTileData;
+        };
+        Connection *threadConnection();
+
         QString gtilecache;
         QMutex Mcounter;
         QReadWriteLock lock;
         static qlonglong ConnCounter;
+        // Every open connection, so the ones of threads still running when
+        // the cache goes can be closed. Declared before the thread storage
+        // so they outlive it.
+        QMutex connectionsLock;
+        QList<Connection*> openConnections;
+        QThreadStorage<Connection*> connections;
+        QAtomicInt generation;
 
     };
 
@@ -45,12 +45,12 @@ void TileCacheQueue::EnqueueCacheTask(CacheItemQueue *task)
 #ifdef DEBUG_TILECACHEQUEUE
     qDebug()<<"DB Do I EnqueueCacheTask"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
 #endif //DEBUG_TILECACHEQUEUE
+    mutex.lock();
     if(!tileCacheQueue.contains(task))
     {
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug()<<"EnqueueCacheTask"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
 #endif //DEBUG_TILECACHEQUEUE
-        mutex.lock();
         tileCacheQueue.enqueue(task);
         mutex.unlock();
         if(this->isRunning())
@@ -71,6 +71,8 @@ void TileCacheQueue::EnqueueCacheTask(CacheItemQueue *task)
             this->start(QThread::NormalPriority);
         }
     }
+    else
+        mutex.unlock();
 
 }
 void TileCacheQueue::run()
@@ -80,21 +82,22 @@ void TileCacheQueue::run()
 #endif //DEBUG_TILECACHEQUEUE
     while(true)
     {
-        CacheItemQueue *task;
+        QList<CacheItemQueue*> batch;
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug()<<"Cache";
 #endif //DEBUG_TILECACHEQUEUE
-        if(tileCacheQueue.count()>0)
+        // Everything queued so far goes into one transaction
+        mutex.lock();
+        while(!tileCacheQueue.isEmpty() && batch.count()<MaxBatchSize)
+            batch.append(tileCacheQueue.dequeue());
+        mutex.unlock();
+        if(batch.count()>0)
         {
-            mutex.lock();
-            task=tileCacheQueue.dequeue();
-            mutex.unlock();
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache engine Put:"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
+            qDebug()<<"Cache engine Put:"<<batch.count()<<"tiles";
 #endif //DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom());
-            usleep(44);
-            delete task;
+            Cache::Instance()->ImageCache.PutImagesToCache(batch);
+            qDeleteAll(batch);
         }
 
         else
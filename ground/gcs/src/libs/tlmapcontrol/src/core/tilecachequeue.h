@@ -52,6 +52,8 @@ namespace core {
         QQueue<CacheItemQueue*> tileCacheQueue;
     private:
         void run();
+        //! Most tiles written in one transaction
+        static const int MaxBatchSize=256;
         QMutex mutex;
         QMutex waitmutex;
         QWaitCondition waitc;
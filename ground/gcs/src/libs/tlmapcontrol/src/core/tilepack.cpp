@@ -0,0 +1,348 @@
+/**
+******************************************************************************
+*
+* @file       tilepack.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+* @brief      Memory mapped archive of map tiles for offline use
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   OPMapWidget
+* @{
+* 
+*****************************************************************************/
+/* 
+* This program is free software; you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License as published by 
+* the Free Software Foundation; either version 3 of the License, or 
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful, but 
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+* for more details.
+* 
+* You should have received a copy of the GNU General Public License along 
+* with this program; if not, write to the Free Software Foundation, Inc., 
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "tilepack.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QtAlgorithms>
+#include <QDebug>
+
+namespace core {
+    TilePack::TilePack():base(0),size(0),index(0),count(0)
+    {
+    }
+    TilePack::~TilePack()
+    {
+        if(base)
+            file.unmap(const_cast<uchar*>(base));
+    }
+
+    /**
+     * @brief TilePack::Open Maps a pack file and checks its header
+     * @return False if the file is missing, truncated or not a pack
+     */
+    bool TilePack::Open(const QString &fileName)
+    {
+        file.setFileName(fileName);
+        if(!file.open(QIODevice::ReadOnly))
+            return false;
+        size=file.size();
+        if(size>=HeaderSize)
+            base=file.map(0,size);
+        if(!base)
+        {
+            file.close();
+            return false;
+        }
+
+        quint32 magic=qFromLittleEndian<quint32>(base);
+        quint32 version=qFromLittleEndian<quint32>(base+4);
+        quint32 tiles=qFromLittleEndian<quint32>(base+8);
+        quint64 indexOffset=qFromLittleEndian<quint64>(base+16);
+        // Compared without adding the offset, which is read from the file and could wrap
+        if(magic!=Magic || version!=Version || indexOffset>(quint64)size || (quint64)tiles*EntrySize>(quint64)size-indexOffset)
+        {
+            qDebug()<<"TilePack: not a valid tile pack"<<fileName;
+            file.unmap(const_cast<uchar*>(base));
+            base=0;
+            file.close();
+            return false;
+        }
+        index=base+indexOffset;
+        count=tiles;
+        return true;
+    }
+
+    int TilePack::Compare(const uchar *entry,quint32 type,quint32 zoom,qint64 x,qint64 y) const
+    {
+        quint32 entryType=qFromLittleEndian<quint32>(entry);
+        if(entryType!=type)
+            return entryType<type?-1:1;
+        quint32 entryZoom=qFromLittleEndian<quint32>(entry+4);
+        if(entryZoom!=zoom)
+            return entryZoom<zoom?-1:1;
+        qint64 entryX=qFromLittleEndian<qint64>(entry+8);
+        if(entryX!=x)
+            return entryX<x?-1:1;
+        qint64 entryY=qFromLittleEndian<qint64>(entry+16);
+        if(entryY!=y)
+            return entryY<y?-1:1;
+        return 0;
+    }
+
+    /**
+     * @brief TilePack::GetTile Looks a tile up in the index
+     * @return The encoded tile, sharing the mapped file, or an empty array
+     */
+    QByteArray TilePack::GetTile(const MapType::Types &type,const core::Point &pos,const int &zoom) const
+    {
+        quint32 lo=0;
+        quint32 hi=count;
+        while(lo<hi)
+        {
+            quint32 mid=lo+(hi-lo)/2;
+            const uchar *entry=index+(qint64)mid*EntrySize;
+            int cmp=Compare(entry,(quint32)type,(quint32)zoom,pos.X(),pos.Y());
+            if(cmp<0)
+                lo=mid+1;
+            else if(cmp>0)
+                hi=mid;
+            else
+            {
+                quint64 offset=qFromLittleEndian<quint64>(entry+24);
+                quint32 tileSize=qFromLittleEndian<quint32>(entry+32);
+                if(offset>(quint64)size || tileSize>(quint64)size-offset)
+                    return QByteArray();
+                return QByteArray::fromRawData(reinterpret_cast<const char*>(base+offset),tileSize);
+            }
+        }
+        return QByteArray();
+    }
+
+
+    bool TilePackWriter::Entry::operator<(const Entry &other) const
+    {
+        if(type!=other.type)
+            return type<other.type;
+        if(zoom!=other.zoom)
+            return zoom<other.zoom;
+        if(x!=other.x)
+            return x<other.x;
+        if(y!=other.y)
+            return y<other.y;
+        return order<other.order;
+    }
+    TilePackWriter::TilePackWriter():spool(0)
+    {
+    }
+    TilePackWriter::~TilePackWriter()
+    {
+        Abort();
+    }
+
+    /**
+     * @brief TilePackWriter::Begin Starts a new pack. Nothing is written to
+     * the file until Finish().
+     */
+    bool TilePackWriter::Begin(const QString &file)
+    {
+        QMutexLocker locker(&mutex);
+        delete spool;
+        entries.clear();
+        fileName=file;
+        spool=new QTemporaryFile;
+        if(!spool->open())
+        {
+            delete spool;
+            spool=0;
+            return false;
+        }
+        return true;
+    }
+    void TilePackWriter::AddTile(const MapType::Types &type,const core::Point &pos,const int &zoom,const QByteArray &tile)
+    {
+        QMutexLocker locker(&mutex);
+        if(!spool || tile.isEmpty())
+            return;
+        Entry entry;
+        entry.type=type;
+        entry.zoom=zoom;
+        entry.x=pos.X();
+        entry.y=pos.Y();
+        entry.offset=spool->pos();
+        entry.size=tile.size();
+        entry.order=entries.size();
+        if(spool->write(tile)!=tile.size())
+        {
+            // Leave the tile out rather than index a partial write
+            spool->seek(entry.offset);
+            return;
+        }
+        entries.append(entry);
+    }
+    int TilePackWriter::TileCount()
+    {
+        QMutexLocker locker(&mutex);
+        return entries.size();
+    }
+
+    /**
+     * @brief TilePackWriter::Finish Sorts the spooled tiles and writes the
+     * pack. The pack is written beside the target and renamed over it, so
+     * a reader never sees a partial file.
+     * @return False if there was nothing to write or writing failed
+     */
+    bool TilePackWriter::Finish()
+    {
+        QMutexLocker locker(&mutex);
+        if(!spool)
+            return false;
+
+        qSort(entries);
+        QVector<Entry> tiles;
+        tiles.reserve(entries.size());
+        for(int i=0;i<entries.size();++i)
+        {
+            const Entry &entry=entries.at(i);
+            if(i+1<entries.size())
+            {
+                const Entry &next=entries.at(i+1);
+                if(next.type==entry.type && next.zoom==entry.zoom && next.x==entry.x && next.y==entry.y)
+                    continue;
+            }
+            tiles.append(entry);
+        }
+
+        bool ok=!tiles.isEmpty() && spool->flush();
+        const uchar *spooled=ok?spool->map(0,spool->size()):0;
+        ok=ok && spooled;
+
+        QString partName=fileName+".part";
+        QFile out(partName);
+        if(ok)
+        {
+            QDir().mkpath(QFileInfo(fileName).absolutePath());
+            ok=out.open(QIODevice::WriteOnly|QIODevice::Truncate);
+        }
+        if(ok)
+        {
+            const quint64 indexOffset=TilePack::HeaderSize;
+            const quint64 dataOffset=indexOffset+(quint64)tiles.size()*TilePack::EntrySize;
+
+            QByteArray header(TilePack::HeaderSize,0);
+            uchar *h=reinterpret_cast<uchar*>(header.data());
+            qToLittleEndian<quint32>(TilePack::Magic,h);
+            qToLittleEndian<quint32>(TilePack::Version,h+4);
+            qToLittleEndian<quint32>(tiles.size(),h+8);
+            qToLittleEndian<quint64>(indexOffset,h+16);
+            qToLittleEndian<quint64>(dataOffset,h+24);
+
+            QByteArray index(tiles.size()*TilePack::EntrySize,0);
+            quint64 offset=dataOffset;
+            for(int i=0;i<tiles.size();++i)
+            {
+                const Entry &entry=tiles.at(i);
+                uchar *e=reinterpret_cast<uchar*>(index.data())+i*TilePack::EntrySize;
+                qToLittleEndian<quint32>(entry.type,e);
+                qToLittleEndian<quint32>(entry.zoom,e+4);
+                qToLittleEndian<qint64>(entry.x,e+8);
+                qToLittleEndian<qint64>(entry.y,e+16);
+                qToLittleEndian<quint64>(offset,e+24);
+                qToLittleEndian<quint32>(entry.size,e+32);
+                offset+=entry.size;
+            }
+
+            ok=out.write(header)==header.size() && out.write(index)==index.size();
+            for(int i=0;ok && i<tiles.size();++i)
+            {
+                const Entry &entry=tiles.at(i);
+                ok=out.write(reinterpret_cast<const char*>(spooled+entry.offset),entry.size)==entry.size;
+            }
+            out.close();
+            ok=ok && out.error()==QFile::NoError;
+        }
+        if(ok)
+        {
+            QFile::remove(fileName);
+            ok=QFile::rename(partName,fileName);
+        }
+        if(!ok)
+            QFile::remove(partName);
+
+        delete spool;
+        spool=0;
+        entries.clear();
+        return ok;
+    }
+    void TilePackWriter::Abort()
+    {
+        QMutexLocker locker(&mutex);
+        delete spool;
+        spool=0;
+        entries.clear();
+    }
+
+
+    TilePackCache::TilePackCache()
+    {
+    }
+    TilePackCache::~TilePackCache()
+    {
+        qDeleteAll(packs);
+        qDeleteAll(retired);
+    }
+
+    /**
+     * @brief TilePackCache::Load Replaces the searched packs with the ones
+     * in a directory. Newer packs, by file name, are searched first.
+     */
+    void TilePackCache::Load(const QString &dir)
+    {
+        QStringList files=QDir(dir).entryList(QStringList()<<"*.tlpk",QDir::Files,QDir::Name|QDir::Reversed);
+        QList<TilePack*> loaded;
+        foreach(const QString &name,files)
+        {
+            TilePack *pack=new TilePack;
+            if(pack->Open(QDir(dir).filePath(name)))
+                loaded.append(pack);
+            else
+                delete pack;
+        }
+
+        QWriteLocker locker(&lock);
+        retired+=packs;
+        packs=loaded;
+    }
+    bool TilePackCache::Add(const QString &file)
+    {
+        TilePack *pack=new TilePack;
+        if(!pack->Open(file))
+        {
+            delete pack;
+            return false;
+        }
+        QWriteLocker locker(&lock);
+        packs.prepend(pack);
+        return true;
+    }
+    bool TilePackCache::IsEmpty()
+    {
+        QReadLocker locker(&lock);
+        return packs.isEmpty();
+    }
+    QByteArray TilePackCache::GetTile(const MapType::Types &type,const core::Point &pos,const int &zoom)
+    {
+        QReadLocker locker(&lock);
+        foreach(TilePack *pack,packs)
+        {
+            QByteArray tile=pack->GetTile(type,pos,zoom);
+            if(!tile.isEmpty())
+                return tile;
+        }
+        return QByteArray();
+    }
+}
@@ -0,0 +1,138 @@
+/**
+******************************************************************************
+*
+* @file       tilepack.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+* @brief      Memory mapped archive of map tiles for offline use
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   OPMapWidget
+* @{
+* 
+*****************************************************************************/
+/* 
+* This program is free software; you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License as published by 
+* the Free Software Foundation; either version 3 of the License, or 
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful, but 
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+* for more details.
+* 
+* You should have received a copy of the GNU General Public License along 
+* with this program; if not, write to the Free Software Foundation, Inc., 
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef TILEPACK_H
+#define TILEPACK_H
+
+#include "maptype.h"
+#include "point.h"
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+
+namespace core {
+    /**
+     * A read only archive of map tiles in one file, written by the map
+     * ripper for offline use. The file is memory mapped and tiles are
+     * returned as views into the mapping, so a lookup is a binary search
+     * of the index and no copy.
+     *
+     * Layout, all integers little endian:
+     *   header  magic "TLPK", version, tile count, reserved (4 x u32),
+     *           index offset, data offset (2 x u64)
+     *   index   one entry per tile sorted by (type, zoom, x, y):
+     *           type, zoom (2 x u32), x, y (2 x i64), offset (u64),
+     *           size, reserved (2 x u32)
+     *   data    the encoded tiles back to back, in index order
+     */
+    class TilePack
+    {
+    public:
+        TilePack();
+        ~TilePack();
+        bool Open(const QString &file);
+        bool IsOpen() const {return index!=0;}
+        QString FileName() const {return file.fileName();}
+        int TileCount() const {return count;}
+        QByteArray GetTile(const MapType::Types &type,const core::Point &pos,const int &zoom) const;
+
+        static const quint32 Magic=0x4b504c54;
+        static const quint32 Version=1;
+        static const int HeaderSize=32;
+        static const int EntrySize=40;
+    private:
+        Q_DISABLE_COPY(TilePack)
+        int Compare(const uchar *entry,quint32 type,quint32 zoom,qint64 x,qint64 y) const;
+
+        QFile file;
+        const uchar *base;
+        qint64 size;
+        const uchar *index;
+        quint32 count;
+    };
+
+    /**
+     * Builds a tile pack. Tiles may be added from several threads and in
+     * any order; they are spooled to a temporary file and sorted into the
+     * pack by Finish(). A tile added twice keeps its last data.
+     */
+    class TilePackWriter
+    {
+    public:
+        TilePackWriter();
+        ~TilePackWriter();
+        bool Begin(const QString &file);
+        void AddTile(const MapType::Types &type,const core::Point &pos,const int &zoom,const QByteArray &tile);
+        bool Finish();
+        void Abort();
+        int TileCount();
+        QString FileName() const {return fileName;}
+    private:
+        struct Entry
+        {
+            quint32 type;
+            quint32 zoom;
+            qint64 x;
+            qint64 y;
+            quint64 offset;
+            quint32 size;
+            quint32 order;
+            bool operator<(const Entry &other) const;
+        };
+
+        QMutex mutex;
+        QString fileName;
+        QTemporaryFile *spool;
+        QVector<Entry> entries;
+    };
+
+    /**
+     * The packs found in the cache location, searched before the tile
+     * database. Packs stay mapped until the cache is destroyed, since the
+     * tiles handed out point into them.
+     */
+    class TilePackCache
+    {
+    public:
+        TilePackCache();
+        ~TilePackCache();
+        void Load(const QString &dir);
+        bool Add(const QString &file);
+        bool IsEmpty();
+        QByteArray GetTile(const MapType::Types &type,const core::Point &pos,const int &zoom);
+    private:
+        QReadWriteLock lock;
+        QList<TilePack*> packs;
+        QList<TilePack*> retired;
+    };
+
+}
+#endif // TILEPACK_H
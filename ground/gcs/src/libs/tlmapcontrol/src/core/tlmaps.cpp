@@ -328,6 +328,19 @@ namespace core {
             qDebug()<<"Tile not in memory";
 #endif //DEBUG_GMAPS
 
+            //Attempt to read tile from the offline packs, without copying it
+            if(accessmode != (AccessMode::ServerOnly) && type != MapType::UserImage)
+            {
+                ret=Cache::Instance()->TilePacks.GetTile(type,pos,zoom);
+                if(!ret.isEmpty())
+                {
+                    errorvars.lock();
+                    ++diag.tilesFromPack;
+                    errorvars.unlock();
+                    return ret;
+                }
+            }
+
             //Attempt to read tile from cache
             if(accessmode != (AccessMode::ServerOnly) && type != MapType::UserImage) //Don't use cache if the user supplies a file. This is because
             {
@@ -538,6 +551,7 @@ namespace core {
         errorvars.lock();
         i=diag;
         errorvars.unlock();
+        TilesInMemory.GetDiagnostics(i);
         return i;
     }
 }
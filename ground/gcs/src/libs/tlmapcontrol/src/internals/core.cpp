@@ -44,11 +44,11 @@ namespace internals {
         renderOffset=Point(0,0);
         dragPoint=Point(0,0);
         CanDragMap=true;
-        tilesToload=0;
         TLMaps::Instance();
     }
     Core::~Core()
     {
+        loadScheduler.Clear();
         ProcessLoadTaskCallback.waitForDone();
     }
 
@@ -65,31 +65,30 @@ namespace internals {
         qDebug()<<"core:run"<<" ID="<<debug;
 #endif //DEBUG_CORE
         bool last = false;
+        bool prefetch = false;
+        int generation = 0;
 
         LoadTask task;
 
-        MtileLoadQueue.lock();
+        // Most urgent tile first, see TileLoadScheduler
+        if(loadScheduler.Take(task, generation))
         {
-            if(tileLoadQueue.count() > 0)
-            {
-                task = tileLoadQueue.dequeue();
-                {
-
-                    last = (tileLoadQueue.count() == 0);
+            prefetch = loadScheduler.IsPrefetch(task);
+            last = !prefetch && (loadScheduler.PendingInView() == 0);
 #ifdef DEBUG_CORE
-                    qDebug()<<"TileLoadQueue: " << tileLoadQueue.count()<<" Point:"<<task.Pos.ToString()<<" ID="<<debug;;
+            qDebug()<<"TileLoadQueue: " << loadScheduler.PendingInView()<<" Point:"<<task.Pos.ToString()<<" ID="<<debug;;
 #endif //DEBUG_CORE
-                }
-            }
         }
-        MtileLoadQueue.unlock();
+
+        if(task.HasValue() && !loaderLimit.tryAcquire(1,TLMaps::Instance()->Timeout))
+        {
+            // Given up on, the next UpdateBounds() queues it again
+            loadScheduler.Finish(task);
+            task = LoadTask();
+        }
 
         if(task.HasValue())
-            if(loaderLimit.tryAcquire(1,TLMaps::Instance()->Timeout))
             {
-            MtileToload.lock();
-            --tilesToload;
-            MtileToload.unlock();
 #ifdef DEBUG_CORE
             qDebug()<<"loadLimit semaphore aquired "<<loaderLimit.available()<<" ID="<<debug<<" TASK="<<task.Pos.ToString()<<" "<<task.Zoom;
 #endif //DEBUG_CORE
@@ -100,9 +99,10 @@ namespace internals {
                 qDebug()<<"task as value, begining get"<<" ID="<<debug;;
 #endif //DEBUG_CORE
                 {
-                    Tile* m = Matrix.TileAt(task.Pos);
+                    // Prefetched tiles belong to the next zoom level, not the matrix
+                    Tile* m = prefetch ? 0 : Matrix.TileAt(task.Pos);
 
-                    if(m==0 || m->Overlays.count() == 0)
+                    if((m==0 || m->Overlays.count() == 0) && loadScheduler.IsWanted(task, generation))
                     {
 #ifdef DEBUG_CORE
                         qDebug()<<"Fill empty TileMatrix: " + task.ToString()<<" ID="<<debug;;
@@ -113,39 +113,58 @@ namespace internals {
 
                         foreach(MapType::Types tl,layers)
                         {
+                            // Stop loading tiles that went out of view
+                            if(!loadScheduler.IsWanted(task, generation))
+                                break;
+
                             int retry = 0;
 
                             do
                             {
-                                QByteArray tileImage;
-
-                                // tile number inversion(BottomLeft -> TopLeft) for pergo maps
-                                if(tl == MapType::PergoTurkeyMap)
-                                {
-                                    tileImage = TLMaps::Instance()->GetImageFromServer(tl, Point(task.Pos.X(), maxOfTiles.Height() - task.Pos.Y()), task.Zoom);
-                                }
-                                else if(tl == MapType::UserImage)
-                                {
-                                    tileImage = TLMaps::Instance()->GetImageFromFile(tl, task.Pos, task.Zoom, userImageHorizontalScale, userImageVerticalScale, userImageLocation, Projection());
-                                }
-                                else // ok
+                                RawTile key(tl, task.Pos, task.Zoom);
+                                // Tiles cut from a user supplied image depend on more than their position
+                                bool cacheDecoded = TLMaps::Instance()->UseMemoryCache() && (tl != MapType::UserImage);
+                                QImage tileImage;
+                                if(cacheDecoded)
+                                    tileImage = TLMaps::Instance()->GetDecodedTileFromMemoryCache(key);
+
+                                // Only decode tiles that are not decoded already
+                                if(tileImage.isNull())
                                 {
+                                    QByteArray tileData;
+
+                                    // tile number inversion(BottomLeft -> TopLeft) for pergo maps
+                                    if(tl == MapType::PergoTurkeyMap)
+                                    {
+                                        tileData = TLMaps::Instance()->GetImageFromServer(tl, Point(task.Pos.X(), maxOfTiles.Height() - task.Pos.Y()), task.Zoom);
+                                    }
+                                    else if(tl == MapType::UserImage)
+                                    {
+                                        tileData = TLMaps::Instance()->GetImageFromFile(tl, task.Pos, task.Zoom, userImageHorizontalScale, userImageVerticalScale, userImageLocation, Projection());
+                                    }
+                                    else // ok
+                                    {
 #ifdef DEBUG_CORE
-                                    qDebug()<<"start getting image"<<" ID="<<debug;
+                                        qDebug()<<"start getting image"<<" ID="<<debug;
 #endif //DEBUG_CORE
-                                    tileImage = TLMaps::Instance()->GetImageFromServer(tl, task.Pos, task.Zoom);
+                                        tileData = TLMaps::Instance()->GetImageFromServer(tl, task.Pos, task.Zoom);
 #ifdef DEBUG_CORE
-                                    qDebug()<<"Core::run:gotimage size:"<<tileImage.count()<<" ID="<<debug;
+                                        qDebug()<<"Core::run:gotimage size:"<<tileData.count()<<" ID="<<debug;
 #endif //DEBUG_CORE
+                                    }
+
+                                    tileImage = PureImageProxy::Decode(tileData);
+                                    if(cacheDecoded && !tileImage.isNull())
+                                        TLMaps::Instance()->AddDecodedTileToMemoryCache(key, tileImage);
                                 }
 
-                                if(tileImage.length()!=0)
+                                if(!tileImage.isNull())
                                 {
                                     Moverlays.lock();
                                     {
                                         t->Overlays.append(tileImage);
 #ifdef DEBUG_CORE
-                                        qDebug()<<"Core::run append tileImage:"<<tileImage.length()<<" to tile:"<<t->GetPos().ToString()<<" now has "<<t->Overlays.count()<<" overlays"<<" ID="<<debug;
+                                        qDebug()<<"Core::run append tileImage:"<<tileImage.size()<<" to tile:"<<t->GetPos().ToString()<<" now has "<<t->Overlays.count()<<" overlays"<<" ID="<<debug;
 #endif //DEBUG_CORE
 
                                     }
@@ -169,7 +188,9 @@ namespace internals {
                             while((++retry < TLMaps::Instance()->RetryLoadTile) && (tl == MapType::UserImage));
                         }
 
-                        if(t->Overlays.count() > 0)
+                        // A prefetched tile has done its job once it is in the memory cache,
+                        // unless the view zoomed in to it meanwhile
+                        if(t->Overlays.count() > 0 && !loadScheduler.IsPrefetch(task) && loadScheduler.IsWanted(task, generation))
                         {
                             Matrix.SetTileAt(task.Pos,t);
                             emit OnNeedInvalidation();
@@ -197,10 +218,6 @@ namespace internals {
                     // last buddy cleans stuff ;}
                     if(last)
                     {
-                        TLMaps::Instance()->kiberCacheLock.lockForWrite();
-                        TLMaps::Instance()->TilesInMemory.RemoveMemoryOverload();
-                        TLMaps::Instance()->kiberCacheLock.unlock();
-
                         MtileDrawingList.lock();
                         {
                             Matrix.ClearPointsNotIn(tileDrawingList);
@@ -222,7 +239,8 @@ namespace internals {
 #ifdef DEBUG_CORE
             qDebug()<<"loaderLimit release:"+loaderLimit.available()<<" ID="<<debug;
 #endif
-            emit OnTilesStillToLoad(tilesToload<0? 0:tilesToload);
+            loadScheduler.Finish(task);
+            emit OnTilesStillToLoad(loadScheduler.PendingInView());
             loaderLimit.release();
         }
         MrunningThreads.lock();
@@ -249,12 +267,8 @@ namespace internals {
             currentPositionPixel=Projection()->FromLatLngToPixel(currentPosition, value);
             if(started)
             {
-                MtileLoadQueue.lock();
-                tileLoadQueue.clear();
-                MtileLoadQueue.unlock();
-                MtileToload.lock();
-                tilesToload=0;
-                MtileToload.unlock();
+                // UpdateBounds() drops the loads of the old zoom level and
+                // keeps the ones prefetched for this one
                 Matrix.Clear();
                 GoToCurrentPositionOnZoom();
                 UpdateBounds();
@@ -536,14 +550,7 @@ namespace internals {
             qDebug()<<"------------------";
 #endif //DEBUG_CORE
 
-            MtileLoadQueue.lock();
-            {
-                tileLoadQueue.clear();
-            }
-            MtileLoadQueue.unlock();
-            MtileToload.lock();
-            tilesToload=0;
-            MtileToload.unlock();
+            loadScheduler.Clear();
             Matrix.Clear();
 
             emit OnNeedInvalidation();
@@ -643,17 +650,9 @@ namespace internals {
     {
         if(started)
         {
-            ProcessLoadTaskCallback.waitForDone();
-            MtileLoadQueue.lock();
-            {
-                tileLoadQueue.clear();
-                //tilesToload=0;
-            }
-            MtileLoadQueue.unlock();
-            MtileToload.lock();
-            tilesToload=0;
-            MtileToload.unlock();
-            //  ProcessLoadTaskCallback.waitForDone();
+            // Loads in progress see they are no longer wanted and stop at
+            // the next layer, so there is no need to wait for them
+            loadScheduler.Clear();
         }
     }
     void Core::UpdateBounds()
@@ -668,28 +667,40 @@ namespace internals {
 
             emit OnTileLoadStart();
 
+            // Drops the queued tiles that are no longer in view
+            loadScheduler.SetView(centerTileXYLocation, Zoom(), tileDrawingList);
 
             foreach(Point p,tileDrawingList)
             {
+                Tile* m = Matrix.TileAt(p);
+                if(m!=0 && m->Overlays.count() > 0)
+                    continue;
+
                 LoadTask task = LoadTask(p, Zoom());
+                if(loadScheduler.Enqueue(task))
                 {
-                    MtileLoadQueue.lock();
-                    {
-                        if(!tileLoadQueue.contains(task))
-                        {
-                            MtileToload.lock();
-                            ++tilesToload;
-                            MtileToload.unlock();
-                            tileLoadQueue.enqueue(task);
 #ifdef DEBUG_CORE
-                            qDebug()<<"Core::UpdateBounds new Task"<<task.Pos.ToString();
+                    qDebug()<<"Core::UpdateBounds new Task"<<task.Pos.ToString();
 #endif //DEBUG_CORE
-                            ProcessLoadTaskCallback.start(this);
+                    ProcessLoadTaskCallback.start(this);
+                }
+            }
+
+            // Warm the caches for a zoom in around the center
+            if(Zoom() < MaxZoom())
+            {
+                for(qint64 i = -TileLoadScheduler::PrefetchRadius; i <= TileLoadScheduler::PrefetchRadius; i++)
+                {
+                    for(qint64 j = -TileLoadScheduler::PrefetchRadius; j <= TileLoadScheduler::PrefetchRadius; j++)
+                    {
+                        for(int k = 0; k < 4; k++)
+                        {
+                            Point p(2*(centerTileXYLocation.X()+i)+(k&1), 2*(centerTileXYLocation.Y()+j)+(k>>1));
+                            if(loadScheduler.Enqueue(LoadTask(p, Zoom()+1)))
+                                ProcessLoadTaskCallback.start(this);
                         }
                     }
-                    MtileLoadQueue.unlock();
                 }
-
             }
         }
         MtileDrawingList.unlock();
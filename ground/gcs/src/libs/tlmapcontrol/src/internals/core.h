@@ -41,6 +41,7 @@
 #include "tilematrix.h"
 #include <QQueue>
 #include "loadtask.h"
+#include "tileloadscheduler.h"
 #include "copyrightstrings.h"
 #include "rectlatlng.h"
 #include "projections/lks94projection.h"
@@ -242,7 +243,7 @@ namespace internals {
 
         Rectangle CurrentRegion;
 
-        QQueue<LoadTask> tileLoadQueue;
+        TileLoadScheduler loadScheduler;
 
         int zoom;
 
@@ -250,8 +251,6 @@ namespace internals {
 
         bool isDragging;
 
-        QMutex MtileLoadQueue;
-
         QMutex Moverlays;
 
         QMutex MtileDrawingList;
@@ -266,8 +265,6 @@ namespace internals {
         QSemaphore loaderLimit;
 
         QThreadPool ProcessLoadTaskCallback;
-        QMutex MtileToload;
-        int tilesToload;
 
         int maxzoom; //Max zoom level in  quadtile format
         QMutex MrunningThreads;
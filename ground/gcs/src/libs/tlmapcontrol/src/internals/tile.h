@@ -54,7 +54,7 @@ public:
         this->pos=cSource.pos;
     }
     bool HasValue(){return !(zoom==0);}
-    QList<QByteArray> Overlays;
+    QList<QImage> Overlays;    //Decoded layers, bottom first
 protected:
 
     QMutex mutex;
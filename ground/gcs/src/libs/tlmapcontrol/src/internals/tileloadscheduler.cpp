@@ -0,0 +1,191 @@
+/**
+******************************************************************************
+*
+* @file       tileloadscheduler.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+* @brief      Orders, deduplicates and cancels map tile loads
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   OPMapWidget
+* @{
+* 
+*****************************************************************************/
+/* 
+* This program is free software; you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License as published by 
+* the Free Software Foundation; either version 3 of the License, or 
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful, but 
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+* for more details.
+* 
+* You should have received a copy of the GNU General Public License along 
+* with this program; if not, write to the Free Software Foundation, Inc., 
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "tileloadscheduler.h"
+
+namespace internals {
+TileLoadScheduler::TileLoadScheduler():center(0,0),zoom(-1),generation(0)
+{
+}
+
+/**
+ * Sets the tiles in view. Waiting tiles outside the new view are dropped,
+ * and the rest are reordered around the new center.
+ */
+void TileLoadScheduler::SetView(const core::Point &center, int zoom, const QList<core::Point> &tiles)
+{
+    QMutexLocker locker(&mutex);
+    this->center=center;
+    this->zoom=zoom;
+
+    view.clear();
+    prefetch.clear();
+    foreach(core::Point p,tiles)
+    {
+        view.insert(p);
+
+        // The four tiles covering p at the next zoom level
+        if(qAbs(p.X()-center.X())<=PrefetchRadius && qAbs(p.Y()-center.Y())<=PrefetchRadius)
+        {
+            for(int i=0;i<4;i++)
+                prefetch.insert(core::Point(2*p.X()+(i&1),2*p.Y()+(i>>1)));
+        }
+    }
+
+    QList<Entry> kept;
+    foreach(Entry entry,pending)
+    {
+        if(!IsWantedLocked(entry.task))
+            continue;
+        entry.priority=Priority(entry.task);
+
+        // Insertion sort, the list is short and mostly in order already
+        int i=kept.count();
+        while(i>0 && kept.at(i-1).priority>entry.priority)
+            --i;
+        kept.insert(i,entry);
+    }
+    pending=kept;
+}
+
+/**
+ * Queues a task unless it is already waiting, being loaded, or not wanted
+ * by the current view. Returns true if the task was queued.
+ */
+bool TileLoadScheduler::Enqueue(const LoadTask &task)
+{
+    QMutexLocker locker(&mutex);
+    if(!IsWantedLocked(task) || inFlight.contains(task))
+        return false;
+    foreach(const Entry &entry,pending)
+    {
+        if(entry.task==task)
+            return false;
+    }
+
+    Entry entry;
+    entry.task=task;
+    entry.priority=Priority(task);
+    int i=pending.count();
+    while(i>0 && pending.at(i-1).priority>entry.priority)
+        --i;
+    pending.insert(i,entry);
+    return true;
+}
+
+/**
+ * Hands out the most urgent task and marks it as being loaded. Call
+ * Finish() once done with it.
+ * @param generation Set to the value to pass to IsWanted()
+ */
+bool TileLoadScheduler::Take(LoadTask &task, int &generation)
+{
+    QMutexLocker locker(&mutex);
+    if(pending.isEmpty())
+        return false;
+    task=pending.takeFirst().task;
+    inFlight.append(task);
+    generation=this->generation;
+    return true;
+}
+
+void TileLoadScheduler::Finish(const LoadTask &task)
+{
+    QMutexLocker locker(&mutex);
+    inFlight.removeOne(task);
+}
+
+/**
+ * True while the view still needs the task and no Clear() happened since
+ * it was taken. Loaders check this between layers so tiles scrolled out of
+ * view stop loading, and tiles of a replaced map never reach the matrix.
+ */
+bool TileLoadScheduler::IsWanted(const LoadTask &task, int generation)
+{
+    QMutexLocker locker(&mutex);
+    return generation==this->generation && IsWantedLocked(task);
+}
+
+/**
+ * True for tiles of the next zoom level, which only warm the caches
+ */
+bool TileLoadScheduler::IsPrefetch(const LoadTask &task)
+{
+    QMutexLocker locker(&mutex);
+    return task.Zoom!=zoom;
+}
+
+/**
+ * Drops every waiting task and marks the ones being loaded as unwanted
+ */
+void TileLoadScheduler::Clear()
+{
+    QMutexLocker locker(&mutex);
+    pending.clear();
+    inFlight.clear();
+    view.clear();
+    prefetch.clear();
+    ++generation;
+}
+
+int TileLoadScheduler::PendingInView()
+{
+    QMutexLocker locker(&mutex);
+    int count=0;
+    foreach(const Entry &entry,pending)
+    {
+        if(entry.task.Zoom==zoom)
+            ++count;
+    }
+    return count;
+}
+
+/**
+ * Lower loads first. Tiles in view are ordered by squared distance from the
+ * center, prefetched tiles come after all of them.
+ */
+qint64 TileLoadScheduler::Priority(const LoadTask &task) const
+{
+    if(task.Zoom==zoom)
+    {
+        qint64 dx=task.Pos.X()-center.X();
+        qint64 dy=task.Pos.Y()-center.Y();
+        return dx*dx+dy*dy;
+    }
+    qint64 dx=task.Pos.X()-(2*center.X()+1);
+    qint64 dy=task.Pos.Y()-(2*center.Y()+1);
+    return (Q_INT64_C(1)<<40)+dx*dx+dy*dy;
+}
+
+bool TileLoadScheduler::IsWantedLocked(const LoadTask &task) const
+{
+    if(task.Zoom==zoom)
+        return view.contains(task.Pos);
+    if(task.Zoom==zoom+1)
+        return prefetch.contains(task.Pos);
+    return false;
+}
+}
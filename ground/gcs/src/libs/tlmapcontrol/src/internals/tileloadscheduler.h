@@ -0,0 +1,80 @@
+/**
+******************************************************************************
+*
+* @file       tileloadscheduler.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+* @brief      Orders, deduplicates and cancels map tile loads
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   OPMapWidget
+* @{
+* 
+*****************************************************************************/
+/* 
+* This program is free software; you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License as published by 
+* the Free Software Foundation; either version 3 of the License, or 
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful, but 
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+* for more details.
+* 
+* You should have received a copy of the GNU General Public License along 
+* with this program; if not, write to the Free Software Foundation, Inc., 
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef TILELOADSCHEDULER_H
+#define TILELOADSCHEDULER_H
+
+#include "loadtask.h"
+#include "../core/point.h"
+#include <QList>
+#include <QSet>
+#include <QMutex>
+
+namespace internals {
+/**
+ * Holds the tiles waiting to be loaded. Tiles in view are handed out
+ * nearest the center first, then tiles of the next zoom level under the
+ * center, which are loaded ahead of a zoom in. Moving the view drops the
+ * waiting tiles that left it, and a tile is never queued twice or queued
+ * while it is being loaded. All methods are thread safe.
+ */
+class TileLoadScheduler
+{
+public:
+    TileLoadScheduler();
+
+    void SetView(const core::Point &center, int zoom, const QList<core::Point> &tiles);
+    bool Enqueue(const LoadTask &task);
+    bool Take(LoadTask &task, int &generation);
+    void Finish(const LoadTask &task);
+    bool IsWanted(const LoadTask &task, int generation);
+    bool IsPrefetch(const LoadTask &task);
+    void Clear();
+    int PendingInView();
+
+    //! Tiles around the center whose next zoom level tiles are prefetched
+    static const int PrefetchRadius=1;
+
+private:
+    struct Entry
+    {
+        LoadTask task;
+        qint64 priority;
+    };
+    qint64 Priority(const LoadTask &task) const;
+    bool IsWantedLocked(const LoadTask &task) const;
+
+    QMutex mutex;
+    QList<Entry> pending;   // Sorted, first is loaded first
+    QList<LoadTask> inFlight;
+    QSet<core::Point> view;
+    QSet<core::Point> prefetch;
+    core::Point center;
+    int zoom;
+    int generation;     // Bumped by Clear() to cancel the loads in progress
+};
+}
+#endif // TILELOADSCHEDULER_H
@@ -147,6 +147,21 @@ public:
     */
     void SetTileMemorySize(int const& value){core::TLMaps::Instance()->TilesInMemory.setMemoryCacheCapacity(value);}
 
+    /**
+    * @brief  Returns the currently used memory for decoded tiles
+    *
+    * @return
+    */
+    double DecodedTileMemoryUsed()const{return core::TLMaps::Instance()->TilesInMemory.DecodedCacheSize();}
+
+    /**
+    * @brief  Sets the size of the memory for decoded tiles, which are drawn without decoding them again
+    *
+    * @param  value size in Mb to use for decoded tiles
+    * @return
+    */
+    void SetDecodedTileMemorySize(int const& value){core::TLMaps::Instance()->TilesInMemory.setDecodedCacheCapacity(value);}
+
     /**
     * @brief Sets the location for the SQLite Database used for caching and the geocoding cache files
     *
@@ -26,8 +26,18 @@
 * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 */
 #include "mapripper.h"
+#include <QDateTime>
 namespace mapcontrol
 {
+class MapRipper::Fetcher:public QRunnable
+{
+public:
+    Fetcher(MapRipper *ripper):ripper(ripper){}
+    void run(){ripper->fetchTiles();}
+private:
+    MapRipper *ripper;
+};
+
 
 MapRipper::MapRipper(internals::Core * core, const internals::RectLatLng & rect):sleep(100),cancel(false),progressForm(0),core(core),yesToAll(false)
     {
@@ -40,6 +50,7 @@ MapRipper::MapRipper(internals::Core * core, const internals::RectLatLng & rect)
             zoom=core->Zoom();
             maxzoom=core->MaxZoom();
             points=core->Projection()->GetAreaTileList(area,zoom,0);
+            pack.Begin(core::Cache::Instance()->TilePackLocation()+QString("region-%1.tlpk").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
             this->start();
             cancel=false;
             progressForm->show();
@@ -88,6 +99,7 @@ void MapRipper::finish()
         }
         else
         {
+            savePack();
             progressForm->close();
             delete progressForm;
             this->deleteLater();
@@ -96,6 +108,7 @@ void MapRipper::finish()
     else
     {
         yesToAll=false;
+        savePack();
         progressForm->close();
         delete progressForm;
         this->deleteLater();
@@ -103,47 +116,79 @@ void MapRipper::finish()
 }
 
 
+    /**
+     * @brief MapRipper::savePack Writes the tiles ripped so far, over every
+     * zoom level, to a tile pack and starts serving the map from it
+     */
+    void MapRipper::savePack()
+    {
+        if(pack.TileCount()==0)
+        {
+            pack.Abort();
+            return;
+        }
+        if(pack.Finish())
+            core::Cache::Instance()->TilePacks.Add(pack.FileName());
+        else
+            qDebug()<<"MapRipper: could not write tile pack"<<pack.FileName();
+    }
+
     void MapRipper::run()
     {
-        int countOk = 0;
-        bool goodtile=false;
-        //  Stuff.Shuffle<Point>(ref list);
-        QVector<core::MapType::Types> types = TLMaps::Instance()->GetAllLayersOfType(type);
+        types = TLMaps::Instance()->GetAllLayersOfType(type);
+        nextTile=0;
+        tilesDone=0;
+        emit numberOfTilesChanged(points.count(),0);
+
+        QThreadPool fetchers;
+        fetchers.setMaxThreadCount(FetchThreads);
+        for(int i = 0; i < FetchThreads; i++)
+            fetchers.start(new Fetcher(this));
+        fetchers.waitForDone();
+    }
+
+    /**
+     * @brief MapRipper::fetchTiles Run by each fetcher. Takes the next tile
+     * of the area until none are left, retrying a tile until every layer
+     * of it has been fetched.
+     */
+    void MapRipper::fetchTiles()
+    {
         int all=points.count();
-        for(int i = 0; i < all; i++)
+        forever
         {
-            emit numberOfTilesChanged(all,i+1);
             if(cancel)
-                break;
+                return;
+            int i=nextTile.fetchAndAddOrdered(1);
+            if(i>=all)
+                return;
 
-            core::Point p = points[i];
+            core::Point p = points.at(i);
+            bool goodtile=false;
+            while(!goodtile && !cancel)
             {
                 //qDebug()<<"offline fetching:"<<p.ToString();
-                foreach(core::MapType::Types type,types)
+                goodtile=true;
+                foreach(core::MapType::Types layer,types)
                 {
-                    emit providerChanged(core::MapType::StrByType(type),zoom);
-                    QByteArray img = TLMaps::Instance()->GetImageFromServer(type, p, zoom);
-                    if(img.length()!=0)
+                    emit providerChanged(core::MapType::StrByType(layer),zoom);
+                    QByteArray img = TLMaps::Instance()->GetImageFromServer(layer, p, zoom);
+                    if(img.isEmpty())
                     {
-                        goodtile=true;
-                        img=NULL;
-                    }
-                    else
                         goodtile=false;
+                        break;
+                    }
+                    pack.AddTile(layer,p,zoom,img);
                 }
-                if(goodtile)
-                {
-                    countOk++;
-                }
-                else
-                {
-                    i--;
+                if(!goodtile)
                     QThread::msleep(1000);
-                    continue;
-                }
             }
-            emit percentageChanged((int) ((i+1)*100/all));//, i+1);
-            // worker.ReportProgress((int) ((i+1)*100/all), i+1);
+            if(!goodtile)
+                return;
+
+            int done=tilesDone.fetchAndAddOrdered(1)+1;
+            emit numberOfTilesChanged(all,done);
+            emit percentageChanged((int) (done*100/all));
 
             QThread::msleep(sleep);
         }
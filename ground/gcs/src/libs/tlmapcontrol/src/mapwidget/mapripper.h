@@ -29,8 +29,12 @@
 #define MAPRIPPER_H
 
 #include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
 #include "../internals/core.h"
 #include "mapripform.h"
+#include "../core/tilepack.h"
 #include <QObject>
 #include <QMessageBox>
 namespace mapcontrol
@@ -41,7 +45,15 @@ namespace mapcontrol
     public:
         MapRipper(internals::Core *,internals::RectLatLng const&);
         void run();
+
+        //! Tiles fetched at once. Each fetcher still pauses between tiles.
+        static const int FetchThreads=4;
     private:
+        class Fetcher;
+        friend class Fetcher;
+        void fetchTiles();
+        void savePack();
+
         QList<core::Point> points;
         int zoom;
         core::MapType::Types type;
@@ -53,6 +65,10 @@ namespace mapcontrol
         internals::Core * core;
         bool yesToAll;
         QMutex mutex;
+        QVector<core::MapType::Types> types;
+        QAtomicInt nextTile;
+        QAtomicInt tilesDone;
+        core::TilePackWriter pack;
 
     signals:
         void percentageChanged(int const& perc);
@@ -0,0 +1,12 @@
+# Benchmarks the SQLite tile cache. Not part of the default build:
+#   qmake tilecachebench.pro && make && ./tilecachebench
+CONFIG += qtestlib
+TEMPLATE = app
+CONFIG -= app_bundle
+
+QT += sql network xml
+
+INCLUDEPATH += ../../src/core
+LIBS += -L../../src/build -lcore
+
+SOURCES += tst_tilecachebench.cpp
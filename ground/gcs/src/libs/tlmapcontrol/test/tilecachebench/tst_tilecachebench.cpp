@@ -0,0 +1,174 @@
+/**
+******************************************************************************
+*
+* @file       tst_tilecachebench.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+* @brief      Benchmarks writing and reading an offline tile set in the SQLite tile cache
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   OPMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include "pureimagecache.h"
+#include "cacheitemqueue.h"
+
+#include <QtTest/QtTest>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+
+using namespace core;
+
+// Offline area: a square of tiles at one zoom level, like a ripped region
+static const int AreaWidth=48;
+static const int Zoom=15;
+static const int TileBytes=16*1024;
+static const int Readers=4;
+
+/**
+ * Stands in for a tile server: returns the same incompressible bytes for a
+ * tile every time, so reads can be checked against what was written.
+ */
+static QByteArray serveTile(int x,int y,int zoom)
+{
+    QByteArray tile(TileBytes,0);
+    quint32 state=(x*73856093u)^(y*19349663u)^(zoom*83492791u);
+    for(int i=0;i<tile.size();i++)
+    {
+        state=state*1664525u+1013904223u;
+        tile[i]=(char)(state>>24);
+    }
+    return tile;
+}
+
+/**
+ * Reads every tile of the area, starting at a different row per reader so
+ * the readers do not walk the index in lock step.
+ */
+class TileReader:public QRunnable
+{
+public:
+    TileReader(PureImageCache *cache,int offset,QAtomicInt *mismatches)
+        :cache(cache),offset(offset),mismatches(mismatches){}
+    void run()
+    {
+        for(int i=0;i<AreaWidth*AreaWidth;i++)
+        {
+            int n=(i+offset*AreaWidth)%(AreaWidth*AreaWidth);
+            int x=n%AreaWidth;
+            int y=n/AreaWidth;
+            if(cache->GetImageFromCache(MapType::GoogleSatellite,Point(x,y),Zoom)!=serveTile(x,y,Zoom))
+                mismatches->ref();
+        }
+    }
+private:
+    PureImageCache *cache;
+    int offset;
+    QAtomicInt *mismatches;
+};
+
+class tst_TileCacheBench:public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+    void writeOneTilePerTransaction();
+    void writeBatched();
+    void readConcurrently();
+private:
+    void writeArea(PureImageCache &cache,int batchSize);
+    QString cacheDir;
+};
+
+void tst_TileCacheBench::init()
+{
+    cacheDir=QDir::tempPath()+"/tilecachebench/";
+    cleanup();
+}
+
+void tst_TileCacheBench::cleanup()
+{
+    QDir dir(cacheDir);
+    foreach(QString file,dir.entryList(QDir::Files))
+        dir.remove(file);
+    dir.rmdir(cacheDir);
+}
+
+void tst_TileCacheBench::writeArea(PureImageCache &cache,int batchSize)
+{
+    QList<CacheItemQueue*> batch;
+    for(int y=0;y<AreaWidth;y++)
+    {
+        for(int x=0;x<AreaWidth;x++)
+        {
+            batch.append(new CacheItemQueue(MapType::GoogleSatellite,Point(x,y),serveTile(x,y,Zoom),Zoom));
+            if(batch.count()==batchSize)
+            {
+                QVERIFY(cache.PutImagesToCache(batch));
+                qDeleteAll(batch);
+                batch.clear();
+            }
+        }
+    }
+    if(batch.count()>0)
+    {
+        QVERIFY(cache.PutImagesToCache(batch));
+        qDeleteAll(batch);
+    }
+}
+
+void tst_TileCacheBench::writeOneTilePerTransaction()
+{
+    PureImageCache cache;
+    cache.setGtileCache(cacheDir);
+    QBENCHMARK_ONCE {
+        writeArea(cache,1);
+    }
+}
+
+void tst_TileCacheBench::writeBatched()
+{
+    PureImageCache cache;
+    cache.setGtileCache(cacheDir);
+    QBENCHMARK_ONCE {
+        writeArea(cache,256);
+    }
+}
+
+void tst_TileCacheBench::readConcurrently()
+{
+    PureImageCache cache;
+    cache.setGtileCache(cacheDir);
+    writeArea(cache,256);
+
+    QAtomicInt mismatches(0);
+    QThreadPool pool;
+    pool.setMaxThreadCount(Readers);
+    QBENCHMARK_ONCE {
+        for(int i=0;i<Readers;i++)
+            pool.start(new TileReader(&cache,i*AreaWidth/Readers,&mismatches));
+        pool.waitForDone();
+    }
+    QCOMPARE((int)mismatches,0);
+}
+
+QTEST_MAIN(tst_TileCacheBench)
+
+#include "tst_tilecachebench.moc"
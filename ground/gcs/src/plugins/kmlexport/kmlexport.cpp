@@ -238,6 +238,7 @@ bool KmlExport::open()
     }
 
     QString tmpLine=logFile.readLine(); //Look for the header/body separation string.
+
     int cnt=0;
     while (tmpLine!="##\n" && cnt < 10 && !logFile.atEnd()){
         tmpLine=logFile.readLine().trimmed();
@@ -255,6 +256,12 @@ bool KmlExport::open()
         logFile.seek(0);
     }
 
+    //Skip the UAVO definitions that newer logs embed right after the separation string
+    if (logFile.pos() > 0 && logFile.peek(strlen("UAVO definitions: ")) == "UAVO definitions: ") {
+        tmpLine=logFile.readLine();
+        logFile.seek(logFile.pos() + tmpLine.mid(strlen("UAVO definitions: ")).trimmed().toInt());
+    }
+
     return true;
 }
 
@@ -371,9 +378,7 @@ void KmlExport::parseLogFile()
 
         // Parse the packet. This operation passes the data to the kmlTalk object, which internally parses the data
         // and then emits objectUpdated(UAVObject *) signals. These signals are connected to in the KmlExport constructor.
-        for (int i=0; i < dataBuffer.size(); i++) {
-            kmlTalk->processInputByte(dataBuffer[i]);
-        }
+        kmlTalk->processInputBuffer(dataBuffer);
 
         timeStampIdx++;
     }
@@ -3,19 +3,48 @@
 #include <QtGlobal>
 #include <QTextStream>
  #include <QMessageBox>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
+#include <QtAlgorithms>
+#include <QXmlStreamWriter>
+#include <extensionsystem/pluginmanager.h>
 
 // autogenerated version info string. MUST GO BEFORE coreconstants.h INCLUDE
 #include "../../../../../build/ground/gcs/gcsversioninfo.h"
 
 #include <coreplugin/coreconstants.h>
 
+//! Size of the timestamp and packet size fields preceding each packet
+static const qint64 RECORD_HEADER_SIZE = sizeof(quint32) + sizeof(qint64);
+
+//! Identifies a replay index sidecar file and its format version
+static const quint32 INDEX_MAGIC = 0x494c4c54; // "TLLI"
+static const quint32 INDEX_VERSION = 1;
+
+//! Header line announcing the size of the embedded UAVO definitions
+static const char UAVO_DEFINITIONS_TAG[] = "UAVO definitions: ";
+
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
-    timestampBufferIdx(0)
+    mappedLog(NULL),
+    mappedSize(0),
+    timestampBufferIdx(0),
+    pendingIdx(0),
+    pendingOffset(0),
+    pendingBytes(0),
+    unwrittenBytes(0),
+    writerStopping(false),
+    writer(this)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
 
+LogFile::~LogFile()
+{
+    stopWriter();
+}
+
 /**
  * Opens the logfile QIODevice and the underlying logfile. In case
  * we want to save the logfile, we open in WriteOnly. In case we
@@ -57,6 +86,24 @@ bool LogFile::open(OpenMode mode) {
         QTextStream out(&file);
 
         out << "Tau Labs git hash:\n" <<  gitHash << "\n" << uavoHash << "\n##\n";
+
+        // Embed the object definitions so the log can still be decoded once they change.
+        // They follow the separation string, so readers that do not know them
+        // still find it on the fourth line and resync past them.
+        QByteArray definitions = uavoDefinitionsXml();
+        out << UAVO_DEFINITIONS_TAG << definitions.size() << "\n";
+        out.flush();
+        file.write(definitions);
+
+        // Records are packed into blocks which are written out by a background thread
+        fullBlocks.clear();
+        freeBlocks.clear();
+        for (int i = 0; i < WRITE_BLOCK_COUNT; i++)
+            freeBlocks.append(takeFreeBlock(WRITE_BLOCK_SIZE));
+        currentBlock = WriteBlock();
+        unwrittenBytes = 0;
+        writerStopping = false;
+        writer.start(QThread::LowPriority);
     }
     else if(mode == QIODevice::ReadOnly)
     {
@@ -80,6 +127,7 @@ bool LogFile::open(OpenMode mode) {
         }
 
         QString tmpLine=file.readLine(); //Look for the header/body separation string.
+
         int cnt=0;
         while (tmpLine!="##\n" && cnt < 10 && !file.atEnd()){
             tmpLine=file.readLine().trimmed();
@@ -97,6 +145,14 @@ bool LogFile::open(OpenMode mode) {
             file.seek(0);
         }
 
+        //Newer logs embed the UAVO definitions right after the separation string
+        uavoDefinitions.clear();
+        if (file.pos() > 0 && file.peek(strlen(UAVO_DEFINITIONS_TAG)) == UAVO_DEFINITIONS_TAG) {
+            tmpLine=file.readLine();
+            int definitionsSize = tmpLine.mid(strlen(UAVO_DEFINITIONS_TAG)).trimmed().toInt();
+            uavoDefinitions = file.read(definitionsSize);
+        }
+
     }
     else
     {
@@ -117,142 +173,432 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+
+    stopWriter();
+
+    mutex.lock();
+    if (mappedLog) {
+        file.unmap(mappedLog);
+        mappedLog = NULL;
+        mappedSize = 0;
+    }
+    pendingBytes = 0;
+    mutex.unlock();
+
     file.close();
     QIODevice::close();
 }
 
+/**
+ * Appends a record to the current write block. Full blocks are handed to
+ * the writer thread, so this never waits on the disk.
+ */
 qint64 LogFile::writeData(const char * data, qint64 dataSize) {
     if (!file.isWritable())
         return dataSize;
 
     quint32 timeStamp = myTime.elapsed();
+    qint64 recordSize = RECORD_HEADER_SIZE + dataSize;
 
-    file.write((char *) &timeStamp,sizeof(timeStamp));
-    file.write((char *) &dataSize, sizeof(dataSize));
+    QMutexLocker locker(&writeMutex);
+    if (currentBlock.used + recordSize > currentBlock.data.size()) {
+        queueWriteBlock();
+        currentBlock = takeFreeBlock(recordSize);
+    }
+
+    char *record = currentBlock.data.data() + currentBlock.used;
+    memcpy(record, &timeStamp, sizeof(timeStamp));
+    memcpy(record + sizeof(timeStamp), &dataSize, sizeof(dataSize));
+    memcpy(record + RECORD_HEADER_SIZE, data, dataSize);
+    currentBlock.used += recordSize;
+    unwrittenBytes += recordSize;
+    locker.unlock();
 
-    qint64 written = file.write(data, dataSize);
-    if(written != -1)
-        emit bytesWritten(written);
+    emit bytesWritten(dataSize);
 
     return dataSize;
 }
 
+/**
+ * Get an empty block able to hold at least minSize bytes. Blocks are reused
+ * once written; a new one is only allocated when all of them are still queued
+ * for the disk, or for a record larger than a block.
+ */
+LogFile::WriteBlock LogFile::takeFreeBlock(qint64 minSize)
+{
+    if (!freeBlocks.isEmpty() && minSize <= WRITE_BLOCK_SIZE)
+        return freeBlocks.takeFirst();
+
+    WriteBlock block;
+    block.data.resize(qMax((qint64)WRITE_BLOCK_SIZE, minSize));
+    return block;
+}
+
+/**
+ * Hand the current block to the writer thread. Must be called with writeMutex held.
+ */
+void LogFile::queueWriteBlock()
+{
+    if (currentBlock.used > 0) {
+        fullBlocks.append(currentBlock);
+        blockQueued.wakeOne();
+    }
+    currentBlock = WriteBlock();
+}
+
+/**
+ * Writer thread loop: write queued blocks until stopped and drained
+ */
+void LogFile::writeBlocks()
+{
+    QMutexLocker locker(&writeMutex);
+
+    forever {
+        while (fullBlocks.isEmpty() && !writerStopping)
+            blockQueued.wait(&writeMutex);
+        if (fullBlocks.isEmpty())
+            break;
+
+        WriteBlock block = fullBlocks.takeFirst();
+        locker.unlock();
+
+        if (file.write(block.data.constData(), block.used) != block.used)
+            qDebug() << "Error writing log file: " << file.errorString();
+
+        locker.relock();
+        unwrittenBytes -= block.used;
+        if (block.data.size() == WRITE_BLOCK_SIZE) {
+            block.used = 0;
+            freeBlocks.append(block);
+        }
+    }
+}
+
+/**
+ * Bytes of records that are still waiting for the writer thread
+ */
+qint64 LogFile::bytesToWrite()
+{
+    QMutexLocker locker(&writeMutex);
+    return unwrittenBytes;
+}
+
+void LogFileWriter::run()
+{
+    logFile->writeBlocks();
+}
+
+/**
+ * Flush the partially filled block and wait for the writer thread to finish
+ */
+void LogFile::stopWriter()
+{
+    if (!writer.isRunning())
+        return;
+
+    writeMutex.lock();
+    queueWriteBlock();
+    writerStopping = true;
+    blockQueued.wakeOne();
+    writeMutex.unlock();
+
+    writer.wait();
+
+    fullBlocks.clear();
+    freeBlocks.clear();
+}
+
+/**
+ * Describe every data object in the uavobjectdefinition XML format. Fields are
+ * listed in the order they are packed in, so the records can be decoded from
+ * this alone.
+ */
+QByteArray LogFile::uavoDefinitionsXml()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    QByteArray xml;
+    QXmlStreamWriter stream(&xml);
+    stream.setAutoFormatting(true);
+    stream.writeStartElement("xml");
+
+    foreach (QVector<UAVDataObject*> instances, objManager->getDataObjects()) {
+        UAVDataObject *obj = instances.first();
+        stream.writeStartElement("object");
+        stream.writeAttribute("name", obj->getName());
+        stream.writeAttribute("id", QString("0x%1").arg(obj->getObjID(), 8, 16, QChar('0')));
+        stream.writeAttribute("singleinstance", obj->isSingleInstance() ? "true" : "false");
+        stream.writeAttribute("settings", obj->isSettings() ? "true" : "false");
+        stream.writeAttribute("numbytes", QString::number(obj->getNumBytes()));
+        stream.writeTextElement("description", obj->getDescription());
+
+        foreach (UAVObjectField *field, obj->getFields()) {
+            stream.writeEmptyElement("field");
+            stream.writeAttribute("name", field->getName());
+            stream.writeAttribute("units", field->getUnits());
+            stream.writeAttribute("type", field->getTypeAsString());
+            stream.writeAttribute("elements", QString::number(field->getNumElements()));
+            if (field->getNumElements() > 1)
+                stream.writeAttribute("elementnames", field->getElementNames().join(","));
+            if (field->getType() == UAVObjectField::ENUM)
+                stream.writeAttribute("options", field->getOptions().join(","));
+        }
+
+        stream.writeEndElement();
+    }
+
+    stream.writeEndElement();
+    stream.writeEndDocument();
+
+    return xml;
+}
+
+/**
+ * Copies released packets straight out of the mapped log file
+ */
 qint64 LogFile::readData(char * data, qint64 maxSize) {
     QMutexLocker locker(&mutex);
-    qint64 toRead = qMin(maxSize,(qint64)dataBuffer.size());
-    memcpy(data,dataBuffer.data(),toRead);
-    dataBuffer.remove(0,toRead);
-    return toRead;
+    qint64 copied = 0;
+
+    while (copied < maxSize && pendingBytes > 0) {
+        qint64 toCopy = qMin(maxSize - copied, packetSize(pendingIdx) - pendingOffset);
+        memcpy(data + copied, packetData(pendingIdx) + pendingOffset, toCopy);
+        copied += toCopy;
+        pendingBytes -= toCopy;
+        pendingOffset += toCopy;
+
+        // Move on to the next packet once this one is used up
+        if (pendingOffset == packetSize(pendingIdx)) {
+            pendingIdx++;
+            pendingOffset = 0;
+        }
+    }
+
+    return copied;
 }
 
 qint64 LogFile::bytesAvailable() const
 {
-    return dataBuffer.size();
+    return pendingBytes;
 }
 
-void LogFile::timerFired()
+/**
+ * Size of the UAVTalk packet in the record with the given index
+ */
+qint64 LogFile::packetSize(quint32 idx) const
 {
     qint64 dataSize;
+    memcpy(&dataSize, mappedLog + timestampPos[idx] + sizeof(quint32), sizeof(dataSize));
+    return dataSize;
+}
 
-    if(file.bytesAvailable() > 4)
-    {
+/**
+ * Location in the mapped file of the UAVTalk packet in the record with the given index
+ */
+const uchar *LogFile::packetData(quint32 idx) const
+{
+    return mappedLog + timestampPos[idx] + RECORD_HEADER_SIZE;
+}
 
-        int time;
-        time = myTime.elapsed();
+void LogFile::timerFired()
+{
+    quint32 numRecords = timestampBuffer.size();
+    int time = myTime.elapsed();
 
-        //Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
-        {
-            lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            file.seek(lastTimeStampPos+sizeof(lastTimeStamp));
-
-            file.read((char *) &dataSize, sizeof(dataSize));
-
-            if (dataSize<1 || dataSize>(1024*1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if(file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
-
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
-
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
-
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+    //Release every packet whose time has come
+    while (timestampBufferIdx < numRecords &&
+           (lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (timestampBuffer[timestampBufferIdx]-firstTimestamp)))
+    {
+        lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
 
+        mutex.lock();
+        if (pendingBytes == 0) {
+            pendingIdx = timestampBufferIdx;
+            pendingOffset = 0;
         }
-    } else {
-        stopReplay();
+        pendingBytes += packetSize(timestampBufferIdx);
+        mutex.unlock();
+        timestampBufferIdx++;
+
+        emit readyRead();
+
+        lastPlayTimeOffset = time;
+        time = myTime.elapsed();
     }
 
+    if (timestampBufferIdx >= numRecords)
+        stopReplay();
 }
 
-bool LogFile::startReplay() {
-    dataBuffer.clear();
-    myTime.restart();
-    lastPlayTimeOffset = 0;
-    lastPlayTime = 0;
-    playbackSpeed = 1;
+/**
+ * Walk the mapped log and record the timestamp and offset of every record.
+ * @param logStart offset of the first record, just past the file header
+ * @return true if the timestamps are sequential
+ */
+bool LogFile::buildIndex(qint64 logStart)
+{
+    bool sequential = true;
+    qint64 pos = logStart;
 
-    //Read all log timestamps into array
-    timestampBuffer.clear(); //Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
+    // A rough guess of the record count avoids regrowing the index for large logs
+    timestampBuffer.reserve((mappedSize - logStart) / 32);
+    timestampPos.reserve((mappedSize - logStart) / 32);
 
-    while (!file.atEnd()){
+    while (pos + RECORD_HEADER_SIZE <= mappedSize) {
+        quint32 timeStamp;
         qint64 dataSize;
-
-        //Get time stamp position
-        timestampPos.append(file.pos());
-
-        //Read timestamp and logfile packet size
-        file.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *) &dataSize, sizeof(dataSize));
+        memcpy(&timeStamp, mappedLog + pos, sizeof(timeStamp));
+        memcpy(&dataSize, mappedLog + pos + sizeof(timeStamp), sizeof(dataSize));
 
         //Check if dataSize sync bytes are correct.
         //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
         if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
-            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(file.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            file.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
+            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(pos + RECORD_HEADER_SIZE,0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
+            pos++;
             continue;
         }
 
+        //Drop a record truncated by the end of the file
+        if (pos + RECORD_HEADER_SIZE + dataSize > mappedSize)
+            break;
+
         //Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
+        if (!timestampBuffer.isEmpty() && timeStamp < timestampBuffer.last()){
+            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << timeStamp;
+            sequential = false;
+        }
+
+        if (dataSize > 0) {
+            timestampBuffer.append(timeStamp);
+            timestampPos.append(pos);
+        }
+
+        pos += RECORD_HEADER_SIZE + dataSize;
+    }
+
+    timestampBuffer.squeeze();
+    timestampPos.squeeze();
+
+    return sequential;
+}
+
+/**
+ * Load the index from the sidecar file if it was made for this log file
+ * @return true if the index was loaded
+ */
+bool LogFile::loadIndex(qint64 logStart)
+{
+    QFile indexFile(indexFileName());
+    if (!indexFile.open(QIODevice::ReadOnly))
+        return false;
+
+    QFileInfo logInfo(file);
+    QDataStream in(&indexFile);
+    in.setVersion(QDataStream::Qt_4_6);
+    quint32 magic, version;
+    qint64 logSize, logModified, indexLogStart;
+    in >> magic >> version >> logSize >> logModified >> indexLogStart;
+
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION ||
+            logSize != mappedSize || logModified != logInfo.lastModified().toMSecsSinceEpoch() ||
+            indexLogStart != logStart)
+        return false;
+
+    in >> timestampBuffer >> timestampPos;
+    if (in.status() != QDataStream::Ok || timestampBuffer.size() != timestampPos.size() ||
+            !indexMatchesLog(logStart)) {
+        timestampBuffer.clear();
+        timestampPos.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Check that a loaded index only points at whole records inside the mapped log,
+ * in file order and with the timestamps they were indexed with, so that a
+ * corrupt sidecar file can never make replay read outside the mapping.
+ * @param logStart offset of the first record, just past the file header
+ * @return true if every entry matches a record of the log
+ */
+bool LogFile::indexMatchesLog(qint64 logStart) const
+{
+    qint64 nextPos = logStart;
+
+    for (int i = 0; i < timestampPos.size(); i++) {
+        qint64 pos = timestampPos[i];
+        if (pos < nextPos || pos > mappedSize - RECORD_HEADER_SIZE)
+            return false;
+
+        quint32 timeStamp;
+        qint64 dataSize;
+        memcpy(&timeStamp, mappedLog + pos, sizeof(timeStamp));
+        memcpy(&dataSize, mappedLog + pos + sizeof(timeStamp), sizeof(dataSize));
+
+        // Same limits as buildIndex(), so the sum below cannot overflow
+        if (timeStamp != timestampBuffer[i] || dataSize <= 0 || (dataSize & 0xFFFFFFFFFFFF0000) != 0 ||
+                dataSize > mappedSize - RECORD_HEADER_SIZE - pos)
+            return false;
+
+        nextPos = pos + RECORD_HEADER_SIZE + dataSize;
+    }
+
+    return true;
+}
+
+/**
+ * Store the index next to the log so that the next replay can skip the scan.
+ * Failing to write it (e.g. read-only media) is not an error.
+ */
+void LogFile::saveIndex(qint64 logStart)
+{
+    QFile indexFile(indexFileName());
+    if (!indexFile.open(QIODevice::WriteOnly))
+        return;
+
+    QFileInfo logInfo(file);
+    QDataStream out(&indexFile);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << INDEX_MAGIC << INDEX_VERSION << mappedSize << logInfo.lastModified().toMSecsSinceEpoch() << logStart;
+    out << timestampBuffer << timestampPos;
+}
+
+bool LogFile::startReplay() {
+    myTime.restart();
+    lastPlayTimeOffset = 0;
+    lastPlayTime = 0;
+    playbackSpeed = 1;
+    pendingBytes = 0;
+
+    //Map the whole log into memory, packets are fed to readData() straight from the mapping
+    qint64 logFileStartIdx = file.pos();
+    mappedSize = file.size();
+    mappedLog = file.map(0, mappedSize);
+    if (mappedLog == NULL) {
+        QMessageBox msgBox;
+        msgBox.setText("Unable to read logfile.");
+        msgBox.setInformativeText(file.errorString());
+        msgBox.exec();
+
+        stopReplay();
+        return false;
+    }
+
+    //Index all log timestamps, reusing a previous index when one matches the file
+    timestampBuffer.clear();
+    timestampPos.clear();
+    timestampBufferIdx = 0;
+
+    if (!loadIndex(logFileStartIdx)) {
+        if (!buildIndex(logFileStartIdx)) {
             QMessageBox msgBox;
             msgBox.setText("Corrupted file.");
             msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
             msgBox.exec();
-
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
         }
-
-        timestampBuffer.append(lastTimeStamp);
-
-        file.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
+        saveIndex(logFileStartIdx);
     }
 
     //Check if any timestamps were successfully read
@@ -266,12 +612,7 @@ bool LogFile::startReplay() {
         return false;
     }
 
-    //Reset to log beginning.
-    file.seek(logFileStartIdx+sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
     firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
 
     timer.setInterval(10);
     timer.start();
@@ -302,17 +643,22 @@ void LogFile::resumeReplay()
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx=0;
-    while(timestampBuffer[tmpIdx++] <= val*1000 && tmpIdx <= timestampBufferIdx){
-    }
+    if (timestampBuffer.isEmpty())
+        return;
+
+    //Binary search for the first record after the requested time
+    quint32 tmpIdx = qUpperBound(timestampBuffer.begin(), timestampBuffer.end(), (quint32)(val*1000)) - timestampBuffer.begin();
+    tmpIdx = qMin(tmpIdx, (quint32)timestampBuffer.size() - 1);
+
+    //Drop packets that were released before the jump
+    mutex.lock();
+    pendingBytes = 0;
+    mutex.unlock();
 
-    lastTimeStampPos=timestampPos[tmpIdx];
-    lastTimeStamp=timestampBuffer[tmpIdx];
     timestampBufferIdx=tmpIdx;
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime=lastTimeStamp;
+    lastPlayTime=timestampBuffer[tmpIdx]-firstTimestamp;
 
-    qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val*1000;
+    qDebug() << "Replaying at: " << timestampBuffer[tmpIdx] << ", but requestion at" << val*1000;
 }
-
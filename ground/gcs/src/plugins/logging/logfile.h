@@ -7,16 +7,38 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QBuffer>
+#include <QVector>
+#include <QThread>
+#include <QWaitCondition>
 #include "uavobjectmanager.h"
 #include <math.h>
 
+class LogFile;
+
+/**
+ * Background thread that writes the filled record blocks of a LogFile to disk
+ */
+class LogFileWriter : public QThread
+{
+public:
+    explicit LogFileWriter(LogFile *logFile) : logFile(logFile) {}
+
+protected:
+    void run();
+
+private:
+    LogFile *logFile;
+};
+
 class LogFile : public QIODevice
 {
     Q_OBJECT
+    friend class LogFileWriter;
 public:
     explicit LogFile(QObject *parent = 0);
+    ~LogFile();
     qint64 bytesAvailable() const;
-    qint64 bytesToWrite() { return file.bytesToWrite(); }
+    qint64 bytesToWrite();
     bool open(OpenMode mode);
     void setFileName(QString name) { file.setFileName(name); }
     void close();
@@ -26,6 +48,9 @@ public:
     bool startReplay();
     bool stopReplay();
 
+    //! UAVO definitions embedded in the header of the log being replayed
+    QByteArray getUAVODefinitions() const { return uavoDefinitions; }
+
 public slots:
     void setReplaySpeed(double val) { playbackSpeed = val; qDebug() << "New playback speed: " << playbackSpeed; }
     void setReplayTime(double val);
@@ -41,11 +66,9 @@ signals:
     void replayFinished();
 
 protected:
-    QByteArray dataBuffer;
     QTimer timer;
     QTime myTime;
     QFile file;
-    quint32 lastTimeStamp;
     quint32 lastPlayTime;
     QMutex mutex;
 
@@ -54,11 +77,58 @@ protected:
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
+    //! Records are packed into blocks of this size before being written
+    static const int WRITE_BLOCK_SIZE = 64 * 1024;
+    //! Number of blocks allocated up front when a log is opened for writing
+    static const int WRITE_BLOCK_COUNT = 4;
+
+    struct WriteBlock {
+        WriteBlock() : used(0) {}
+        QByteArray data;
+        int used;
+    };
+
+    QByteArray uavoDefinitionsXml();
+    WriteBlock takeFreeBlock(qint64 minSize);
+    void queueWriteBlock();
+    void writeBlocks();
+    void stopWriter();
+
+    //! Blocks waiting to be written, and written blocks ready for reuse
+    QList<WriteBlock> fullBlocks;
+    QList<WriteBlock> freeBlocks;
+    WriteBlock currentBlock;
+    QMutex writeMutex;
+    QWaitCondition blockQueued;
+    //! Bytes of records not yet written to disk by the writer thread
+    qint64 unwrittenBytes;
+    bool writerStopping;
+    LogFileWriter writer;
+
+    QByteArray uavoDefinitions;
+
+    bool buildIndex(qint64 logStart);
+    bool loadIndex(qint64 logStart);
+    bool indexMatchesLog(qint64 logStart) const;
+    void saveIndex(qint64 logStart);
+    QString indexFileName() const { return file.fileName() + ".idx"; }
+    qint64 packetSize(quint32 idx) const;
+    const uchar *packetData(quint32 idx) const;
+
+    //! The log file mapped into memory during replay
+    uchar *mappedLog;
+    qint64 mappedSize;
+
+    //! Timestamp and file offset of every record in the log
+    QVector<quint32> timestampBuffer;
+    QVector<qint64> timestampPos;
     quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
     quint32 firstTimestamp;
+
+    //! Records released by the replay timer but not yet consumed by readData()
+    quint32 pendingIdx;
+    qint64 pendingOffset;
+    qint64 pendingBytes;
 };
 
 #endif // LOGFILE_H
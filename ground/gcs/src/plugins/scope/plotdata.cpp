@@ -41,9 +41,13 @@
  * @param p_uavFieldName The plotted UAVO field name
  */
 Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
-    yDataHistory(0),
     dataUpdated(false)
 {
+    objectId = 0;
+    fieldIndex = -1;
+    boundField = NULL;
+    elementIndex = 0;
+
     uavObjectName = p_uavObject;
 
     if(p_uavFieldName.contains("-")) //For fields with multiple indices, '-' followed by an index indicates which one
@@ -59,15 +63,11 @@ Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
         haveSubField = false;
     }
 
-    xData = new QVector<double>();
-    yData = new QVector<double>();
-    yDataHistory = new QVector<double>();
+    xData = new PlotRingBuffer<double>();
+    yData = new PlotRingBuffer<double>();
 
-    scalePower = 0;
+    setScalePower(0);
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     yMinimum = 0;
     yMaximum = 120;
 
@@ -83,6 +83,11 @@ Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
 Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
     dataUpdated(false)
 {
+    objectId = 0;
+    fieldIndex = -1;
+    boundField = NULL;
+    elementIndex = 0;
+
     uavObjectName = p_uavObject;
 
     if(p_uavFieldName.contains("-")) //For fields with multiple indices, '-' followed by an index indicates which one
@@ -98,17 +103,14 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
         haveSubField = false;
     }
 
-    xData = new QVector<double>();
-    yData = new QVector<double>();
-    zData = new QVector<double>();
-    zDataHistory = new QVector<double>();
-    timeDataHistory = new QVector<double>();
+    xData = new PlotRingBuffer<double>();
+    yData = new PlotRingBuffer<double>();
+    zData = new PlotRingBuffer<double>();
+    zDataHistory = new PlotRingBuffer<double>();
+    timeDataHistory = new PlotRingBuffer<double>();
 
-    scalePower = 0;
+    setScalePower(0);
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     xMinimum = 0;
     xMaximum = 16;
     yMinimum = 0;
@@ -124,8 +126,6 @@ Plot2dData::~Plot2dData()
         delete xData;
     if (yData != NULL)
         delete yData;
-    if (yDataHistory != NULL)
-        delete yDataHistory;
 }
 
 
@@ -145,23 +145,48 @@ Plot3dData::~Plot3dData()
 
 
 /**
- * @brief valueAsDouble Fetch the value from the UAVO and return it as a double
- * @param obj UAVO
- * @param field UAVO field
- * @param haveSubField TRUE if UAVO has subfield. FALSE if not.
- * @param uavSubFieldName UAVO subfield, if it exists
- * @return
+ * @brief PlotData::bindField Resolves the plotted field and element once, so
+ * that appending a sample is a direct read instead of a search by name
+ * @param obj UAVO holding the plotted field
+ * @return TRUE if the field and subfield exist. FALSE if not.
  */
-double PlotData::valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName)
+bool PlotData::bindField(UAVObject* obj)
 {
-    Q_UNUSED(obj);
-    QVariant value;
+    boundField = NULL;
+
+    QList<UAVObjectField*> fields = obj->getFields();
+    for (fieldIndex = 0; fieldIndex < fields.size(); fieldIndex++) {
+        if (fields.at(fieldIndex)->getName() == uavFieldName)
+            break;
+    }
+    if (fieldIndex == fields.size())
+        return false;
 
+    elementIndex = 0;
     if(haveSubField){
-        int indexOfSubField = field->getElementNames().indexOf(QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
-    }else
-        value = field->getValue();
+        int indexOfSubField = fields.at(fieldIndex)->getElementNames().indexOf(QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
+        if (indexOfSubField < 0)
+            return false;
+        elementIndex = indexOfSubField;
+    }
+
+    boundField = fields.at(fieldIndex);
+    objectId = obj->getObjID();
+
+    return true;
+}
+
+
+/**
+ * @brief PlotData::boundValue Reads the bound field element and applies the scaling
+ * @param obj UAVO with new data. Any instance of the bound object can be read.
+ * @return
+ */
+double PlotData::boundValue(UAVObject* obj)
+{
+    UAVObjectField* field = boundField;
+    if (obj != boundField->getObject())
+        field = obj->getFields().at(fieldIndex);
 
-    return value.toDouble();
+    return field->get<double>(elementIndex) * scaleFactor;
 }
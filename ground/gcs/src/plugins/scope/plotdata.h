@@ -33,10 +33,14 @@ class ScopeGadgetWidget;
 class ScopeConfig;
 
 #include "uavobject.h"
+#include "plotringbuffer.h"
+#include "streamingstatistics.h"
 
 #include "qwt/src/qwt_color_map.h"
 #include "qwt/src/qwt_scale_widget.h"
 
+#include <math.h>
+
 #include <QTimer>
 #include <QTime>
 #include <QVector>
@@ -46,17 +50,17 @@ class PlotData : public QObject
 {
     Q_OBJECT
 public:
-    double valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName);
+    bool bindField(UAVObject* obj);
 
     //Setter functions
     void setXMinimum(double val){xMinimum=val;}
     virtual void setXMaximum(double val){xMaximum=val;}
     void setYMinimum(double val){yMinimum = val;}
     void setYMaximum(double val){yMaximum = val;}
-    void setXWindowSize(double val){m_xWindowSize=val;}
-    void setScalePower(int val){scalePower = val;}
-    void setMeanSamples(int val){meanSamples = val;}
-    void setMathFunction(QString val){mathFunction = val;}
+    virtual void setXWindowSize(double val){m_xWindowSize=val;}
+    void setScalePower(int val){scalePower = val; scaleFactor = pow(10, val);}
+    void setMeanSamples(int val){meanSamples = val; statistics.setWindowSize(val);}
+    void setMathFunction(QString val){mathFunction = val; statistics.setFunction(StreamingStatistics::functionFromName(val));}
 
     //Getter functions
     double getXMinimum(){return xMinimum;}
@@ -66,6 +70,7 @@ public:
     double getXWindowSize(){return m_xWindowSize;}
 
     QString getUavoName(){return uavObjectName;}
+    quint32 getUavoObjectId(){return objectId;}
     QString getUavoFieldName(){return uavFieldName;}
     QString getUavoSubFieldName(){return uavSubFieldName;}
     bool getHaveSubFieldFlag(){return haveSubField;}
@@ -74,8 +79,8 @@ public:
     int getMeanSamples(){return meanSamples;}
     QString getMathFunction(){return mathFunction;}
 
-    QVector<double>* getXData(){return xData;}
-    QVector<double>* getYData(){return yData;}
+    PlotRingBuffer<double>* getXData(){return xData;}
+    PlotRingBuffer<double>* getYData(){return yData;}
 
     virtual bool append(UAVObject* obj) = 0;
     virtual void removeStaleData() = 0;
@@ -87,8 +92,10 @@ public:
     QwtScaleWidget *rightAxis;
 
 protected:
-    QVector<double>* xData;    //Data vector for plots
-    QVector<double>* yData;    //Used vector for plots
+    double boundValue(UAVObject* obj);
+
+    PlotRingBuffer<double>* xData;    //Data vector for plots
+    PlotRingBuffer<double>* yData;    //Used vector for plots
 
     double m_xWindowSize;
     double xMinimum;
@@ -101,13 +108,17 @@ protected:
     QString uavSubFieldName;
     bool haveSubField;
 
+    // Field binding, resolved once by bindField()
+    quint32 objectId;
+    int fieldIndex;
+    UAVObjectField* boundField;
+    quint32 elementIndex;
+
     int scalePower; //This is the power to which each value must be raised
+    double scaleFactor;
     unsigned int meanSamples;
     QString mathFunction;
-    double meanSum;
-
-    double correctionSum;
-    int correctionCount;
+    StreamingStatistics statistics;
 
 private:
 
@@ -0,0 +1,334 @@
+/**
+ ******************************************************************************
+ *
+ * @file       plotringbuffer.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Contiguous ring buffers backing the scope plot data
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "plotringbuffer.h"
+
+#include <qnumeric.h>
+#include <math.h>
+
+
+RingBufferSeriesData::RingBufferSeriesData(const PlotRingBuffer<double> *xData, const PlotRingBuffer<double> *yData) :
+    m_xData(xData),
+    m_yData(yData),
+    m_incremental(false),
+    m_decimating(false),
+    m_columns(0),
+    m_rectLeft(0),
+    m_rectRight(-1),
+    m_bucketWidth(0),
+    m_firstBucket(0),
+    m_nextSequence(0)
+{
+}
+
+
+size_t RingBufferSeriesData::size() const
+{
+    if (m_decimating)
+        return m_points.size();
+
+    return qMin(m_xData->size(), m_yData->size());
+}
+
+
+QPointF RingBufferSeriesData::sample(size_t i) const
+{
+    if (m_decimating)
+        return m_points.at(i);
+
+    return QPointF(m_xData->at(i), m_yData->at(i));
+}
+
+
+/**
+ * @brief RingBufferSeriesData::boundingRect Scans the live window. This is
+ * only needed when the plot autoscales, so it is not cached; the buffers
+ * change underneath this object on every append. The decimated points keep
+ * every bucket's extremes, so scanning them gives the same answer.
+ */
+QRectF RingBufferSeriesData::boundingRect() const
+{
+    const int n = size();
+    if (n == 0)
+        return QRectF(0.0, 0.0, -1.0, -1.0);
+
+    QPointF p = sample(0);
+    double minX = p.x(), maxX = p.x();
+    double minY = p.y(), maxY = p.y();
+    for (int i = 1; i < n; i++) {
+        p = sample(i);
+        if (p.x() < minX) minX = p.x();
+        if (p.x() > maxX) maxX = p.x();
+        if (p.y() < minY) minY = p.y();
+        if (p.y() > maxY) maxY = p.y();
+    }
+
+    return QRectF(minX, minY, maxX - minX, maxY - minY);
+}
+
+
+/**
+ * @brief RingBufferSeriesData::setRectOfInterest Called by Qwt with the
+ * visible area before every replot. Scrolling keeps the bucket width, so
+ * only zooming forces the buckets to be rebuilt.
+ */
+void RingBufferSeriesData::setRectOfInterest(const QRectF &rect)
+{
+    m_rectLeft = rect.left();
+    m_rectRight = rect.right();
+
+    updateBucketWidth();
+    update();
+}
+
+
+/**
+ * @brief RingBufferSeriesData::setColumnCount Sets the number of pixel
+ * columns the curve is drawn across
+ */
+void RingBufferSeriesData::setColumnCount(int columns)
+{
+    if (columns == m_columns)
+        return;
+
+    m_columns = columns;
+    updateBucketWidth();
+    update();
+}
+
+
+/**
+ * @brief RingBufferSeriesData::update Brings the decimated view up to date
+ * with the ring buffers. Call after appending samples.
+ */
+void RingBufferSeriesData::update()
+{
+    if (!m_incremental || m_bucketWidth <= 0)
+        resetBuckets();
+    else
+        retireBuckets();
+
+    if (m_bucketWidth > 0) {
+        const quint64 end = m_xData->firstSequence() + qMin(m_xData->size(), m_yData->size());
+        while (m_nextSequence < end)
+            addSample(m_nextSequence++);
+    }
+
+    rebuildPoints();
+}
+
+
+void RingBufferSeriesData::updateBucketWidth()
+{
+    double bucketWidth = 0;
+    if (m_columns > 0 && m_rectRight > m_rectLeft)
+        bucketWidth = (m_rectRight - m_rectLeft) / m_columns;
+
+    // Ignore rounding noise from the scale maps while scrolling
+    if (qAbs(bucketWidth - m_bucketWidth) <= 1e-9 * qAbs(bucketWidth))
+        return;
+
+    m_bucketWidth = bucketWidth;
+    resetBuckets();
+}
+
+
+/**
+ * @brief RingBufferSeriesData::rawSample Looks up a sample by the sequence
+ * number of its x value
+ */
+QPointF RingBufferSeriesData::rawSample(quint64 sequence) const
+{
+    const int i = sequence - m_xData->firstSequence();
+    return QPointF(m_xData->at(i), m_yData->at(i));
+}
+
+
+void RingBufferSeriesData::addSample(quint64 sequence)
+{
+    const QPointF p = rawSample(sequence);
+    const qint64 column = (qint64) floor(p.x() / m_bucketWidth);
+
+    if (m_firstBucket < m_buckets.size() && m_buckets.last().column == column) {
+        Bucket &bucket = m_buckets.last();
+        bucket.lastSequence = sequence;
+        if (p.y() < rawSample(bucket.minSequence).y())
+            bucket.minSequence = sequence;
+        if (p.y() > rawSample(bucket.maxSequence).y())
+            bucket.maxSequence = sequence;
+        return;
+    }
+
+    Bucket bucket;
+    bucket.column = column;
+    bucket.firstSequence = sequence;
+    bucket.lastSequence = sequence;
+    bucket.minSequence = sequence;
+    bucket.maxSequence = sequence;
+    m_buckets.append(bucket);
+}
+
+
+/**
+ * @brief RingBufferSeriesData::retireBuckets Drops the buckets whose samples
+ * have all left the ring buffers and trims the one that lost only some.
+ */
+void RingBufferSeriesData::retireBuckets()
+{
+    const quint64 first = m_xData->firstSequence();
+
+    while (m_firstBucket < m_buckets.size() && m_buckets.at(m_firstBucket).lastSequence < first)
+        m_firstBucket++;
+
+    if (m_firstBucket < m_buckets.size() && m_buckets.at(m_firstBucket).firstSequence < first) {
+        Bucket &bucket = m_buckets[m_firstBucket];
+        bucket.firstSequence = first;
+        bucket.minSequence = first;
+        bucket.maxSequence = first;
+        for (quint64 sequence = first + 1; sequence <= bucket.lastSequence; sequence++) {
+            const double y = rawSample(sequence).y();
+            if (y < rawSample(bucket.minSequence).y())
+                bucket.minSequence = sequence;
+            if (y > rawSample(bucket.maxSequence).y())
+                bucket.maxSequence = sequence;
+        }
+    }
+
+    // Compact once the retired buckets outnumber the live ones
+    if (m_firstBucket > 0 && m_firstBucket >= m_buckets.size() - m_firstBucket) {
+        m_buckets.remove(0, m_firstBucket);
+        m_firstBucket = 0;
+    }
+
+    if (m_nextSequence < first)
+        m_nextSequence = first;
+}
+
+
+/**
+ * @brief RingBufferSeriesData::resetBuckets Discards the buckets so the next
+ * update() rebuilds them from every sample in the ring buffers
+ */
+void RingBufferSeriesData::resetBuckets()
+{
+    m_buckets.clear();
+    m_firstBucket = 0;
+    m_nextSequence = m_xData->firstSequence();
+}
+
+
+/**
+ * @brief RingBufferSeriesData::rebuildPoints Emits the M4 points of the
+ * buckets in view, plus one bucket either side so lines run off the edges
+ */
+void RingBufferSeriesData::rebuildPoints()
+{
+    m_points.clear();
+
+    const int n = qMin(m_xData->size(), m_yData->size());
+    m_decimating = m_bucketWidth > 0 && n > 4 * m_columns;
+    if (!m_decimating)
+        return;
+
+    const qint64 leftColumn = (qint64) floor(m_rectLeft / m_bucketWidth) - 1;
+    const qint64 rightColumn = (qint64) floor(m_rectRight / m_bucketWidth) + 1;
+
+    m_points.reserve(4 * (m_columns + 2));
+    for (int i = m_firstBucket; i < m_buckets.size(); i++) {
+        const Bucket &bucket = m_buckets.at(i);
+        if (bucket.column < leftColumn || bucket.column > rightColumn)
+            continue;
+
+        quint64 sequences[4];
+        sequences[0] = bucket.firstSequence;
+        sequences[1] = qMin(bucket.minSequence, bucket.maxSequence);
+        sequences[2] = qMax(bucket.minSequence, bucket.maxSequence);
+        sequences[3] = bucket.lastSequence;
+
+        for (int j = 0; j < 4; j++) {
+            if (j > 0 && sequences[j] == sequences[j - 1])
+                continue;
+            m_points.append(rawSample(sequences[j]));
+        }
+    }
+}
+
+
+RingBufferRasterData::RingBufferRasterData(const PlotRingBuffer<double> *values, unsigned int numColumns) :
+    m_values(values),
+    m_numColumns(numColumns),
+    m_numRows(0),
+    m_dx(0),
+    m_dy(0)
+{
+}
+
+
+/**
+ * @brief RingBufferRasterData::initRaster Called by the spectrogram before
+ * each render. Latches the current row count so the whole image is drawn
+ * from one consistent window.
+ */
+void RingBufferRasterData::initRaster(const QRectF &area, const QSize &raster)
+{
+    QwtRasterData::initRaster(area, raster);
+
+    m_numRows = m_numColumns > 0 ? m_values->size() / m_numColumns : 0;
+    m_dx = 0;
+    m_dy = 0;
+
+    const QwtInterval xInterval = interval(Qt::XAxis);
+    const QwtInterval yInterval = interval(Qt::YAxis);
+    if (xInterval.isValid() && m_numColumns > 0)
+        m_dx = xInterval.width() / m_numColumns;
+    if (yInterval.isValid() && m_numRows > 0)
+        m_dy = yInterval.width() / m_numRows;
+}
+
+
+double RingBufferRasterData::value(double x, double y) const
+{
+    const QwtInterval xInterval = interval(Qt::XAxis);
+    const QwtInterval yInterval = interval(Qt::YAxis);
+
+    if (m_numRows == 0 || m_dx <= 0 || m_dy <= 0)
+        return qQNaN();
+
+    if (!(xInterval.contains(x) && yInterval.contains(y)))
+        return qQNaN();
+
+    unsigned int row = (unsigned int) ((y - yInterval.minValue()) / m_dy);
+    unsigned int col = (unsigned int) ((x - xInterval.minValue()) / m_dx);
+
+    // The maximum is part of the interval, so clamp to the last row/column
+    if (row >= m_numRows)
+        row = m_numRows - 1;
+    if (col >= m_numColumns)
+        col = m_numColumns - 1;
+
+    return m_values->data()[row * m_numColumns + col];
+}
@@ -0,0 +1,255 @@
+/**
+ ******************************************************************************
+ *
+ * @file       plotringbuffer.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Contiguous ring buffers backing the scope plot data
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PLOTRINGBUFFER_H
+#define PLOTRINGBUFFER_H
+
+#include "qwt/src/qwt_series_data.h"
+#include "qwt/src/qwt_raster_data.h"
+
+#include <QVector>
+
+/**
+ * @brief The PlotRingBuffer class is a bounded FIFO of samples whose contents
+ * are always available as one contiguous array, oldest sample first.
+ *
+ * Every sample is written twice, once at its slot and once at the same slot
+ * in a mirror half of the storage. The live window therefore never wraps, so
+ * appending and evicting are O(1) and readers can walk data() directly.
+ *
+ * Storage starts small and doubles until it reaches the capacity, after which
+ * append() overwrites the oldest sample. A capacity of 0 means unbounded.
+ *
+ * Each appended sample also gets a sequence number, so consumers can tell
+ * which samples are new since they last looked and which have been dropped.
+ */
+template <typename T>
+class PlotRingBuffer
+{
+public:
+    PlotRingBuffer(int capacity = 0) :
+        m_capacity(capacity), m_head(0), m_size(0), m_firstSequence(0)
+    {
+    }
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    int capacity() const { return m_capacity; }
+
+    const T *data() const { return m_storage.constData() + m_head; }
+    const T &at(int i) const { return m_storage.at(m_head + i); }
+    const T &first() const { return at(0); }
+    const T &last() const { return at(m_size - 1); }
+
+    //! Sequence number of the oldest sample
+    quint64 firstSequence() const { return m_firstSequence; }
+    //! Sequence number the next appended sample will get
+    quint64 endSequence() const { return m_firstSequence + m_size; }
+
+    /**
+     * @brief setCapacity Changes the maximum number of samples kept. Excess
+     * samples are dropped from the front.
+     */
+    void setCapacity(int capacity)
+    {
+        m_capacity = capacity;
+        if (m_capacity > 0 && m_size > m_capacity)
+            popFront(m_size - m_capacity);
+        if (m_capacity > 0 && slots() > m_capacity)
+            reallocate(m_capacity);
+    }
+
+    void append(const T &value)
+    {
+        if (m_size == slots()) {
+            if (m_capacity == 0 || m_size < m_capacity)
+                reallocate(qMax((int) MIN_SLOTS, m_size * 2));
+            else
+                popFront(1);
+        }
+
+        const int n = slots();
+        int tail = m_head + m_size;
+        if (tail >= n)
+            tail -= n;
+
+        m_storage[tail] = value;
+        m_storage[tail + n] = value;
+        m_size++;
+    }
+
+    void append(const T *values, int count)
+    {
+        for (int i = 0; i < count; i++)
+            append(values[i]);
+    }
+
+    /**
+     * @brief popFront Drops the @p count oldest samples.
+     */
+    void popFront(int count = 1)
+    {
+        count = qMin(count, m_size);
+        if (count <= 0)
+            return;
+
+        m_head += count;
+        if (m_head >= slots())
+            m_head -= slots();
+        m_size -= count;
+        m_firstSequence += count;
+    }
+
+    /**
+     * @brief popBack Drops the newest sample.
+     */
+    void popBack()
+    {
+        if (m_size > 0)
+            m_size--;
+    }
+
+    void clear()
+    {
+        m_firstSequence += m_size;
+        m_head = 0;
+        m_size = 0;
+    }
+
+private:
+    enum { MIN_SLOTS = 256 };
+
+    int slots() const { return m_storage.size() / 2; }
+
+    void reallocate(int newSlots)
+    {
+        if (m_capacity > 0)
+            newSlots = qMin(newSlots, m_capacity);
+
+        QVector<T> storage(newSlots * 2);
+        for (int i = 0; i < m_size; i++) {
+            storage[i] = at(i);
+            storage[i + newSlots] = storage[i];
+        }
+
+        m_storage = storage;
+        m_head = 0;
+    }
+
+    QVector<T> m_storage;
+    int m_capacity;
+    int m_head;
+    int m_size;
+    quint64 m_firstSequence;
+};
+
+
+/**
+ * @brief The RingBufferSeriesData class exposes a pair of x/y ring buffers
+ * to a QwtPlotCurve without copying them.
+ *
+ * When there are many more samples than pixel columns, the curve is given a
+ * decimated view instead: the x range is cut into one bucket per column and
+ * each bucket contributes its first, minimum, maximum and last sample (M4).
+ * That draws the same pixels as the full series, so render cost is bounded by
+ * the widget width. Buckets sit on a grid anchored at x = 0, so while the
+ * bucket width is unchanged they can be updated incrementally: new samples
+ * extend the newest bucket and evicted samples retire the oldest ones. A
+ * change of zoom or width rebuilds them.
+ *
+ * Incremental updates need every sample to keep its x value once appended,
+ * as in a time series. Otherwise the buckets are rebuilt on every update().
+ */
+class RingBufferSeriesData : public QwtSeriesData<QPointF>
+{
+public:
+    RingBufferSeriesData(const PlotRingBuffer<double> *xData, const PlotRingBuffer<double> *yData);
+
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+    virtual void setRectOfInterest(const QRectF &rect);
+
+    void setIncremental(bool incremental) { m_incremental = incremental; }
+    void setColumnCount(int columns);
+    void update();
+
+private:
+    struct Bucket {
+        qint64 column;
+        quint64 firstSequence;
+        quint64 lastSequence;
+        quint64 minSequence;
+        quint64 maxSequence;
+    };
+
+    QPointF rawSample(quint64 sequence) const;
+    void addSample(quint64 sequence);
+    void retireBuckets();
+    void resetBuckets();
+    void rebuildPoints();
+    void updateBucketWidth();
+
+    const PlotRingBuffer<double> *m_xData;
+    const PlotRingBuffer<double> *m_yData;
+
+    bool m_incremental;
+    bool m_decimating;
+    int m_columns;
+    double m_rectLeft;
+    double m_rectRight;
+    double m_bucketWidth;
+
+    QVector<Bucket> m_buckets;
+    int m_firstBucket;
+    quint64 m_nextSequence;
+    QVector<QPointF> m_points;
+};
+
+
+/**
+ * @brief The RingBufferRasterData class exposes a ring buffer of equally
+ * sized rows to a QwtPlotSpectrogram. The oldest row is drawn at the bottom
+ * of the Y interval. Lookups are nearest neighbour, like QwtMatrixRasterData.
+ */
+class RingBufferRasterData : public QwtRasterData
+{
+public:
+    RingBufferRasterData(const PlotRingBuffer<double> *values, unsigned int numColumns);
+
+    virtual void initRaster(const QRectF &, const QSize &);
+    virtual double value(double x, double y) const;
+
+private:
+    const PlotRingBuffer<double> *m_values;
+    unsigned int m_numColumns;
+    unsigned int m_numRows;
+    double m_dx;
+    double m_dy;
+};
+
+#endif // PLOTRINGBUFFER_H
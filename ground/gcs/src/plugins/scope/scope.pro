@@ -9,6 +9,7 @@ HEADERS += scopeplugin.h \
     scopes2d/scatterplotdata.h \
     scopes2d/scatterplotscopeconfig.h \
     scopes3d/spectrogramplotdata.h \
+    scopes3d/spectrogramfft.h \
     scopes3d/spectrogramscopeconfig.h \
     scopes2d/plotdata2d.h \
     scopes2d/scopes2dconfig.h \
@@ -16,6 +17,8 @@ HEADERS += scopeplugin.h \
     scopes3d/scopes3dconfig.h \
     scopesconfig.h \
     plotdata.h \
+    plotringbuffer.h \
+    streamingstatistics.h \
     scope_global.h
 HEADERS += scopegadgetoptionspage.h
 HEADERS += scopegadgetconfiguration.h
@@ -28,8 +31,11 @@ SOURCES += scopeplugin.cpp \
     scopes2d/scatterplotdata.cpp \
     scopes2d/scatterplotscopeconfig.cpp \
     scopes3d/spectrogramplotdata.cpp \
+    scopes3d/spectrogramfft.cpp \
     scopes3d/spectrogramscopeconfig.cpp \
-    plotdata.cpp
+    plotdata.cpp \
+    plotringbuffer.cpp \
+    streamingstatistics.cpp
 SOURCES += scopegadgetoptionspage.cpp
 SOURCES += scopegadgetconfiguration.cpp
 SOURCES += scopegadget.cpp
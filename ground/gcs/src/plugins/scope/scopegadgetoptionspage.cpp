@@ -38,6 +38,7 @@
 #include "scopes2d/histogramscopeconfig.h"
 #include "scopes2d/scatterplotscopeconfig.h"
 #include "scopes3d/spectrogramscopeconfig.h"
+#include "streamingstatistics.h"
 
 #include <QtGui/qpalette.h>
 #include <QtGui/QMessageBox>
@@ -105,8 +106,7 @@ QWidget* ScopeGadgetOptionsPage::createPage(QWidget *parent)
         }
     }
 
-    QStringList mathFunctions;
-    mathFunctions << "None" << "Boxcar average" << "Standard deviation";
+    QStringList mathFunctions = StreamingStatistics::functionNames();
 
     options_page->mathFunctionComboBox->addItems(mathFunctions);
     options_page->cmbMathFunctionSpectrogram->addItems(mathFunctions);
@@ -208,7 +208,7 @@ bool ScopeGadgetOptionsPage::eventFilter( QObject * obj, QEvent * evt ) {
 }
 
 void ScopeGadgetOptionsPage::on_mathFunctionComboBox_currentIndexChanged(int currentIndex){
-    if (currentIndex > 0){
+    if (StreamingStatistics::usesWindow((StreamingStatistics::MathFunction) currentIndex)){
         options_page->spnMeanSamples->setEnabled(true);
     }
     else{
@@ -294,7 +294,8 @@ void ScopeGadgetWidget::showCurve(QwtPlotItem *item, bool on)
  */
 void ScopeGadgetWidget::uavObjectReceived(UAVObject* obj)
 {
-    foreach(PlotData* plotdData, m_dataSources.values()) {
+    // Only visit the plots bound to this object
+    foreach(PlotData* plotdData, m_dataSourcesByObjectId.value(obj->getObjID())) {
         bool ret = plotdData->append(obj);
         if (ret)
             plotdData->setUpdatedFlagToTrue();
@@ -341,6 +342,7 @@ void ScopeGadgetWidget::clearPlotWidget()
 
         // Clear the data
         m_dataSources.clear();
+        m_dataSourcesByObjectId.clear();
     }
 }
 
@@ -387,6 +389,19 @@ void ScopeGadgetWidget::showEvent(QShowEvent *event)
 }
 
 
+/**
+ * @brief ScopeGadgetWidget::insertDataSources Adds a plot, and registers it
+ * for updates of the UAVO it is bound to
+ * @param stringVal Plot name
+ * @param dataVal Plot data, already bound with PlotData::bindField()
+ */
+void ScopeGadgetWidget::insertDataSources(QString stringVal, PlotData* dataVal)
+{
+    m_dataSources.insert(stringVal, dataVal);
+    m_dataSourcesByObjectId[dataVal->getUavoObjectId()].append(dataVal);
+}
+
+
 /**
  * @brief ScopeGadgetWidget::connectUAVO Connects UAVO update signal, but only if it hasn't yet been connected
  * @param obj
@@ -49,6 +49,7 @@ class UAVDataObject;
 #include <QTime>
 #include <QVector>
 #include <QMutex>
+#include <QHash>
 
 /*!
   \brief This class is used to render the time values on the horizontal axis for the
@@ -84,7 +85,7 @@ public:
 
     void setScope(ScopeConfig *val){m_scope = val;}
     QMap<QString, PlotData*> getDataSources(){return m_dataSources;}
-    void insertDataSources(QString stringVal, PlotData* dataVal){m_dataSources.insert(stringVal, dataVal);}
+    void insertDataSources(QString stringVal, PlotData* dataVal);
 
     void addLegend();
     void deleteLegend();
@@ -113,6 +114,7 @@ private:
     int m_refreshInterval;
     ScopeConfig *m_scope;
     QMap<QString, PlotData*> m_dataSources;
+    QHash<quint32, QList<PlotData*> > m_dataSourcesByObjectId; //Plots fed by each UAVO, keyed by object ID
     double m_xWindowSize;
     static QTimer *replotTimer;
     QList<QString> m_connectedUAVObjects;
@@ -57,7 +57,7 @@ HistogramData::HistogramData(QString uavObject, QString uavField, double binWidt
 {
     this->binWidth = binWidth;
     this->numberOfBins = numberOfBins;
-    scalePower = 1;
+    setScalePower(1);
 
     //Create histogram data set
     histogramBins = new QVector<QwtIntervalSample>();
@@ -96,10 +96,7 @@ bool HistogramData::append(UAVObject* obj)
     xData->clear();
     yData->clear();
 
-    if (uavObjectName == obj->getName()) {
-
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
+    if (obj->getObjID() == objectId) {
 
         //Bad place to do this
         double step = binWidth;
@@ -109,66 +106,64 @@ bool HistogramData::append(UAVObject* obj)
         if (numberOfBins > MAX_NUMBER_OF_INTERVALS)
             numberOfBins = MAX_NUMBER_OF_INTERVALS;
 
-        if (field) {
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
+        double currentValue = boundValue(obj);
 
-            // Extend interval, if necessary
-            if(!histogramInterval->empty()){
-                while (currentValue < histogramInterval->front().minValue()
-                       && histogramInterval->size() <= (int) numberOfBins){
-                    histogramInterval->prepend(QwtInterval(histogramInterval->front().minValue() - step, histogramInterval->front().minValue()));
-                    histogramBins->prepend(QwtIntervalSample(0,histogramInterval->front()));
-                }
+        // Extend interval, if necessary
+        if(!histogramInterval->empty()){
+            while (currentValue < histogramInterval->front().minValue()
+                   && histogramInterval->size() <= (int) numberOfBins){
+                histogramInterval->prepend(QwtInterval(histogramInterval->front().minValue() - step, histogramInterval->front().minValue()));
+                histogramBins->prepend(QwtIntervalSample(0,histogramInterval->front()));
+            }
 
-                while (currentValue > histogramInterval->back().maxValue()
-                       && histogramInterval->size() <= (int) numberOfBins){
-                    histogramInterval->append(QwtInterval(histogramInterval->back().maxValue(), histogramInterval->back().maxValue() + step));
-                    histogramBins->append(QwtIntervalSample(0,histogramInterval->back()));
-                }
+            while (currentValue > histogramInterval->back().maxValue()
+                   && histogramInterval->size() <= (int) numberOfBins){
+                histogramInterval->append(QwtInterval(histogramInterval->back().maxValue(), histogramInterval->back().maxValue() + step));
+                histogramBins->append(QwtIntervalSample(0,histogramInterval->back()));
+            }
 
-                // If the histogram reaches its max size, pop one off the end and return
-                // This is a graceful way not to lock up the GCS if the bin width
-                // is inappropriate, or if there is an extremely distant outlier.
-                if (histogramInterval->size() > (int) numberOfBins )
-                {
-                    histogramBins->pop_back();
-                    histogramInterval->pop_back();
-                    return false;
-                }
+            // If the histogram reaches its max size, pop one off the end and return
+            // This is a graceful way not to lock up the GCS if the bin width
+            // is inappropriate, or if there is an extremely distant outlier.
+            if (histogramInterval->size() > (int) numberOfBins )
+            {
+                histogramBins->pop_back();
+                histogramInterval->pop_back();
+                return false;
+            }
 
-                // Test all intervals. This isn't particularly effecient, especially if we have just
-                // extended the interval and thus know for sure that the point lies on the extremity.
-                // On top of that, some kind of search by bisection would be better.
-                for (int i=0; i < histogramInterval->size(); i++ ){
-                    if(histogramInterval->at(i).contains(currentValue)){
-                        histogramBins->replace(i, QwtIntervalSample(histogramBins->at(i).value + 1, histogramInterval->at(i)));
-                        break;
-                    }
+            // Test all intervals. This isn't particularly effecient, especially if we have just
+            // extended the interval and thus know for sure that the point lies on the extremity.
+            // On top of that, some kind of search by bisection would be better.
+            for (int i=0; i < histogramInterval->size(); i++ ){
+                if(histogramInterval->at(i).contains(currentValue)){
+                    histogramBins->replace(i, QwtIntervalSample(histogramBins->at(i).value + 1, histogramInterval->at(i)));
+                    break;
+                }
 
+            }
+        }
+        else{
+            // Create first interval
+            double tmp=0;
+            if (tmp < currentValue){
+                while (tmp < currentValue){
+                    tmp+=step;
                 }
+                histogramInterval->append(QwtInterval(tmp-step, tmp));
             }
             else{
-                // Create first interval
-                double tmp=0;
-                if (tmp < currentValue){
-                    while (tmp < currentValue){
-                        tmp+=step;
-                    }
-                    histogramInterval->append(QwtInterval(tmp-step, tmp));
+                while (tmp > step){
+                    tmp-=step;
                 }
-                else{
-                    while (tmp > step){
-                        tmp-=step;
-                    }
-                    histogramInterval->append(QwtInterval(tmp, tmp+step));
-                }
-
-                histogramBins->append(QwtIntervalSample(0,histogramInterval->front()));
+                histogramInterval->append(QwtInterval(tmp, tmp+step));
             }
 
-
-            return true;
+            histogramBins->append(QwtIntervalSample(0,histogramInterval->front()));
         }
+
+
+        return true;
     }
 
     return false;
@@ -255,6 +255,13 @@ void HistogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWidge
             return;
         }
 
+        //Resolve the plotted field once, rather than on every update
+        if(!histogramData->bindField(obj)) {
+            qDebug() << "Field " << histogramData->getUavoFieldName() << " of " << histogramData->getUavoName() << " is missing";
+            delete histogramData;
+            return;
+        }
+
         //Get the units
         QString units = getUavObjectFieldUnits(histogramData->getUavoName(), histogramData->getUavoFieldName());
 
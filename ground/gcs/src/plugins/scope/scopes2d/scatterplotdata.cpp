@@ -50,8 +50,7 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
     Q_UNUSED(scopeGadgetWidget);
 
     //Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+    updateSeriesData(scopeGadgetWidget);
 
     QDateTime NOW = QDateTime::currentDateTime();
     double toTime = NOW.toTime_t();
@@ -72,8 +71,18 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
     Q_UNUSED(scopeGadgetWidget);
 
     //Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+    updateSeriesData(scopeGadgetWidget);
+}
+
+
+void SeriesPlotData::setXWindowSize(double val)
+{
+    PlotData::setXWindowSize(val);
+
+    // Once full, appending to yData overwrites its oldest sample
+    int windowSamples = qMax(1, (int) val);
+    xData->setCapacity(windowSamples);
+    yData->setCapacity(windowSamples);
 }
 
 
@@ -84,61 +93,18 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
  */
 bool SeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the front
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            if (yData->size() > getXWindowSize()) { //If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
-
-            return true;
-        }
+    if (obj->getObjID() == objectId) {
+        QDateTime NOW = QDateTime::currentDateTime();
+        double currentValue = boundValue(obj);
+
+        //Perform scope math, if any
+        yData->append(statistics.push(currentValue, NOW.toTime_t() + NOW.time().msec() / 1000.0));
+
+        // Until the window fills, add a new x point for each y point
+        if (xData->size() < yData->size())
+            xData->append(xData->size());
+
+        return true;
     }
 
     return false;
@@ -152,60 +118,19 @@ bool SeriesPlotData::append(UAVObject* obj)
  */
 bool TimeSeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-            QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the back
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
-
-            //Remove stale data
-            removeStaleData();
-
-            return true;
-        }
+    if (obj->getObjID() == objectId) {
+        QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
+        double currentValue = boundValue(obj);
+        double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+
+        //Perform scope math, if any
+        yData->append(statistics.push(currentValue, valueX));
+        xData->append(valueX);
+
+        //Remove stale data
+        removeStaleData();
+
+        return true;
     }
 
     return false;
@@ -228,8 +153,8 @@ void TimeSeriesPlotData::removeStaleData()
         oldestValue = xData->first();
 
         if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
+            yData->popFront();
+            xData->popFront();
         } else
             break;
     }
@@ -245,6 +170,36 @@ void TimeSeriesPlotData::removeStaleDataTimeout()
 }
 
 
+/**
+ * @brief ScatterplotData::setCurve Attaches the curve that draws this data.
+ * The curve reads xData and yData in place, through a decimating view.
+ * @param val Curve, which takes ownership of the view
+ */
+void ScatterplotData::setCurve(QwtPlotCurve *val)
+{
+    curve = val;
+
+    seriesData = new RingBufferSeriesData(xData, yData);
+    seriesData->setIncremental(hasFixedXValues());
+    curve->setData(seriesData);
+}
+
+
+/**
+ * @brief ScatterplotData::updateSeriesData Brings the curve's decimated view
+ * up to date with the latest samples and the current canvas width
+ */
+void ScatterplotData::updateSeriesData(ScopeGadgetWidget *scopeGadgetWidget)
+{
+    seriesData->setColumnCount(scopeGadgetWidget->canvas()->width());
+
+    if (readAndResetUpdatedFlag() == true) {
+        seriesData->update();
+        curve->itemChanged();
+    }
+}
+
+
 /**
  * @brief ScatterplotData::clearPlots Clear all plot data
  */
@@ -45,15 +45,24 @@ class ScatterplotData : public Plot2dData
     Q_OBJECT
 public:
     ScatterplotData(QString uavObject, QString uavField):
-        Plot2dData(uavObject, uavField){curve = 0;}
+        Plot2dData(uavObject, uavField){curve = 0; seriesData = 0;}
     ~ScatterplotData(){}
 
     virtual void clearPlots(PlotData *);
 
-    void setCurve(QwtPlotCurve *val){curve = val;}
+    void setCurve(QwtPlotCurve *val);
 
 protected:
+    /*!
+      \brief True if a sample's x value never changes once appended, which lets
+      the curve decimation be updated incrementally
+      */
+    virtual bool hasFixedXValues(){return false;}
+
+    void updateSeriesData(ScopeGadgetWidget *scopeGadgetWidget);
+
     QwtPlotCurve* curve;
+    RingBufferSeriesData* seriesData; //Owned by curve
 };
 
 
@@ -75,6 +84,10 @@ public:
       */
     bool append(UAVObject* obj);
 
+    /*!
+      \brief The window is a number of samples, so it bounds the buffers directly
+      */
+    virtual void setXWindowSize(double val);
 
     /*!
       \brief Removes the old data from the buffer
@@ -94,7 +107,7 @@ class TimeSeriesPlotData : public ScatterplotData
 public:
     TimeSeriesPlotData(QString uavObject, QString uavField)
             : ScatterplotData(uavObject, uavField) {
-        scalePower = 1;
+        setScalePower(1);
     }
     ~TimeSeriesPlotData() {
     }
@@ -104,6 +117,9 @@ public:
     virtual void removeStaleData();
     virtual void plotNewData(PlotData *, ScopeConfig *, ScopeGadgetWidget *);
 
+protected:
+    virtual bool hasFixedXValues(){return true;}
+
 private slots:
     void removeStaleDataTimeout();
 };
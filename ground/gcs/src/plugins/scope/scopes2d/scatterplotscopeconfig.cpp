@@ -260,6 +260,13 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
             return;
         }
 
+        //Resolve the plotted field once, rather than on every update
+        if(!scatterplotData->bindField(obj)) {
+            qDebug() << "Field " << scatterplotData->getUavoFieldName() << " of " << scatterplotData->getUavoName() << " is missing";
+            delete scatterplotData;
+            return;
+        }
+
         //Get the units
         QString units = getUavObjectFieldUnits(scatterplotData->getUavoName(), scatterplotData->getUavoFieldName());
 
@@ -270,21 +277,8 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
         else
             curveNameScaled = curveName + "(x10^" + QString::number(plotCurveConfig->yScalePower) + " " + units + ")";
 
-        QString curveNameScaledMath;
-        if (plotCurveConfig->mathFunction == "None")
-            curveNameScaledMath = curveNameScaled;
-        else if (plotCurveConfig->mathFunction == "Boxcar average"){
-            curveNameScaledMath = curveNameScaled + " (avg)";
-        }
-        else if (plotCurveConfig->mathFunction == "Standard deviation"){
-            curveNameScaledMath = curveNameScaled + " (std)";
-        }
-        else
-        {
-            //Shouldn't be able to get here. Perhaps a new math function was added without
-            // updating this list?
-            Q_ASSERT(0);
-        }
+        QString curveNameScaledMath = curveNameScaled +
+                StreamingStatistics::functionSuffix(StreamingStatistics::functionFromName(plotCurveConfig->mathFunction));
 
         while(scopeGadgetWidget->getDataSources().keys().contains(curveNameScaledMath))
             curveNameScaledMath=curveNameScaledMath+"*";
@@ -292,7 +286,6 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
         //Create the curve plot
         QwtPlotCurve* plotCurve = new QwtPlotCurve(curveNameScaledMath);
         plotCurve->setPen(QPen(QBrush(QColor(color), Qt::SolidPattern), (qreal)1, Qt::SolidLine, Qt::SquareCap, Qt::BevelJoin));
-        plotCurve->setSamples(*(scatterplotData->getXData()), *(scatterplotData->getYData()));
         plotCurve->attach(scopeGadgetWidget);
         scatterplotData->setCurve(plotCurve);
 
@@ -46,9 +46,9 @@ public:
     Plot3dData(QString uavObject, QString uavField);
     ~Plot3dData();
 
-    QVector<double>* zData;
-    QVector<double>* zDataHistory;
-    QVector<double>* timeDataHistory;
+    PlotRingBuffer<double>* zData;
+    PlotRingBuffer<double>* zDataHistory;    //Rows of spectrogram data, oldest first
+    PlotRingBuffer<double>* timeDataHistory;
 
     void setZMinimum(double val){zMinimum=val;}
     void setZMaximum(double val){zMaximum=val;}
@@ -0,0 +1,231 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrogramfft.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Computes spectrogram rows from a scalar sample stream
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes3d/spectrogramfft.h"
+
+#include <QMetaObject>
+#include <QMutexLocker>
+
+#include <math.h>
+
+const double SpectrogramFFT::DB_FLOOR = -120.0;
+
+
+/**
+ * @brief SpectrogramFFT::SpectrogramFFT
+ * @param rowWidth Number of frequency bins per row. Frames are twice as long.
+ * @param overlap Fraction of each frame shared with the next one, in [0, 1)
+ */
+SpectrogramFFT::SpectrogramFFT(unsigned int rowWidth, double overlap) :
+    rowWidth(qMax(rowWidth, 1u)),
+    processPending(false),
+    samplesSinceRow(0)
+{
+    frameSize = 2 * this->rowWidth;
+    overlap = qBound(0.0, overlap, 0.95);
+    hopSize = qMax(1u, (unsigned int) (frameSize * (1 - overlap)));
+    powerOfTwo = (this->rowWidth & (this->rowWidth - 1)) == 0;
+
+    frame.setCapacity(frameSize);
+
+    // Periodic Hann window
+    hannWindow.resize(frameSize);
+    windowGain = 0;
+    for (unsigned int i = 0; i < frameSize; i++) {
+        hannWindow[i] = 0.5 * (1 - cos(2 * M_PI * i / frameSize));
+        windowGain += hannWindow[i];
+    }
+
+    re.resize(this->rowWidth);
+    im.resize(this->rowWidth);
+}
+
+
+/**
+ * @brief SpectrogramFFT::addSample Queues a sample for the worker thread
+ */
+void SpectrogramFFT::addSample(double value)
+{
+    QMutexLocker locker(&inputMutex);
+    input.append(value);
+
+    // One queued call drains everything that arrives before it runs
+    if (!processPending) {
+        processPending = true;
+        QMetaObject::invokeMethod(this, "processSamples", Qt::QueuedConnection);
+    }
+}
+
+
+/**
+ * @brief SpectrogramFFT::takeRows Moves the finished rows out
+ * @param rows Rows are appended to this, rowWidth values each
+ * @return Number of rows appended
+ */
+int SpectrogramFFT::takeRows(QVector<double> &rows)
+{
+    QMutexLocker locker(&outputMutex);
+    int numRows = output.size() / rowWidth;
+    rows += output;
+    output.clear();
+    return numRows;
+}
+
+
+/**
+ * @brief SpectrogramFFT::processSamples Runs in the worker thread. Frames the
+ * queued samples and emits a row every hop.
+ */
+void SpectrogramFFT::processSamples()
+{
+    QVector<double> samples;
+    {
+        QMutexLocker locker(&inputMutex);
+        samples.swap(input);
+        processPending = false;
+    }
+
+    QVector<double> row(rowWidth);
+    for (int i = 0; i < samples.size(); i++) {
+        frame.append(samples.at(i));
+        samplesSinceRow++;
+
+        if (frame.size() < (int) frameSize || samplesSinceRow < hopSize)
+            continue;
+        samplesSinceRow = 0;
+
+        computeRow(frame.data(), row.data());
+
+        QMutexLocker locker(&outputMutex);
+        output += row;
+    }
+}
+
+
+/**
+ * @brief SpectrogramFFT::computeRow Windows one frame and converts its
+ * spectrum to dB
+ *
+ * The frame of N = 2 * rowWidth real samples is packed into rowWidth complex
+ * samples, even samples in the real part and odd in the imaginary part, so
+ * one half-length complex FFT does the work. The even and odd spectra are
+ * then separated and recombined into the first rowWidth bins.
+ */
+void SpectrogramFFT::computeRow(const double *samples, double *row)
+{
+    const unsigned int n = frameSize;
+    const unsigned int m = rowWidth;
+
+    for (unsigned int k = 0; k < m; k++) {
+        double xr, xi;
+
+        if (powerOfTwo) {
+            if (k == 0) {
+                for (unsigned int j = 0; j < m; j++) {
+                    re[j] = samples[2 * j] * hannWindow[2 * j];
+                    im[j] = samples[2 * j + 1] * hannWindow[2 * j + 1];
+                }
+                fft(re.data(), im.data(), m);
+            }
+
+            // Z[k] and conj(Z[m - k])
+            const unsigned int mk = (m - k) % m;
+            const double ar = re[k], ai = im[k];
+            const double br = re[mk], bi = -im[mk];
+
+            // Even = (Z[k] + conj(Z[m - k])) / 2, odd = (Z[k] - conj(Z[m - k])) / 2i
+            const double er = (ar + br) / 2, ei = (ai + bi) / 2;
+            const double or_ = (ai - bi) / 2, oi = -(ar - br) / 2;
+
+            const double angle = -2 * M_PI * k / n;
+            const double c = cos(angle), s = sin(angle);
+            xr = er + or_ * c - oi * s;
+            xi = ei + or_ * s + oi * c;
+        } else {
+            // Plain DFT for row widths the FFT cannot split
+            xr = 0;
+            xi = 0;
+            for (unsigned int j = 0; j < n; j++) {
+                const double angle = -2 * M_PI * k * j / n;
+                const double v = samples[j] * hannWindow[j];
+                xr += v * cos(angle);
+                xi += v * sin(angle);
+            }
+        }
+
+        // Single sided amplitude, corrected for the window
+        double magnitude = sqrt(xr * xr + xi * xi) / windowGain;
+        if (k > 0)
+            magnitude *= 2;
+
+        double db = magnitude > 0 ? 20 * log10(magnitude) - DB_FLOOR : 0;
+        row[k] = qMax(db, 0.0);
+    }
+}
+
+
+/**
+ * @brief SpectrogramFFT::fft In place iterative radix-2 complex FFT
+ * @param n Length, a power of two
+ */
+void SpectrogramFFT::fft(double *re, double *im, unsigned int n)
+{
+    // Bit reversal permutation
+    for (unsigned int i = 1, j = 0; i < n; i++) {
+        unsigned int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+
+        if (i < j) {
+            qSwap(re[i], re[j]);
+            qSwap(im[i], im[j]);
+        }
+    }
+
+    for (unsigned int len = 2; len <= n; len <<= 1) {
+        const double angle = -2 * M_PI / len;
+        const double wr = cos(angle), wi = sin(angle);
+
+        for (unsigned int i = 0; i < n; i += len) {
+            double cr = 1, ci = 0;
+            for (unsigned int j = 0; j < len / 2; j++) {
+                const unsigned int a = i + j, b = i + j + len / 2;
+                const double tr = re[b] * cr - im[b] * ci;
+                const double ti = re[b] * ci + im[b] * cr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+
+                const double nextCr = cr * wr - ci * wi;
+                ci = cr * wi + ci * wr;
+                cr = nextCr;
+            }
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrogramfft.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Computes spectrogram rows from a scalar sample stream
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SPECTROGRAMFFT_H
+#define SPECTROGRAMFFT_H
+
+#include "plotringbuffer.h"
+
+#include <QObject>
+#include <QMutex>
+#include <QVector>
+
+/**
+ * @brief The SpectrogramFFT class turns a stream of samples into spectrogram
+ * rows. Samples are framed into windows of twice the row width, overlapped,
+ * Hann windowed and transformed with a real FFT. Each row holds the bin
+ * magnitudes from DC up to just below Nyquist, in dB above a fixed floor.
+ *
+ * The object is meant to live in a worker thread. addSample() and takeRows()
+ * may be called from any thread; the transform runs in processSamples().
+ */
+class SpectrogramFFT : public QObject
+{
+    Q_OBJECT
+public:
+    SpectrogramFFT(unsigned int rowWidth, double overlap = 0.5);
+
+    void addSample(double value);
+    int takeRows(QVector<double> &rows);
+
+    unsigned int getRowWidth() const { return rowWidth; }
+    unsigned int getHopSize() const { return hopSize; }
+
+    //! Magnitudes are shown in dB above this level, which maps to zero
+    static const double DB_FLOOR;
+
+public slots:
+    void processSamples();
+
+private:
+    void computeRow(const double *samples, double *row);
+    void fft(double *re, double *im, unsigned int n);
+
+    unsigned int rowWidth;
+    unsigned int frameSize;
+    unsigned int hopSize;
+    bool powerOfTwo;
+
+    // Shared between the producer and the worker thread
+    QMutex inputMutex;
+    QVector<double> input;
+    bool processPending;
+
+    QMutex outputMutex;
+    QVector<double> output;
+
+    // Worker thread only
+    PlotRingBuffer<double> frame;
+    unsigned int samplesSinceRow;
+    QVector<double> hannWindow;
+    double windowGain;
+    QVector<double> re;
+    QVector<double> im;
+};
+
+#endif // SPECTROGRAMFFT_H
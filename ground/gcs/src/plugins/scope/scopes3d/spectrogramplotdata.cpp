@@ -36,7 +36,6 @@
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_color_map.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
 #include "qwt/src/qwt_scale_draw.h"
 #include "qwt/src/qwt_scale_widget.h"
@@ -53,7 +52,9 @@
 SpectrogramData::SpectrogramData(QString uavObject, QString uavField, double samplingFrequency, unsigned int windowWidth, double timeHorizon)
         : Plot3dData(uavObject, uavField),
           spectrogram(0),
-          rasterData(0)
+          rasterData(0),
+          fftThread(0),
+          fft(0)
 {
     this->samplingFrequency = samplingFrequency;
     this->timeHorizon = timeHorizon;
@@ -61,12 +62,42 @@ SpectrogramData::SpectrogramData(QString uavObject, QString uavField, double sam
     autoscaleValueUpdated = 0;
 
     // Create raster data
-    rasterData = new QwtMatrixRasterData();
-
-    rasterData->setValueMatrix( *zDataHistory, windowWidth );
+    rasterData = new RingBufferRasterData(zDataHistory, windowWidth);
 
     // Set the ranges for the plot
     resetAxisRanges();
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    Q_ASSERT(pm != NULL);
+    objManager = pm->getObject<UAVObjectManager>();
+    Q_ASSERT(objManager != NULL);
+}
+
+
+SpectrogramData::~SpectrogramData()
+{
+    if (fftThread) {
+        fftThread->quit();
+        fftThread->wait();
+        delete fft;
+        delete fftThread;
+    }
+}
+
+
+/**
+ * @brief SpectrogramData::enableFFT Starts the worker thread that turns the
+ * bound field into spectrogram rows, one row per window hop
+ */
+void SpectrogramData::enableFFT()
+{
+    if (fft)
+        return;
+
+    fft = new SpectrogramFFT(windowWidth);
+    fftThread = new QThread();
+    fft->moveToThread(fftThread);
+    fftThread->start();
 }
 
 void SpectrogramData::setXMaximum(double val)
@@ -108,10 +139,27 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
 
     removeStaleData();
 
+    // Collect the rows the worker finished since the last refresh. They are
+    // spread back in time by one hop each, ending now.
+    if (fft) {
+        QVector<double> rows;
+        int numRows = fft->takeRows(rows);
+        if (numRows > 0) {
+            QDateTime NOW = QDateTime::currentDateTime();
+            double now = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+            double hopTime = samplingFrequency > 0 ? fft->getHopSize() / samplingFrequency : 0;
+
+            for (int i = 0; i < numRows; i++)
+                appendRow(rows.constData() + i * windowWidth, now - (numRows - 1 - i) * hopTime);
+
+            setUpdatedFlagToTrue();
+        }
+    }
+
     // Check for new data
     if (readAndResetUpdatedFlag() == true){
-        // Plot new data
-        rasterData->setValueMatrix(*zDataHistory, windowWidth);
+        // The raster reads zDataHistory in place, so only the cached image is stale
+        spectrogram->invalidateCache();
 
         // Check autoscale. (For some reason, QwtSpectrogram doesn't support autoscale)
         if (zMaximum == 0){
@@ -135,26 +183,25 @@ bool SpectrogramData::append(UAVObject* multiObj)
     QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
 
     // Check to make sure it's the correct UAVO
-    if (uavObjectName == multiObj->getName()) {
+    if (multiObj->getObjID() == objectId) {
+
+        // A single field feeds the FFT. Rows are picked up in plotNewData(),
+        // so this sample alone does not update the plot.
+        if (fft) {
+            fft->addSample(boundValue(multiObj));
+            return false;
+        }
 
         // Only run on UAVOs that have multiple instances
         if (multiObj->isSingleInstance())
             return false;
 
-        //Instantiate object manager
-        UAVObjectManager *objManager;
-
-        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-        Q_ASSERT(pm != NULL);
-        objManager = pm->getObject<UAVObjectManager>();
-        Q_ASSERT(objManager != NULL);
-
-
-        // Get list of object instances
-        QVector<UAVObject*> list = objManager->getObjectInstances(multiObj->getName());
+        // Get list of object instances. Once every instance exists the list
+        // no longer changes, so it is kept rather than fetched per update.
+        if (instances.size() != (int) windowWidth)
+            instances = objManager->getObjectInstances(objectId);
 
-        // Remove a row's worth of data.
-        unsigned int spectrogramWidth = list.size();
+        unsigned int spectrogramWidth = instances.size();
 
         // Check that there is a full window worth of data. While GCS is starting up, the size of
         // multiple instance UAVOs is 1, so it's possible for spurious data to come in before
@@ -164,52 +211,47 @@ bool SpectrogramData::append(UAVObject* multiObj)
             return false;
         }
 
-        //Initialize vector where we will read out an entire row of multiple instance UAVO
-        QVector<double> values;
+        // Read the bound field from each instance
+        QVector<double> values(windowWidth);
+        for (unsigned int i = 0; i < windowWidth; i++)
+            values[i] = boundValue(instances.at(i));
 
-        timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-        UAVObjectField* multiField =  multiObj->getField(uavFieldName);
-        Q_ASSERT(multiField);
-        if (multiField ) {
+        appendRow(values.constData(), NOW.toTime_t() + NOW.time().msec() / 1000.0);
 
-            // Get the field of interest
-            foreach (UAVObject *obj, list) {
-                UAVObjectField* field =  obj->getField(uavFieldName);
-
-                double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
+        return true;
+    }
 
-                double vecVal = currentValue;
-                //Normally some math would go here, modifying vecVal before appending it to values
-                // .
-                // .
-                // .
+    return false;
+}
 
 
-                // Second to last step, see if autoscale is turned on and if the value exceeds the maximum for the scope.
-                if ( zMaximum == 0 &&  vecVal > rasterData->interval(Qt::ZAxis).maxValue()){
-                    // Change scope maximum and color depth
-                    rasterData->setInterval(Qt::ZAxis, QwtInterval(0, vecVal) );
-                    autoscaleValueUpdated = vecVal;
-                }
-                // Last step, assign value to vector
-                values += vecVal;
-            }
-
-            while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon){
-                timeDataHistory->pop_front();
-                zDataHistory->remove(0, fminl(spectrogramWidth, zDataHistory->size()));
+/**
+ * @brief SpectrogramData::appendRow Adds one row of windowWidth values to the
+ * raster and drops the rows older than the time horizon
+ * @param values The row
+ * @param time Time of the row in seconds
+ */
+void SpectrogramData::appendRow(const double *values, double time)
+{
+    // See if autoscale is turned on and if a value exceeds the maximum for the scope.
+    if (zMaximum == 0) {
+        for (unsigned int i = 0; i < windowWidth; i++) {
+            if (values[i] > rasterData->interval(Qt::ZAxis).maxValue()) {
+                // Change scope maximum and color depth
+                rasterData->setInterval(Qt::ZAxis, QwtInterval(0, values[i]));
+                autoscaleValueUpdated = values[i];
             }
+        }
+    }
 
-            // Doublecheck that there are the right number of samples. This can occur if the "field" assert fails
-            if(values.size() == (int) windowWidth){
-                *zDataHistory << values;
-            }
+    timeDataHistory->append(time);
 
-            return true;
-        }
+    while (timeDataHistory->last() - timeDataHistory->first() > timeHorizon){
+        timeDataHistory->popFront();
+        zDataHistory->popFront(windowWidth);
     }
 
-    return false;
+    zDataHistory->append(values, windowWidth);
 }
 
 
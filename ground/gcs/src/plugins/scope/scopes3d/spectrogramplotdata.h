@@ -29,25 +29,38 @@
 #define SPECTROGRAMDATA_H
 
 #include "scopes3d/plotdata3d.h"
+#include "scopes3d/spectrogramfft.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
 
+#include <QThread>
 #include <QTimer>
 #include <QTime>
 #include <QVector>
 
+class UAVObjectManager;
+
 
 /**
  * @brief The SpectrogramData class The spectrogram plot has a fixed size
  * data buffer. All the curves in one plot have the same size buffer.
+ *
+ * Rows come either from a multiple instance UAVO, one bin per instance, or
+ * from a single field whose spectrum is computed on a worker thread. In
+ * both cases the GUI thread only copies finished rows into the raster.
  */
 class SpectrogramData : public Plot3dData
 {
     Q_OBJECT
 public:
     SpectrogramData(QString uavObject, QString uavField, double samplingFrequency, unsigned int windowWidth, double timeHorizon);
-    ~SpectrogramData() {}
+    ~SpectrogramData();
+
+    /*!
+      \brief Computes the rows from the bound field with an FFT instead of
+      reading them from the instances of a multiple instance UAVO
+      */
+    void enableFFT();
 
     /*!
       \brief Append new data to the plot
@@ -71,19 +84,27 @@ public:
     virtual void setYMaximum(double val);
     virtual void setZMaximum(double val);
 
-    QwtMatrixRasterData *getRasterData(){return rasterData;}
+    RingBufferRasterData *getRasterData(){return rasterData;}
     void setSpectrogram(QwtPlotSpectrogram *val){spectrogram = val;}
 
 private:
     void resetAxisRanges();
+    void appendRow(const double *values, double time);
 
     QwtPlotSpectrogram *spectrogram;
-    QwtMatrixRasterData *rasterData;
+    RingBufferRasterData *rasterData;
 
     double samplingFrequency;
     double timeHorizon;
     unsigned int windowWidth;
     double autoscaleValueUpdated;
+
+    // Instances of the multiple instance UAVO, cached once complete
+    UAVObjectManager *objManager;
+    QVector<UAVObject*> instances;
+
+    QThread *fftThread;
+    SpectrogramFFT *fft;
 };
 
 #endif // SPECTROGRAMDATA_H
@@ -247,6 +247,17 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
         return;
     }
 
+    //Resolve the plotted field once, rather than on every update
+    if(!spectrogramData->bindField(obj)) {
+        qDebug() << "Field " << spectrogramData->getUavoFieldName() << " of " << spectrogramData->getUavoName() << " is missing";
+        delete spectrogramData;
+        return;
+    }
+
+    //A single instance UAVO has no rows of its own, so compute them from the field's spectrum
+    if(obj->isSingleInstance())
+        spectrogramData->enableFFT();
+
     //Get the units
     QString units = getUavObjectFieldUnits(spectrogramData->getUavoName(), spectrogramData->getUavoFieldName());
 
@@ -270,7 +281,7 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
         spectrogramData->timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0 + i);
     }
 
-    if (((double) windowWidth) * timeHorizon < (double) 10000000.0 * sizeof(spectrogramData->zDataHistory->front())){ //Don't exceed 10MB for memory
+    if (((double) windowWidth) * timeHorizon < (double) 10000000.0 * sizeof(spectrogramData->zDataHistory->first())){ //Don't exceed 10MB for memory
         for ( uint i = 0; i < windowWidth*timeHorizon; i++ ){
             spectrogramData->zDataHistory->append(0);
         }
@@ -0,0 +1,397 @@
+/**
+ ******************************************************************************
+ *
+ * @file       streamingstatistics.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Incremental math functions applied to scope samples
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "streamingstatistics.h"
+
+#include <math.h>
+
+
+StreamingStatistics::StreamingStatistics() :
+    m_function(NONE),
+    m_windowSize(1)
+{
+    reset();
+}
+
+
+/**
+ * @brief StreamingStatistics::functionNames Names of the math functions, in
+ * MathFunction order. These are persisted in the scope configuration.
+ */
+QStringList StreamingStatistics::functionNames()
+{
+    QStringList names;
+    names << "None" << "Boxcar average" << "Standard deviation"
+          << "Exponential average" << "Window minimum" << "Window maximum"
+          << "Window median" << "Derivative" << "Integral";
+
+    Q_ASSERT(names.size() == NUM_MATH_FUNCTIONS);
+    return names;
+}
+
+
+StreamingStatistics::MathFunction StreamingStatistics::functionFromName(const QString &name)
+{
+    int index = functionNames().indexOf(name);
+    if (index < 0)
+        return NONE;
+
+    return (MathFunction) index;
+}
+
+
+/**
+ * @brief StreamingStatistics::functionSuffix Text appended to a curve name
+ * to show which function was applied.
+ */
+QString StreamingStatistics::functionSuffix(MathFunction function)
+{
+    switch (function) {
+    case BOXCAR_AVERAGE:
+        return " (avg)";
+    case STANDARD_DEVIATION:
+        return " (std)";
+    case EXPONENTIAL_AVERAGE:
+        return " (ema)";
+    case WINDOW_MINIMUM:
+        return " (min)";
+    case WINDOW_MAXIMUM:
+        return " (max)";
+    case WINDOW_MEDIAN:
+        return " (median)";
+    case DERIVATIVE:
+        return " (d/dt)";
+    case INTEGRAL:
+        return " (integral)";
+    case NONE:
+    default:
+        return "";
+    }
+}
+
+
+/**
+ * @brief StreamingStatistics::usesWindow True if the number of mean samples
+ * is meaningful for this function.
+ */
+bool StreamingStatistics::usesWindow(MathFunction function)
+{
+    switch (function) {
+    case BOXCAR_AVERAGE:
+    case STANDARD_DEVIATION:
+    case EXPONENTIAL_AVERAGE:
+    case WINDOW_MINIMUM:
+    case WINDOW_MAXIMUM:
+    case WINDOW_MEDIAN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+void StreamingStatistics::setFunction(MathFunction function)
+{
+    m_function = function;
+    reset();
+}
+
+
+void StreamingStatistics::setWindowSize(unsigned int windowSize)
+{
+    m_windowSize = qMax(windowSize, 1u);
+    reset();
+}
+
+
+void StreamingStatistics::reset()
+{
+    m_count = 0;
+
+    m_window.clear();
+
+    m_mean = 0;
+    m_m2 = 0;
+    m_ema = 0;
+
+    m_minima.clear();
+    m_maxima.clear();
+
+    m_low = std::priority_queue<double>();
+    m_high = std::priority_queue<double, std::vector<double>, std::greater<double> >();
+    m_delayed.clear();
+    m_lowSize = 0;
+    m_highSize = 0;
+
+    m_previousValue = 0;
+    m_previousTime = 0;
+    m_integral = 0;
+}
+
+
+/**
+ * @brief StreamingStatistics::push Feeds one sample through the selected function
+ * @param value The sample
+ * @param time Time of the sample in seconds. Only used by the derivative and integral.
+ * @return The function output for this sample
+ */
+double StreamingStatistics::push(double value, double time)
+{
+    const bool first = (m_count == 0);
+    m_count++;
+
+    switch (m_function) {
+    case BOXCAR_AVERAGE:
+        pushWindow(value);
+        return windowMean();
+    case STANDARD_DEVIATION:
+        pushWindow(value);
+        return windowStandardDeviation();
+    case EXPONENTIAL_AVERAGE:
+    {
+        const double alpha = 2.0 / (m_windowSize + 1);
+        m_ema = first ? value : m_ema + alpha * (value - m_ema);
+        return m_ema;
+    }
+    case WINDOW_MINIMUM:
+        return windowExtreme(m_minima, value, false);
+    case WINDOW_MAXIMUM:
+        return windowExtreme(m_maxima, value, true);
+    case WINDOW_MEDIAN:
+        pushWindow(value);
+        return windowMedian();
+    case DERIVATIVE:
+    {
+        double derivative = 0;
+        if (!first && time > m_previousTime)
+            derivative = (value - m_previousValue) / (time - m_previousTime);
+        m_previousValue = value;
+        m_previousTime = time;
+        return derivative;
+    }
+    case INTEGRAL:
+        // Trapezoidal rule between consecutive samples
+        if (!first && time > m_previousTime)
+            m_integral += 0.5 * (value + m_previousValue) * (time - m_previousTime);
+        m_previousValue = value;
+        m_previousTime = time;
+        return m_integral;
+    case NONE:
+    default:
+        return value;
+    }
+}
+
+
+/**
+ * @brief StreamingStatistics::pushWindow Slides the window by one sample,
+ * updating the running mean and variance with Welford's method. The running
+ * values are rebuilt from the window once per window length so rounding
+ * errors cannot accumulate.
+ */
+void StreamingStatistics::pushWindow(double value)
+{
+    if (m_window.size() >= (int) m_windowSize) {
+        const double old = m_window.first();
+        m_window.popFront();
+
+        const int n = m_window.size();
+        if (n == 0) {
+            m_mean = 0;
+            m_m2 = 0;
+        } else {
+            const double oldMean = m_mean;
+            m_mean = ((n + 1) * oldMean - old) / n;
+            m_m2 -= (old - oldMean) * (old - m_mean);
+        }
+
+        if (m_function == WINDOW_MEDIAN)
+            medianErase(old);
+    }
+
+    m_window.append(value);
+
+    const double delta = value - m_mean;
+    m_mean += delta / m_window.size();
+    m_m2 += delta * (value - m_mean);
+
+    if (m_function == WINDOW_MEDIAN)
+        medianInsert(value);
+
+    if (m_count % m_windowSize == 0) {
+        const int n = m_window.size();
+        const double *samples = m_window.data();
+
+        double sum = 0;
+        for (int i = 0; i < n; i++)
+            sum += samples[i];
+        m_mean = sum / n;
+
+        m_m2 = 0;
+        for (int i = 0; i < n; i++)
+            m_m2 += (samples[i] - m_mean) * (samples[i] - m_mean);
+
+        // Lazily deleted entries can pile up below the heap tops, so
+        // rebuild the heaps once they hold twice the window
+        if (m_function == WINDOW_MEDIAN && m_low.size() + m_high.size() > 2 * (size_t) n) {
+            m_low = std::priority_queue<double>();
+            m_high = std::priority_queue<double, std::vector<double>, std::greater<double> >();
+            m_delayed.clear();
+            m_lowSize = 0;
+            m_highSize = 0;
+            for (int i = 0; i < n; i++)
+                medianInsert(samples[i]);
+        }
+    }
+}
+
+
+double StreamingStatistics::windowMean()
+{
+    return m_mean;
+}
+
+
+/**
+ * @brief StreamingStatistics::windowStandardDeviation Sample standard
+ * deviation of the window, with Bessel's correction
+ */
+double StreamingStatistics::windowStandardDeviation()
+{
+    const int n = m_window.size();
+    if (n < 2 || m_m2 <= 0)
+        return 0;
+
+    return sqrt(m_m2 / (n - 1));
+}
+
+
+/**
+ * @brief StreamingStatistics::windowExtreme Sliding window minimum or maximum.
+ * The deque holds the samples that can still become the extreme, so its front
+ * is always the answer and each sample is added and removed at most once.
+ */
+double StreamingStatistics::windowExtreme(PlotRingBuffer<WindowSample> &extremes, double value, bool keepMaximum)
+{
+    const quint64 index = m_count - 1;
+
+    while (!extremes.isEmpty() &&
+           (keepMaximum ? extremes.last().value <= value : extremes.last().value >= value))
+        extremes.popBack();
+
+    WindowSample sample;
+    sample.index = index;
+    sample.value = value;
+    extremes.append(sample);
+
+    while (extremes.first().index + m_windowSize <= index)
+        extremes.popFront();
+
+    return extremes.first().value;
+}
+
+
+double StreamingStatistics::windowMedian()
+{
+    if (m_lowSize > m_highSize)
+        return m_low.top();
+
+    return (m_low.top() + m_high.top()) / 2;
+}
+
+
+void StreamingStatistics::medianInsert(double value)
+{
+    if (m_low.empty() || value <= m_low.top()) {
+        m_low.push(value);
+        m_lowSize++;
+    } else {
+        m_high.push(value);
+        m_highSize++;
+    }
+
+    medianRebalance();
+}
+
+
+/**
+ * @brief StreamingStatistics::medianErase Removes a sample that left the
+ * window. It stays in its heap until it reaches the top.
+ */
+void StreamingStatistics::medianErase(double value)
+{
+    m_delayed[value]++;
+
+    if (value <= m_low.top()) {
+        m_lowSize--;
+        if (value == m_low.top())
+            medianPrune(m_low);
+    } else {
+        m_highSize--;
+        if (value == m_high.top())
+            medianPrune(m_high);
+    }
+
+    medianRebalance();
+}
+
+
+/**
+ * @brief StreamingStatistics::medianRebalance Keeps the low heap equal in
+ * size to the high heap, or one larger.
+ */
+void StreamingStatistics::medianRebalance()
+{
+    if (m_lowSize > m_highSize + 1) {
+        m_high.push(m_low.top());
+        m_low.pop();
+        m_lowSize--;
+        m_highSize++;
+        medianPrune(m_low);
+    } else if (m_lowSize < m_highSize) {
+        m_low.push(m_high.top());
+        m_high.pop();
+        m_highSize--;
+        m_lowSize++;
+        medianPrune(m_high);
+    }
+}
+
+
+template <typename Heap>
+void StreamingStatistics::medianPrune(Heap &heap)
+{
+    while (!heap.empty()) {
+        QMap<double, int>::iterator it = m_delayed.find(heap.top());
+        if (it == m_delayed.end())
+            break;
+
+        if (--it.value() == 0)
+            m_delayed.erase(it);
+        heap.pop();
+    }
+}
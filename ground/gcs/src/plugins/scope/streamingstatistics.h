@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ *
+ * @file       streamingstatistics.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Incremental math functions applied to scope samples
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef STREAMINGSTATISTICS_H
+#define STREAMINGSTATISTICS_H
+
+#include "plotringbuffer.h"
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+/**
+ * @brief The StreamingStatistics class transforms a stream of samples with
+ * one of the scope math functions. Each function keeps just enough state to
+ * produce its output in O(1) amortized time per sample; the sliding median
+ * is O(log n).
+ *
+ * The function is chosen once, when the curve is configured, so the per
+ * sample path is a switch on an enum rather than string comparisons.
+ */
+class StreamingStatistics
+{
+public:
+    /**
+     * @brief The MathFunction enum lists the functions in the order shown in
+     * the options page. The names returned by functionNames() are what gets
+     * stored in the configuration.
+     */
+    enum MathFunction {
+        NONE,
+        BOXCAR_AVERAGE,
+        STANDARD_DEVIATION,
+        EXPONENTIAL_AVERAGE,
+        WINDOW_MINIMUM,
+        WINDOW_MAXIMUM,
+        WINDOW_MEDIAN,
+        DERIVATIVE,
+        INTEGRAL,
+        NUM_MATH_FUNCTIONS
+    };
+
+    StreamingStatistics();
+
+    static QStringList functionNames();
+    static MathFunction functionFromName(const QString &name);
+    static QString functionSuffix(MathFunction function);
+    static bool usesWindow(MathFunction function);
+
+    void setFunction(MathFunction function);
+    void setWindowSize(unsigned int windowSize);
+    MathFunction getFunction() const { return m_function; }
+
+    double push(double value, double time);
+    void reset();
+
+private:
+    struct WindowSample {
+        quint64 index;
+        double value;
+    };
+
+    void pushWindow(double value);
+    double windowMean();
+    double windowStandardDeviation();
+    double windowExtreme(PlotRingBuffer<WindowSample> &extremes, double value, bool keepMaximum);
+    double windowMedian();
+
+    void medianInsert(double value);
+    void medianErase(double value);
+    void medianRebalance();
+    template <typename Heap> void medianPrune(Heap &heap);
+
+    MathFunction m_function;
+    unsigned int m_windowSize;
+    quint64 m_count;
+
+    // Sliding window, shared by all windowed functions
+    PlotRingBuffer<double> m_window;
+
+    // Welford running mean and sum of squared deviations over the window
+    double m_mean;
+    double m_m2;
+
+    // Exponential moving average
+    double m_ema;
+
+    // Monotonic deques of window candidates for the minimum and maximum
+    PlotRingBuffer<WindowSample> m_minima;
+    PlotRingBuffer<WindowSample> m_maxima;
+
+    // Two-heap sliding median with lazy deletion
+    std::priority_queue<double> m_low;
+    std::priority_queue<double, std::vector<double>, std::greater<double> > m_high;
+    QMap<double, int> m_delayed;
+    int m_lowSize;
+    int m_highSize;
+
+    // Previous sample for the derivative and integral
+    double m_previousValue;
+    double m_previousTime;
+    double m_integral;
+};
+
+#endif // STREAMINGSTATISTICS_H
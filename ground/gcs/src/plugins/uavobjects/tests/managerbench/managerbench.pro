@@ -0,0 +1,23 @@
+# Benchmarks the UAVObjectManager lookups. Not part of the default build:
+#   qmake managerbench.pro && make && ./managerbench
+CONFIG += qtestlib
+TEMPLATE = app
+CONFIG -= app_bundle
+
+QT -= gui
+
+DEFINES += UAVOBJECTS_LIBRARY
+INCLUDEPATH += ../..
+
+HEADERS += ../../uavobject.h \
+    ../../uavdataobject.h \
+    ../../uavmetaobject.h \
+    ../../uavobjectfield.h \
+    ../../uavobjectmanager.h
+
+SOURCES += ../../uavobject.cpp \
+    ../../uavdataobject.cpp \
+    ../../uavmetaobject.cpp \
+    ../../uavobjectfield.cpp \
+    ../../uavobjectmanager.cpp \
+    tst_managerbench.cpp
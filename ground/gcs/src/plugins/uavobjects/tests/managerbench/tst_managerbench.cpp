@@ -0,0 +1,212 @@
+/**
+******************************************************************************
+*
+* @file       tst_managerbench.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+* @brief      Benchmarks looking up objects in the UAVObjectManager
+* @see        The GNU Public License (GPL) Version 3
+* @addtogroup GCSPlugins GCS Plugins
+* @{
+* @addtogroup UAVObjectsPlugin UAVObjects Plugin
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include "uavobjectmanager.h"
+
+#include <QtTest/QtTest>
+
+// Each object type takes two IDs, the second one is its metaobject
+static const quint32 FirstObjId=0x10000000;
+static const int Instances=16;
+
+/**
+ * Stands in for a generated object: a single field and nothing else, so
+ * only the manager is measured.
+ */
+class BenchObject:public UAVDataObject
+{
+    Q_OBJECT
+public:
+    BenchObject(quint32 objId,const QString &name,bool singleInst)
+        :UAVDataObject(objId,singleInst,false,name)
+    {
+        QList<UAVObjectField*> fields;
+        fields.append(new UAVObjectField("Value","",UAVObjectField::UINT32,1,QStringList()));
+        initializeFields(fields,(quint8*)&value,sizeof(value));
+    }
+    Metadata getDefaultMetadata()
+    {
+        Metadata metadata;
+        UAVObject::MetadataInitialize(metadata);
+        return metadata;
+    }
+    UAVDataObject* clone(quint32 instID)
+    {
+        BenchObject *obj=new BenchObject(getObjID(),getName(),isSingleInstance());
+        obj->initialize(instID,getMetaObject());
+        return obj;
+    }
+    UAVDataObject* dirtyClone()
+    {
+        return new BenchObject(getObjID(),getName(),isSingleInstance());
+    }
+private:
+    quint32 value;
+};
+
+/**
+ * Queries the manager from a newObject() slot, like the telemetry does when
+ * it connects to the instances of a new object.
+ */
+class InstanceCounter:public QObject
+{
+    Q_OBJECT
+public:
+    InstanceCounter(UAVObjectManager *objMngr):objMngr(objMngr),seen(0){}
+    UAVObjectManager *objMngr;
+    int seen;
+public slots:
+    void newObject(UAVObject *obj)
+    {
+        seen+=objMngr->getObjectInstances(obj->getObjID()).size();
+    }
+};
+
+class tst_ManagerBench:public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+    void slotsCanQuery();
+    void getObjectById_data();
+    void getObjectById();
+    void getObjectByName_data();
+    void getObjectByName();
+    void getNumInstances_data();
+    void getNumInstances();
+private:
+    void registerTypes(int types);
+    void addTypes();
+    static QString typeName(int type);
+    UAVObjectManager *objMngr;
+};
+
+QString tst_ManagerBench::typeName(int type)
+{
+    return QString("BenchObject%1").arg(type);
+}
+
+/**
+ * Registers single instance types, plus one multi instance type per ten
+ * like the waypoints
+ */
+void tst_ManagerBench::registerTypes(int types)
+{
+    for(int type=0;type<types;type++)
+    {
+        bool multi=(type%10==0);
+        QVERIFY(objMngr->registerObject(new BenchObject(FirstObjId+2*type,typeName(type),!multi)));
+        for(int inst=1;multi&&inst<Instances;inst++)
+            QVERIFY(objMngr->registerObject(new BenchObject(FirstObjId+2*type,typeName(type),false)));
+    }
+}
+
+/**
+ * The lookup cost should not grow with the number of registered types
+ */
+void tst_ManagerBench::addTypes()
+{
+    QTest::addColumn<int>("types");
+    QTest::newRow("10 types")<<10;
+    QTest::newRow("100 types")<<100;
+    QTest::newRow("1000 types")<<1000;
+}
+
+void tst_ManagerBench::init()
+{
+    objMngr=new UAVObjectManager();
+}
+
+void tst_ManagerBench::cleanup()
+{
+    delete objMngr;
+}
+
+void tst_ManagerBench::slotsCanQuery()
+{
+    InstanceCounter counter(objMngr);
+    connect(objMngr,SIGNAL(newObject(UAVObject*)),&counter,SLOT(newObject(UAVObject*)));
+    registerTypes(2);
+    // Each type and its metaobject held one instance when it was announced
+    QCOMPARE(counter.seen,4);
+}
+
+void tst_ManagerBench::getObjectById_data()
+{
+    addTypes();
+}
+
+void tst_ManagerBench::getObjectById()
+{
+    QFETCH(int,types);
+    registerTypes(types);
+    const quint32 last=FirstObjId+2*(types-1);
+    QVERIFY(objMngr->getObject(last)!=NULL);
+    QVERIFY(objMngr->getObject(FirstObjId,Instances-1)!=NULL);
+    QBENCHMARK {
+        objMngr->getObject(last);
+        objMngr->getObject(FirstObjId,Instances-1);
+    }
+}
+
+void tst_ManagerBench::getObjectByName_data()
+{
+    addTypes();
+}
+
+void tst_ManagerBench::getObjectByName()
+{
+    QFETCH(int,types);
+    registerTypes(types);
+    const QString last=typeName(types-1);
+    QVERIFY(objMngr->getObject(last)!=NULL);
+    QBENCHMARK {
+        objMngr->getObject(last);
+    }
+}
+
+void tst_ManagerBench::getNumInstances_data()
+{
+    addTypes();
+}
+
+void tst_ManagerBench::getNumInstances()
+{
+    QFETCH(int,types);
+    registerTypes(types);
+    QCOMPARE(objMngr->getNumInstances(FirstObjId),Instances);
+    QBENCHMARK {
+        objMngr->getNumInstances(FirstObjId);
+    }
+}
+
+QTEST_MAIN(tst_ManagerBench)
+
+#include "tst_managerbench.moc"
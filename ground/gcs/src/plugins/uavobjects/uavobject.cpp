@@ -257,6 +257,27 @@ UAVObjectField* UAVObject::getField(const QString& name)
     return NULL;
 }
 
+/**
+ * Copy the raw object data in one go, for reading several fields
+ * consistently with UAVObjectField::getFromSnapshot() without locking
+ * the object for every element.
+ * @param snapshot Buffer of at least getNumBytes() bytes
+ */
+void UAVObject::getSnapshot(quint8* snapshot)
+{
+    QMutexLocker locker(mutex);
+    memcpy(snapshot, data, numBytes);
+}
+
+/**
+ * Copy the raw object data into a new byte array
+ */
+QByteArray UAVObject::getSnapshot()
+{
+    QMutexLocker locker(mutex);
+    return QByteArray((const char*)data, numBytes);
+}
+
 /**
  * Pack the object data into a byte array
  * @returns The number of bytes copied
@@ -264,6 +285,11 @@ UAVObjectField* UAVObject::getField(const QString& name)
 qint32 UAVObject::pack(quint8* dataOut)
 {
     QMutexLocker locker(mutex);
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // The fields are laid out back to back in the data buffer, so on a little
+    // endian host it already holds the packed object
+    memcpy(dataOut, data, numBytes);
+#else
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
@@ -271,6 +297,7 @@ qint32 UAVObject::pack(quint8* dataOut)
         field->pack(&dataOut[offset]);
         offset += field->getNumBytes();
     }
+#endif
     return numBytes;
 }
 
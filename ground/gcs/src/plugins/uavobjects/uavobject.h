@@ -109,6 +109,8 @@ public:
     quint32 getNumBytes(); 
     qint32 pack(quint8* dataOut);
     qint32 unpack(const quint8* dataIn);
+    void getSnapshot(quint8* snapshot);
+    QByteArray getSnapshot();
     bool save();
     bool save(QFile& file);
     bool load();
@@ -1036,7 +1036,17 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
 
 double UAVObjectField::getDouble(quint32 index)
 {
-    return getValue(index).toDouble();
+    // Enums and strings keep converting their text
+    if (type == ENUM || type == STRING)
+    {
+        return getValue(index).toDouble();
+    }
+    return get<double>(index);
+}
+
+QMutex* UAVObjectField::getObjectMutex()
+{
+    return obj->getMutex();
 }
 
 void UAVObjectField::setDouble(double value, quint32 index)
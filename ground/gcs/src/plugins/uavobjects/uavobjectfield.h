@@ -34,6 +34,8 @@
 #include <QVariant>
 #include <QList>
 #include <QMap>
+#include <QMutexLocker>
+#include <string.h>
 
 class UAVObject;
 
@@ -68,6 +70,9 @@ public:
     bool checkValue(const QVariant& data, quint32 index = 0);
     void setValue(const QVariant& data, quint32 index = 0);
     double getDouble(quint32 index = 0);
+    template <typename T> T get(quint32 index = 0);
+    template <typename T> quint32 getElements(T* values, quint32 maxElements);
+    template <typename T> T getFromSnapshot(const quint8* snapshot, quint32 index = 0);
     void setDouble(double value, quint32 index = 0);
     quint32 getDataOffset();
     quint32 getNumBytes();
@@ -96,8 +101,107 @@ protected:
     void clear();
     void constructorInitialize(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QString &limits);
     void limitsInitialize(const QString &limits);
+    QMutex* getObjectMutex();
+    template <typename T> T elementAs(const quint8* base, quint32 index);
 
 
 };
 
+/**
+ * Get an element converted to T without going through a QVariant. Enums give
+ * the option index and strings are not supported (T() is returned).
+ */
+template <typename T>
+T UAVObjectField::get(quint32 index)
+{
+    QMutexLocker locker(getObjectMutex());
+    if ( index >= numElements )
+    {
+        return T();
+    }
+    return elementAs<T>(data, index);
+}
+
+/**
+ * Get all the elements converted to T, locking the object only once
+ * @returns The number of elements copied
+ */
+template <typename T>
+quint32 UAVObjectField::getElements(T* values, quint32 maxElements)
+{
+    QMutexLocker locker(getObjectMutex());
+    quint32 count = qMin(numElements, maxElements);
+    for (quint32 index = 0; index < count; ++index)
+    {
+        values[index] = elementAs<T>(data, index);
+    }
+    return count;
+}
+
+/**
+ * Get an element from a copy of the object data made by UAVObject::getSnapshot()
+ */
+template <typename T>
+T UAVObjectField::getFromSnapshot(const quint8* snapshot, quint32 index)
+{
+    if ( index >= numElements )
+    {
+        return T();
+    }
+    return elementAs<T>(snapshot, index);
+}
+
+template <typename T>
+T UAVObjectField::elementAs(const quint8* base, quint32 index)
+{
+    const quint8* element = &base[offset + numBytesPerElement*index];
+    switch (type)
+    {
+    case INT8:
+    {
+        qint8 tmpint8;
+        memcpy(&tmpint8, element, sizeof(tmpint8));
+        return static_cast<T>(tmpint8);
+    }
+    case INT16:
+    {
+        qint16 tmpint16;
+        memcpy(&tmpint16, element, sizeof(tmpint16));
+        return static_cast<T>(tmpint16);
+    }
+    case INT32:
+    {
+        qint32 tmpint32;
+        memcpy(&tmpint32, element, sizeof(tmpint32));
+        return static_cast<T>(tmpint32);
+    }
+    case UINT8:
+    case ENUM:
+        return static_cast<T>(*element);
+    case UINT16:
+    {
+        quint16 tmpuint16;
+        memcpy(&tmpuint16, element, sizeof(tmpuint16));
+        return static_cast<T>(tmpuint16);
+    }
+    case UINT32:
+    {
+        quint32 tmpuint32;
+        memcpy(&tmpuint32, element, sizeof(tmpuint32));
+        return static_cast<T>(tmpuint32);
+    }
+    case FLOAT32:
+    {
+        float tmpfloat;
+        memcpy(&tmpfloat, element, sizeof(tmpfloat));
+        return static_cast<T>(tmpfloat);
+    }
+    case BITFIELD:
+        return static_cast<T>((base[offset + numBytesPerElement*(index/8)] >> (index % 8)) & 1);
+    case STRING:
+        break;
+    }
+    return T();
+}
+
 #endif // UAVOBJECTFIELD_H
@@ -32,12 +32,12 @@
  */
 UAVObjectManager::UAVObjectManager()
 {
-    mutex = new QMutex(QMutex::Recursive);
+    lock = new QReadWriteLock();
 }
 
 UAVObjectManager::~UAVObjectManager()
 {
-    delete mutex;
+    delete lock;
 }
 
 /**
@@ -45,16 +45,20 @@ UAVObjectManager::~UAVObjectManager()
  * A new instance can be created directly by instantiating a new object or by calling clone() of
  * an existing object. The object will be registered and will be properly initialized so that it can accept
  * updates.
+ * The newObject() and newInstance() signals are emitted once the lock is released, so connected
+ * slots are free to query the manager.
  */
 bool UAVObjectManager::registerObject(UAVDataObject* obj)
 {
-    QMutexLocker locker(mutex);
-    // Check if this object type is already in the list
-    quint32 objID = obj->getObjID();
-    for (int objidx = 0; objidx < objects.size(); ++objidx)
+    QList<UAVObject*> addedObjects;
+    QList<UAVDataObject*> addedInstances;
+    UAVDataObject* refObj = NULL;
     {
-        // Check if the object ID is in the list
-        if (objects[objidx].size() > 0 && objects[objidx][0]->getObjID() == objID)
+        QWriteLocker locker(lock);
+        // Check if this object type is already in the list
+        quint32 objID = obj->getObjID();
+        int objidx = typeIndex.value(objID, -1);
+        if (objidx >= 0)
         {
             // Check if this is a single instance object, if yes we can not add a new instance
             if (obj->isSingleInstance())
@@ -64,7 +68,7 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
             // The object type has alredy been added, so now we need to initialize the new instance with the appropriate id
             // There is a single metaobject for all object instances of this type, so no need to create a new one
             // Get object type metaobject from existing instance
-            UAVDataObject* refObj = dynamic_cast<UAVDataObject*>(objects[objidx][0]);
+            refObj = dynamic_cast<UAVDataObject*>(objects[objidx][0]);
             if (refObj == NULL)
             {
                 return false;
@@ -75,13 +79,10 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
             // will be created.
             if ( (obj->getInstID() > 0) && (obj->getInstID() < MAX_INSTANCES) )
             {
-                for (int instidx = 0; instidx < objects[objidx].size(); ++instidx)
+                if (instanceIndex.contains(instanceKey(objID, obj->getInstID())))
                 {
-                    if ( objects[objidx][instidx]->getInstID() == obj->getInstID() )
-                    {
-                        // Instance conflict, do not add
-                        return false;
-                    }
+                    // Instance conflict, do not add
+                    return false;
                 }
                 // Check if there are any gaps between the requested instance ID and the ones in the list,
                 // if any then create the missing instances.
@@ -89,9 +90,8 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
                 {
                     UAVDataObject* cobj = obj->clone(instidx);
                     cobj->initialize(mobj);
-                    objects[objidx].append(cobj);
-                    getObject(cobj->getObjID())->emitNewInstance(cobj);
-                    emit newInstance(cobj);
+                    addInstance(objidx, cobj);
+                    addedInstances.append(cobj);
                 }
                 // Finally, initialize the actual object instance
                 obj->initialize(mobj);
@@ -106,33 +106,76 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
                 return false;
             }
             // Add the actual object instance in the list
-            objects[objidx].append(obj);
-            getObject(objID)->emitNewInstance(obj);
-            emit newInstance(obj);
-            return true;
+            addInstance(objidx, obj);
+            addedInstances.append(obj);
+        }
+        else
+        {
+            // If this point is reached then this is the first time this object type (ID) is added in the list
+            // create a new list of the instances, add in the object collection and create the object's metaobject
+            // Create metaobject
+            QString mname = obj->getName();
+            mname.append("Meta");
+            UAVMetaObject* mobj = new UAVMetaObject(objID + 1, mname, obj);
+            // Initialize object
+            obj->initialize(0, mobj);
+            // Add to list
+            addObject(obj);
+            addObject(mobj);
+            addedObjects.append(obj);
+            addedObjects.append(mobj);
         }
     }
-    // If this point is reached then this is the first time this object type (ID) is added in the list
-    // create a new list of the instances, add in the object collection and create the object's metaobject
-    // Create metaobject
-    QString mname = obj->getName();
-    mname.append("Meta");
-    UAVMetaObject* mobj = new UAVMetaObject(objID + 1, mname, obj);
-    // Initialize object
-    obj->initialize(0, mobj);
-    // Add to list
-    addObject(obj);
-    addObject(mobj);
+    // Notify with the lock released
+    foreach (UAVObject* added, addedObjects)
+    {
+        emit newObject(added);
+    }
+    foreach (UAVDataObject* added, addedInstances)
+    {
+        refObj->emitNewInstance(added);
+        emit newInstance(added);
+    }
     return true;
 }
 
+/**
+ * Add the first instance of a new object type. Must be called with the write lock held.
+ */
 void UAVObjectManager::addObject(UAVObject* obj)
 {
     // Add to list
     QVector<UAVObject*> list;
     list.append(obj);
     objects.append(list);
-    emit newObject(obj);
+    // Update the indices
+    int objidx = objects.size() - 1;
+    typeIndex.insert(obj->getObjID(), objidx);
+    nameIndex.insert(obj->getName(), objidx);
+    instanceIndex.insert(instanceKey(obj->getObjID(), obj->getInstID()), obj);
+}
+
+/**
+ * Append an instance to an existing object type. Must be called with the write lock held.
+ */
+void UAVObjectManager::addInstance(int objidx, UAVObject* obj)
+{
+    objects[objidx].append(obj);
+    instanceIndex.insert(instanceKey(obj->getObjID(), obj->getInstID()), obj);
+}
+
+/**
+ * Find the index of an object type in the objects list either by name (if not NULL)
+ * or by object ID. Must be called with the lock held.
+ * @returns The index or -1 if the type is not registered
+ */
+int UAVObjectManager::findType(const QString* name, quint32 objId) const
+{
+    if (name != NULL)
+    {
+        return nameIndex.value(*name, -1);
+    }
+    return typeIndex.value(objId, -1);
 }
 
 /**
@@ -141,7 +184,7 @@ void UAVObjectManager::addObject(UAVObject* obj)
  */
 QVector< QVector<UAVObject*> > UAVObjectManager::getObjects()
 {
-    QMutexLocker locker(mutex);
+    QReadLocker locker(lock);
     return objects;
 }
 
@@ -150,7 +193,7 @@ QVector< QVector<UAVObject*> > UAVObjectManager::getObjects()
  */
 QVector< QVector<UAVDataObject*> > UAVObjectManager::getDataObjects()
 {
-    QMutexLocker locker(mutex);
+    QReadLocker locker(lock);
     QVector< QVector<UAVDataObject*> > dObjects;
 
     // Go through objects and copy to new list when types match
@@ -187,7 +230,7 @@ QVector< QVector<UAVDataObject*> > UAVObjectManager::getDataObjects()
  */
 QVector <QVector<UAVMetaObject*> > UAVObjectManager::getMetaObjects()
 {
-    QMutexLocker locker(mutex);
+    QReadLocker locker(lock);
     QVector< QVector<UAVMetaObject*> > mObjects;
 
     // Go through objects and copy to new list when types match
@@ -242,29 +285,19 @@ UAVObject* UAVObjectManager::getObject(quint32 objId, quint32 instId)
  */
 UAVObject* UAVObjectManager::getObject(const QString* name, quint32 objId, quint32 instId)
 {
-    QMutexLocker locker(mutex);
-    // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.size(); ++objidx)
+    QReadLocker locker(lock);
+    if (name != NULL)
     {
-        // Check if the object ID is in the list
-        if (objects[objidx].size() > 0)
+        int objidx = nameIndex.value(*name, -1);
+        if (objidx < 0)
         {
-            if ( (name != NULL && objects[objidx][0]->getName().compare(name) == 0) || (name == NULL && objects[objidx][0]->getObjID() == objId) )
-            {
-                // Look for the requested instance ID
-                for (int instidx = 0; instidx < objects[objidx].size(); ++instidx)
-                {
-                    if (objects[objidx][instidx]->getInstID() == instId)
-                    {
-                        return objects[objidx][instidx];
-                    }
-                }
-            }
+            return NULL;
         }
+        objId = objects[objidx][0]->getObjID();
     }
     //qWarning("UAVObjectManager::getObject: Object not found.  Probably a bug or mismatched GCS/flight versions.");
-    // If this point is reached then the requested object could not be found
-    return NULL;
+    // NULL is returned if the requested object could not be found
+    return instanceIndex.value(instanceKey(objId, instId), NULL);
 }
 
 /**
@@ -288,19 +321,11 @@ QVector<UAVObject*> UAVObjectManager::getObjectInstances(quint32 objId)
  */
 QVector<UAVObject*> UAVObjectManager::getObjectInstances(const QString* name, quint32 objId)
 {
-    QMutexLocker locker(mutex);
-    // Check if this object type is already in the list
-    const QVector< QVector<UAVObject*> >::iterator objectsSize = objects.end();
-    for (QVector< QVector<UAVObject*> >::iterator iter = objects.begin(); iter != objectsSize; ++iter)
+    QReadLocker locker(lock);
+    int objidx = findType(name, objId);
+    if (objidx >= 0)
     {
-        // Check if the object ID is in the list
-        if (iter->size() > 0)
-        {
-            if ( (name != NULL && (*iter)[0]->getName().compare(name) == 0) || (name == NULL && (*iter)[0]->getObjID() == objId) )
-            {
-                return (*iter);
-            }
-        }
+        return objects[objidx];
     }
     // If this point is reached then the requested object could not be found
     return QVector<UAVObject*>();
@@ -327,18 +352,11 @@ qint32 UAVObjectManager::getNumInstances(quint32 objId)
  */
 qint32 UAVObjectManager::getNumInstances(const QString* name, quint32 objId)
 {
-    QMutexLocker locker(mutex);
-    // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.size(); ++objidx)
+    QReadLocker locker(lock);
+    int objidx = findType(name, objId);
+    if (objidx >= 0)
     {
-        // Check if the object ID is in the list
-        if (objects[objidx].size() > 0)
-        {
-            if ( (name != NULL && objects[objidx][0]->getName().compare(name) == 0) || (name == NULL && objects[objidx][0]->getObjID() == objId) )
-            {
-                return objects[objidx].size();
-            }
-        }
+        return objects[objidx].size();
     }
     // If this point is reached then the requested object could not be found
     return -1;
@@ -32,9 +32,9 @@
 #include "uavobject.h"
 #include "uavdataobject.h"
 #include "uavmetaobject.h"
-#include <QMutex>
-#include <QMutexLocker>
+#include <QReadWriteLock>
 #include <QVector>
+#include <QHash>
 
 class UAVOBJECTS_EXPORT UAVObjectManager: public QObject
 {
@@ -63,9 +63,21 @@ private:
     static const quint32 MAX_INSTANCES = 1000;
 
     QVector< QVector<UAVObject*> > objects;
-    QMutex* mutex;
+    QReadWriteLock* lock;
+
+    // Lookup indices into objects, maintained by registerObject() and addObject()
+    QHash<quint32, int> typeIndex;
+    QHash<QString, int> nameIndex;
+    QHash<quint64, UAVObject*> instanceIndex;
+
+    static inline quint64 instanceKey(quint32 objId, quint32 instId)
+    {
+        return (static_cast<quint64>(objId) << 32) | instId;
+    }
 
     void addObject(UAVObject* obj);
+    void addInstance(int objidx, UAVObject* obj);
+    int findType(const QString* name, quint32 objId) const;
     UAVObject* getObject(const QString* name, quint32 objId, quint32 instId);
     QVector<UAVObject*> getObjectInstances(const QString* name, quint32 objId);
     qint32 getNumInstances(const QString* name, quint32 objId);
@@ -119,6 +119,7 @@ HEADERS += $$UAVOBJECT_SYNTHETICS/accels.h \
     $$UAVOBJECT_SYNTHETICS/velocityactual.h \
     $$UAVOBJECT_SYNTHETICS/vibrationanalysisoutput.h \
     $$UAVOBJECT_SYNTHETICS/vibrationanalysissettings.h \
+    $$UAVOBJECT_SYNTHETICS/vibrationanalysissummary.h \
     $$UAVOBJECT_SYNTHETICS/vtolpathfollowersettings.h \
     $$UAVOBJECT_SYNTHETICS/watchdogstatus.h \
     $$UAVOBJECT_SYNTHETICS/waypoint.h \
@@ -222,6 +223,7 @@ SOURCES += $$UAVOBJECT_SYNTHETICS/accels.cpp \
     $$UAVOBJECT_SYNTHETICS/velocityactual.cpp \
     $$UAVOBJECT_SYNTHETICS/vibrationanalysisoutput.cpp \
     $$UAVOBJECT_SYNTHETICS/vibrationanalysissettings.cpp \
+    $$UAVOBJECT_SYNTHETICS/vibrationanalysissummary.cpp \
     $$UAVOBJECT_SYNTHETICS/vtolpathfollowersettings.cpp \
     $$UAVOBJECT_SYNTHETICS/watchdogstatus.cpp \
     $$UAVOBJECT_SYNTHETICS/waypoint.cpp \
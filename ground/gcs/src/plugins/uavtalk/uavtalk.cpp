@@ -59,6 +59,24 @@ const quint8 UAVTalk::crc_table[256] = {
     0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
 };
 
+/**
+ * Tables for checksumming four bytes per step (slicing-by-4). crc_slice_table[k][x]
+ * is the crc of byte x followed by k zero bytes, so that since the crc is linear
+ * the crc of four bytes is the xor of one lookup per byte.
+ */
+quint8 UAVTalk::crc_slice_table[4][256];
+const bool UAVTalk::crc_slice_table_ready = UAVTalk::initCRCSliceTable();
+
+bool UAVTalk::initCRCSliceTable()
+{
+    for (int x = 0; x < 256; x++) {
+        crc_slice_table[0][x] = crc_table[x];
+        for (int k = 1; k < 4; k++)
+            crc_slice_table[k][x] = crc_table[crc_slice_table[k - 1][x]];
+    }
+    return true;
+}
+
 
 /**
  * Constructor
@@ -72,6 +90,9 @@ UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
     rxState = STATE_SYNC;
     rxPacketLength = 0;
 
+    txLength = 0;
+    txFlushPending = false;
+
     mutex = new QMutex(QMutex::Recursive);
 
     memset(&stats, 0, sizeof(ComStats));
@@ -94,6 +115,8 @@ UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
 
 UAVTalk::~UAVTalk()
 {
+    flushTx();
+
     // According to Qt, it is not necessary to disconnect upon
     // object deletion.
     //disconnect(io, SIGNAL(readyRead()), this, SLOT(processInputStream()));
@@ -123,13 +146,10 @@ UAVTalk::ComStats UAVTalk::getStats()
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
-
     if (io && io->isReadable()) {
         while (io->bytesAvailable() > 0)
         {
-            io->read((char*)&tmp, 1);
-            processInputByte(tmp);
+            processInputBuffer(io->readAll());
         }
     }
 }
@@ -199,6 +219,59 @@ bool UAVTalk::objectTransaction(UAVObject* obj, quint8 type, bool allInstances)
     }
 }
 
+/**
+ * Process a chunk of the telemetry stream. This is equivalent to passing each
+ * byte to processInputByte(), but skips straight to the next sync byte and
+ * copies and checksums the object data in blocks.
+ * \param[in] rxbuffer Received bytes
+ */
+void UAVTalk::processInputBuffer(const QByteArray &rxbuffer)
+{
+    const quint8 *data = (const quint8 *)rxbuffer.constData();
+    const quint8 *end = data + rxbuffer.size();
+
+    while (data < end)
+    {
+        if (rxState == STATE_SYNC)
+        {
+            // Discard everything up to the next sync byte
+            const quint8 *sync = (const quint8 *)memchr(data, SYNC_VAL, end - data);
+            if (sync == NULL)
+            {
+                stats.rxBytes += end - data;
+                break;
+            }
+            stats.rxBytes += sync - data;
+            data = sync;
+        }
+        else if (rxState == STATE_DATA)
+        {
+            // Take as much of the object data as this chunk holds
+            qint32 count = qMin<qint32>(end - data, rxLength - rxCount);
+            memcpy(&rxBuffer[rxCount], data, count);
+            rxCS = updateCRC(rxCS, data, count);
+            if(useUDPMirror)
+                rxDataArray.append((const char *)data, count);
+
+            stats.rxBytes += count;
+            rxPacketLength += count;
+            rxCount += count;
+            data += count;
+
+            if (rxCount == rxLength)
+            {
+                rxState = STATE_CS;
+                UAVTALK_QXTLOG_DEBUG("UAVTalk: Data->CSum");
+                rxCount = 0;
+            }
+            continue;
+        }
+
+        // The header and checksum are handled a byte at a time
+        processInputByte(*data++);
+    }
+}
+
 /**
  * Process a byte from the telemetry stream.
  * \param[in] rxbyte Received byte
@@ -660,7 +733,7 @@ bool UAVTalk::transmitObject(UAVObject* obj, quint8 type, bool allInstances)
         {
             // Get number of instances
             quint32 numInst = objMngr->getNumInstances(obj->getObjID());
-            // Send all instances
+            // Send all instances, they are written out together
             for (quint32 instId = 0; instId < numInst; ++instId)
             {
                 UAVObject* inst = objMngr->getObject(obj->getObjID(), instId);
@@ -704,30 +777,24 @@ bool UAVTalk::transmitNack(quint32 objId)
 {
     int dataOffset = 8;
 
-    txBuffer[0] = SYNC_VAL;
-    txBuffer[1] = TYPE_NACK;
-    qToLittleEndian<quint32>(objId, &txBuffer[4]);
-
-    // Calculate checksum
-    txBuffer[dataOffset] = updateCRC(0, txBuffer, dataOffset);
-
-    qToLittleEndian<quint16>(dataOffset, &txBuffer[2]);
-
-    // Send buffer, check that the transmit backlog does not grow above limit
-    if (io && io->isWritable() && io->bytesToWrite() < TX_BUFFER_SIZE )
-    {
-        io->write((const char*)txBuffer, dataOffset+CHECKSUM_LENGTH);
-        if(useUDPMirror)
-        {
-            udpSocketRx->writeDatagram((const char*)txBuffer,dataOffset+CHECKSUM_LENGTH,QHostAddress::LocalHost,udpSocketTx->localPort());
-        }
-    }
-    else
+    // Check that the transmit backlog does not grow above limit
+    quint8* txFrame = reserveTx(dataOffset+CHECKSUM_LENGTH);
+    if (txFrame == NULL)
     {
         ++stats.txErrors;
         return false;
     }
 
+    txFrame[0] = SYNC_VAL;
+    txFrame[1] = TYPE_NACK;
+    qToLittleEndian<quint32>(objId, &txFrame[4]);
+    qToLittleEndian<quint16>(dataOffset, &txFrame[2]);
+
+    // Calculate checksum
+    txFrame[dataOffset] = updateCRC(0, txFrame, dataOffset);
+
+    commitTx(dataOffset+CHECKSUM_LENGTH);
+
     // Update stats
     stats.txBytes += 8+CHECKSUM_LENGTH;
 
@@ -751,84 +818,148 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
     quint16 instId;
     quint16 allInstId = ALL_INSTANCES;
 
+    // Determine header and data length
+    dataOffset = obj->isSingleInstance() ? 8 : 10;
+    if (type == TYPE_OBJ_REQ || type == TYPE_ACK)
+    {
+        length = 0;
+    }
+    else
+    {
+        length = obj->getNumBytes();
+    }
+
+    // Check length
+    if (length >= MAX_PAYLOAD_LENGTH)
+    {
+        return false;
+    }
+
+    // Check that the transmit backlog does not grow above limit
+    quint8* txFrame = reserveTx(dataOffset+length+CHECKSUM_LENGTH);
+    if (txFrame == NULL)
+    {
+        ++stats.txErrors;
+        return false;
+    }
+
     // Setup type and object id fields
     objId = obj->getObjID();
-    txBuffer[0] = SYNC_VAL;
-    txBuffer[1] = type;
-    qToLittleEndian<quint32>(objId, &txBuffer[4]);
+    txFrame[0] = SYNC_VAL;
+    txFrame[1] = type;
+    qToLittleEndian<quint32>(objId, &txFrame[4]);
 
     // Setup instance ID if one is required
-    if ( obj->isSingleInstance() )
-    {
-        dataOffset = 8;
-    }
-    else
+    if ( !obj->isSingleInstance() )
     {
         // Check if all instances are requested
         if (allInstances)
         {
-            qToLittleEndian<quint16>(allInstId, &txBuffer[8]);
+            qToLittleEndian<quint16>(allInstId, &txFrame[8]);
         }
         else
         {
             instId = obj->getInstID();
-            qToLittleEndian<quint16>(instId, &txBuffer[8]);
+            qToLittleEndian<quint16>(instId, &txFrame[8]);
         }
-        dataOffset = 10;
     }
 
-    // Determine data length
-    if (type == TYPE_OBJ_REQ || type == TYPE_ACK)
+    // Pack the data (if any) straight into the frame
+    if (length > 0)
     {
-        length = 0;
+        if ( !obj->pack(&txFrame[dataOffset]) )
+        {
+            return false;
+        }
     }
-    else
+
+    qToLittleEndian<quint16>(dataOffset + length, &txFrame[2]);
+
+    // Calculate checksum
+    txFrame[dataOffset+length] = updateCRC(0, txFrame, dataOffset + length);
+
+    commitTx(dataOffset+length+CHECKSUM_LENGTH);
+
+    // Update stats
+    ++stats.txObjects;
+    stats.txBytes += dataOffset+length+CHECKSUM_LENGTH;
+    stats.txObjectBytes += length;
+
+    // Done
+    return true;
+}
+
+/**
+ * Get space for the next frame at the end of the transmit buffer. Frames
+ * queued in one pass of the event loop, such as all the instances of an object
+ * or a burst of settings, are written to the link together by flushTx().
+ * \param[in] length Frame length, including the checksum
+ * \return Where to build the frame, or NULL if the link is not writable or
+ * its transmit backlog is full
+ */
+quint8* UAVTalk::reserveTx(qint32 length)
+{
+    if (io.isNull() || !io->isWritable())
     {
-        length = obj->getNumBytes();
+        return NULL;
     }
 
-    // Check length
-    if (length >= MAX_PAYLOAD_LENGTH)
+    if (txLength + length > TX_BUFFER_SIZE)
     {
-        return false;
+        flushTx();
     }
 
-    // Copy data (if any)
-    if (length > 0)
+    // Frames not yet written count towards the backlog
+    if (io->bytesToWrite() + txLength >= TX_BUFFER_SIZE)
     {
-        if ( !obj->pack(&txBuffer[dataOffset]) )
-        {
-            return false;
-        }
+        return NULL;
     }
 
-    qToLittleEndian<quint16>(dataOffset + length, &txBuffer[2]);
+    return &txBuffer[txLength];
+}
 
-    // Calculate checksum
-    txBuffer[dataOffset+length] = updateCRC(0, txBuffer, dataOffset + length);
+/**
+ * Add the frame built by reserveTx() to the transmit buffer and make sure
+ * it gets written
+ */
+void UAVTalk::commitTx(qint32 length)
+{
+    txLength += length;
+
+    if (!txFlushPending)
+    {
+        txFlushPending = true;
+        QMetaObject::invokeMethod(this, "flushTx", Qt::QueuedConnection);
+    }
+}
+
+/**
+ * Write out the frames gathered in the transmit buffer with a single write
+ */
+void UAVTalk::flushTx()
+{
+    QMutexLocker locker(mutex);
+    txFlushPending = false;
+
+    if (txLength == 0)
+    {
+        return;
+    }
 
-    // Send buffer, check that the transmit backlog does not grow above limit
-    if (!io.isNull() && io->isWritable() && io->bytesToWrite() < TX_BUFFER_SIZE )
+    if (!io.isNull() && io->isWritable())
     {
-        io->write((const char*)txBuffer, dataOffset+length+CHECKSUM_LENGTH);
+        io->write((const char*)txBuffer, txLength);
         if(useUDPMirror)
         {
-            udpSocketRx->writeDatagram((const char*)txBuffer,dataOffset+length+CHECKSUM_LENGTH,QHostAddress::LocalHost,udpSocketTx->localPort());
+            udpSocketRx->writeDatagram((const char*)txBuffer,txLength,QHostAddress::LocalHost,udpSocketTx->localPort());
         }
     }
     else
     {
         ++stats.txErrors;
-        return false;
     }
 
-    // Update stats
-    ++stats.txObjects;
-    stats.txBytes += dataOffset+length+CHECKSUM_LENGTH;
-    stats.txObjectBytes += length;
-
-    // Done
-    return true;
+    txLength = 0;
 }
 
 /**
@@ -855,6 +986,16 @@ quint8 UAVTalk::updateCRC(quint8 crc, const quint8 data)
 }
 quint8 UAVTalk::updateCRC(quint8 crc, const quint8* data, qint32 length)
 {
+    Q_ASSERT(crc_slice_table_ready);
+
+    // Four bytes per step using the slicing tables, then the remaining bytes one at a time
+    while (length >= 4)
+    {
+        crc = crc_slice_table[3][crc ^ data[0]] ^ crc_slice_table[2][data[1]] ^
+              crc_slice_table[1][data[2]] ^ crc_slice_table[0][data[3]];
+        data += 4;
+        length -= 4;
+    }
     while (length--)
         crc = crc_table[crc ^ *data++];
     return crc;
@@ -62,6 +62,7 @@ public:
     void resetStats();
 
     bool processInputByte(quint8 rxbyte);
+    void processInputBuffer(const QByteArray &rxbuffer);
 
 signals:
     // The only signals we send to the upper level are when we
@@ -72,6 +73,7 @@ signals:
 private slots:
     void processInputStream(void);
     void dummyUDPRead();
+    void flushTx();
 
 protected:
 
@@ -96,8 +98,12 @@ protected:
     static const quint16 ALL_INSTANCES = 0xFFFF;
     static const quint16 OBJID_NOTFOUND = 0x0000;
 
+    // Frames are gathered into one buffer of this size and written together.
+    // It is also the most that may wait to be written before frames are dropped.
     static const int TX_BUFFER_SIZE = 2*1024;
     static const quint8 crc_table[256];
+    static quint8 crc_slice_table[4][256];
+    static const bool crc_slice_table_ready;
 
     // Types
     typedef enum {STATE_SYNC, STATE_TYPE, STATE_SIZE, STATE_OBJID, STATE_INSTID, STATE_DATA, STATE_CS} RxStateType;
@@ -107,7 +113,9 @@ protected:
     UAVObjectManager* objMngr;
     QMutex* mutex;
     quint8 rxBuffer[MAX_PACKET_LENGTH];
-    quint8 txBuffer[MAX_PACKET_LENGTH];
+    quint8 txBuffer[TX_BUFFER_SIZE];
+    qint32 txLength;
+    bool txFlushPending;
     // Variables used by the receive state machine
     quint8 rxTmpBuffer[4];
     quint8 rxType;
@@ -134,8 +142,11 @@ protected:
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject* obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances);
+    quint8* reserveTx(qint32 length);
+    void commitTx(qint32 length);
     quint8 updateCRC(quint8 crc, const quint8 data);
     quint8 updateCRC(quint8 crc, const quint8* data, qint32 length);
+    static bool initCRCSliceTable();
 };
 
 #endif // UAVTALK_H
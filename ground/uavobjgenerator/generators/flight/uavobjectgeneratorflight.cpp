@@ -25,6 +25,7 @@
  */
 
 #include "uavobjectgeneratorflight.h"
+#include <QMap>
 
 using namespace std;
 
@@ -43,13 +44,15 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
     flightIncludeTemplate = readFile( flightCodePath.absoluteFilePath("inc/uavobjecttemplate.h") );
     flightInitTemplate = readFile( flightCodePath.absoluteFilePath("uavobjectsinittemplate.c") );
     flightInitIncludeTemplate = readFile( flightCodePath.absoluteFilePath("inc/uavobjectsinittemplate.h") );
+    flightIndexTemplate = readFile( flightCodePath.absoluteFilePath("uavobjectsindextemplate.c") );
     flightMakeTemplate = readFile( flightCodePath.absoluteFilePath("Makefiletemplate.inc") );
 
-    if ( flightCodeTemplate.isNull() || flightIncludeTemplate.isNull() || flightInitTemplate.isNull()) {
+    if ( flightCodeTemplate.isNull() || flightIncludeTemplate.isNull() || flightInitTemplate.isNull() || flightIndexTemplate.isNull()) {
             cerr << "Error: Could not open flight template files." << endl;
             return false;
         }
 
+    QMap<quint32, QString> objIndex;
     sizeCalc = 0;
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo* info=parser->getObjectByIndex(objidx);
@@ -60,6 +63,7 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
         objInc.append("#include \"" + info->namelc + ".h\"\r\n");
 	objFileNames.append(" " + info->namelc);
 	objNames.append(" " + info->name);
+	objIndex.insert(info->id, info->name);
 	if (parser->getNumBytes(objidx)>sizeCalc) {
 		sizeCalc = parser->getNumBytes(objidx);
 	}
@@ -84,6 +88,22 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
         return false;
     }
 
+    // Write the flight object index, QMap iterates in order of object ID
+    QString objIndexDecl, objIndexEntries;
+    for (QMap<quint32, QString>::const_iterator i = objIndex.constBegin(); i != objIndex.constEnd(); ++i) {
+        objIndexDecl.append("extern UAVObjHandle " + i.value() + "Handle() __attribute__((weak));\r\n");
+        objIndexEntries.append(QString("    { 0x%1, %2Handle },\r\n")
+                               .arg(QString().setNum(i.key(), 16).toUpper()).arg(i.value()));
+    }
+    flightIndexTemplate.replace( QString("$(OBJINDEXDECL)"), objIndexDecl);
+    flightIndexTemplate.replace( QString("$(OBJINDEX)"), objIndexEntries);
+    res = writeFileIfDiffrent( flightOutputPath.absolutePath() + "/uavobjectsindex.c",
+                     flightIndexTemplate );
+    if (!res) {
+        cout << "Error: Could not write flight object index file" << endl;
+        return false;
+    }
+
     // Write the flight object Makefile
     flightMakeTemplate.replace( QString("$(UAVOBJFILENAMES)"), objFileNames);
     flightMakeTemplate.replace( QString("$(UAVOBJNAMES)"), objNames);